@@ -24,6 +24,9 @@
 #ifndef STATICLIB_HTTPSERVER_HPP
 #define	STATICLIB_HTTPSERVER_HPP
 
+#include "staticlib/httpserver/http_canned_response.hpp"
+#include "staticlib/httpserver/http_file_sink.hpp"
+#include "staticlib/httpserver/http_multipart_parser.hpp"
 #include "staticlib/httpserver/http_request.hpp"
 #include "staticlib/httpserver/http_response.hpp"
 #include "staticlib/httpserver/http_response_writer.hpp"
@@ -30,6 +30,7 @@
 #include <sstream>
 #include <string>
 #include <cstdint>
+#include <ctime>
 
 #include "staticlib/httpserver/config.hpp"
 
@@ -97,6 +98,25 @@ namespace algorithm {
      * @throws std::runtime_error on parse error
      */
     uint16_t parse_uint16(const std::string& str);
+
+    /**
+     * Appends decimal representation of specified number to the string,
+     * does not use streams and does not allocate if string has enough capacity
+     * 
+     * @param str string to append to
+     * @param num number to format
+     */
+    void append_decimal(std::string& str, uint64_t num);
+
+    /**
+     * Appends specified time formatted as an HTTP date (RFC 1123,
+     * "Sun, 06 Nov 1994 08:49:37 GMT") to the string, is thread-safe
+     * and does not depend on the current locale
+     * 
+     * @param str string to append to
+     * @param t time to format
+     */
+    void append_http_date(std::string& str, std::time_t t);
     
     /**
      * Trims specified string from left and from right using "std::isspace"
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   buffer_pool.hpp
+ * Author: agent
+ *
+ * Created on October 18, 2026, 7:06 PM
+ */
+
+#ifndef STATICLIB_HTTPSERVER_BUFFER_POOL_HPP
+#define	STATICLIB_HTTPSERVER_BUFFER_POOL_HPP
+
+#include <string>
+
+#include "staticlib/httpserver/config.hpp"
+
+namespace staticlib { 
+namespace httpserver {
+
+/**
+ * Per-thread pool of reusable string buffers for the response serialization,
+ * released buffers keep their capacity so following responses do not
+ * allocate. Buffers may be released on a thread other than the one
+ * they were acquired on.
+ */
+namespace buffer_pool {
+
+    /**
+     * Maximum number of idle buffers kept by the thread
+     */
+    const std::size_t POOL_MAX_SIZE = 64;
+
+    /**
+     * Buffers with larger capacity are freed on release
+     */
+    const std::size_t BUFFER_MAX_CAPACITY = 64 * 1024;
+
+    /**
+     * Takes an empty buffer from the pool of current thread
+     * 
+     * @param capacity minimum capacity to reserve
+     * @return empty buffer
+     */
+    std::string acquire(std::size_t capacity);
+
+    /**
+     * Returns buffer to the pool of current thread
+     * 
+     * @param buf buffer to return, its contents is discarded
+     */
+    void release(std::string&& buf);
+
+} // namespace
+
+} // namespace
+}
+
+#endif	/* STATICLIB_HTTPSERVER_BUFFER_POOL_HPP */
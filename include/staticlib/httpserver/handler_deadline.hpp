@@ -0,0 +1,181 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   handler_deadline.hpp
+ * Author: agent
+ *
+ * Created on October 18, 2026, 10:36 PM
+ */
+
+#ifndef STATICLIB_HTTPSERVER_HANDLER_DEADLINE_HPP
+#define	STATICLIB_HTTPSERVER_HANDLER_DEADLINE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "asio.hpp"
+
+#include "staticlib/httpserver/config.hpp"
+#include "staticlib/httpserver/noncopyable.hpp"
+
+namespace staticlib {
+namespace httpserver {
+
+/**
+ * Cancellation flag shared between the server and the request handler,
+ * handlers may poll it or subscribe to it to stop their work early
+ */
+class cancellation_token : private staticlib::httpserver::noncopyable {
+    /**
+     * Mutex that guards callbacks
+     */
+    std::mutex m_mutex;
+
+    /**
+     * Whether cancellation was requested
+     */
+    std::atomic<bool> m_cancelled;
+
+    /**
+     * Callbacks to run on cancellation
+     */
+    std::vector<std::function<void()>> m_callbacks;
+
+public:
+    /**
+     * Constructor
+     */
+    cancellation_token();
+
+    /**
+     * Returns true if cancellation was requested
+     *
+     * @return whether cancellation was requested
+     */
+    bool is_cancelled() const;
+
+    /**
+     * Registers a callback that is run once in the thread that requests
+     * cancellation, or right away if it is already requested; callback
+     * must not hold the request to not create a reference cycle
+     *
+     * @param callback function to run, must not throw
+     */
+    void subscribe(std::function<void()> callback);
+
+    /**
+     * Requests cancellation and runs subscribed callbacks
+     *
+     * @return false if cancellation was already requested
+     */
+    bool cancel();
+};
+
+/**
+ * Time limit for the handler to start sending the response; when it expires
+ * the token is cancelled and the expiry handler may send its own response,
+ * only one of the handler and the expiry handler is allowed to respond
+ */
+class handler_deadline : public std::enable_shared_from_this<handler_deadline>,
+        private staticlib::httpserver::noncopyable {
+    /**
+     * Token cancelled on expiry
+     */
+    std::shared_ptr<cancellation_token> m_token;
+
+    /**
+     * Timer used to wait for the deadline
+     */
+    asio::steady_timer m_timer;
+
+    /**
+     * Time when deadline expires
+     */
+    std::chrono::steady_clock::time_point m_expiry;
+
+    /**
+     * Current state
+     */
+    std::atomic<int> m_state;
+
+public:
+    /**
+     * Function called when deadline expires before the response is started
+     */
+    using expired_handler_type = std::function<void()>;
+
+    /**
+     * Constructor
+     *
+     * @param io_service IO service used for the timer
+     */
+    explicit handler_deadline(asio::io_service& io_service);
+
+    /**
+     * Starts the timer, expiry handler is held only while the timer is active
+     *
+     * @param timeout time limit for the handler
+     * @param handler function called on expiry, it may send the response
+     */
+    void start(std::chrono::steady_clock::duration timeout, expired_handler_type handler);
+
+    /**
+     * Claims the response for the request handler, stops the timer
+     *
+     * @return false if deadline has already expired and the response must not be sent
+     */
+    bool start_response();
+
+    /**
+     * Returns true if deadline expired before the response was started
+     *
+     * @return whether deadline expired
+     */
+    bool is_expired() const;
+
+    /**
+     * Returns time when deadline expires
+     *
+     * @return expiry time
+     */
+    std::chrono::steady_clock::time_point get_expiry() const;
+
+    /**
+     * Returns token that is cancelled on expiry
+     *
+     * @return cancellation token
+     */
+    const std::shared_ptr<cancellation_token>& get_token() const;
+
+private:
+    /**
+     * Timer callback
+     *
+     * @param ec timer error status code
+     * @param handler function called on expiry
+     */
+    void timer_callback(const asio::error_code& ec, const expired_handler_type& handler);
+};
+
+} // namespace
+}
+
+#endif	/* STATICLIB_HTTPSERVER_HANDLER_DEADLINE_HPP */
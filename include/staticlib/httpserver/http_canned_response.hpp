@@ -0,0 +1,158 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   http_canned_response.hpp
+ * Author: agent
+ *
+ * Created on October 18, 2026, 7:27 PM
+ */
+
+#ifndef STATICLIB_HTTPSERVER_HTTP_CANNED_RESPONSE_HPP
+#define	STATICLIB_HTTPSERVER_HTTP_CANNED_RESPONSE_HPP
+
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "staticlib/httpserver/config.hpp"
+#include "staticlib/httpserver/http_request.hpp"
+#include "staticlib/httpserver/tcp_connection.hpp"
+
+namespace staticlib { 
+namespace httpserver {
+
+/**
+ * Response with the status line, headers and body serialized once on creation,
+ * heads are prepared for both HTTP/1.0 and HTTP/1.1 requests, sending it
+ * copies these bytes into a single pooled buffer without creating response
+ * objects or header maps. Body may contain slots (marked with "{{}}") that
+ * are filled with the values specified on sending, only "Connection",
+ * "Content-Length" and server common headers are added to the serialized
+ * headers for each response.
+ */
+class http_canned_response {
+public:
+    /**
+     * Marker of the slot in body template
+     */
+    static const std::string SLOT_MARKER;
+
+    /**
+     * Type of the slot values list
+     */
+    using slot_values_type = std::initializer_list<std::reference_wrapper<const std::string>>;
+
+    /**
+     * Function called after the response has been written
+     */
+    using finished_handler_type = std::function<void(const asio::error_code&)>;
+
+private:
+    /**
+     * Status line and fixed headers for HTTP/1.1 (and later) requests
+     */
+    std::string m_head_http11;
+
+    /**
+     * Status line and fixed headers for HTTP/1.0 (and earlier) requests
+     */
+    std::string m_head_http10;
+
+    /**
+     * Literal parts of the body between slots
+     */
+    std::vector<std::string> m_body_parts;
+
+    /**
+     * Summary length of the literal body parts
+     */
+    std::size_t m_body_parts_length;
+
+    /**
+     * Whether slot values should be escaped for use inside JSON strings
+     */
+    bool m_escape_slots;
+
+public:
+    /**
+     * Constructor
+     * 
+     * @param status_code HTTP response code
+     * @param status_message HTTP response message
+     * @param content_type value of "Content-Type" header, not sent if empty
+     * @param body_template response body, may contain slot markers
+     * @param escape_slots (optional) whether slot values should be escaped for use
+     *        inside JSON string literals, characters that are special for HTML are
+     *        also escaped, true by default
+     */
+    http_canned_response(unsigned int status_code, const std::string& status_message,
+            const std::string& content_type, const std::string& body_template, bool escape_slots = true);
+
+    /**
+     * Adds a fixed header to the response, must be called before the response is sent
+     * 
+     * @param name header name
+     * @param value header value
+     * @return this instance
+     */
+    http_canned_response& add_header(const std::string& name, const std::string& value);
+
+    /**
+     * Asynchronously sends this response over the connection and finishes
+     * the connection after the write completes, body is not sent
+     * for HEAD requests; nothing is sent if the request handler deadline
+     * has expired, as the timeout response was sent instead
+     * 
+     * @param request request this response is sent for
+     * @param conn TCP connection
+     * @param slot_values values for the slots in body, missing values are treated as empty
+     */
+    void send(const http_request& request, tcp_connection_ptr& conn,
+            slot_values_type slot_values = slot_values_type()) const;
+
+    /**
+     * Asynchronously sends this response over the connection, the connection
+     * is not finished after the write, specified handler must do it;
+     * request handler deadline is not checked
+     * 
+     * @param request request this response is sent for
+     * @param conn TCP connection
+     * @param handler function called after the write completes
+     * @param slot_values values for the slots in body, missing values are treated as empty
+     */
+    void send(const http_request& request, tcp_connection_ptr& conn, finished_handler_type handler,
+            slot_values_type slot_values = slot_values_type()) const;
+
+private:
+    /**
+     * Serializes this response into a pooled buffer
+     * 
+     * @param request request this response is sent for
+     * @param conn TCP connection
+     * @param slot_values values for the slots in body
+     * @return buffer to be written, must be returned to the pool after the write
+     */
+    std::shared_ptr<std::string> render(const http_request& request, tcp_connection_ptr& conn,
+            slot_values_type slot_values) const;
+};
+
+} // namespace
+}
+
+#endif	/* STATICLIB_HTTPSERVER_HTTP_CANNED_RESPONSE_HPP */
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   http_common_headers.hpp
+ * Author: agent
+ *
+ * Created on October 18, 2026, 7:19 PM
+ */
+
+#ifndef STATICLIB_HTTPSERVER_HTTP_COMMON_HEADERS_HPP
+#define	STATICLIB_HTTPSERVER_HTTP_COMMON_HEADERS_HPP
+
+#include <array>
+#include <atomic>
+#include <string>
+#include <cstdint>
+#include <ctime>
+
+#include "staticlib/httpserver/config.hpp"
+#include "staticlib/httpserver/noncopyable.hpp"
+
+namespace staticlib { 
+namespace httpserver {
+
+/**
+ * Precomputed block of headers added to every response: "Date" header
+ * and the fixed headers specified by user (e.g. "Server" or security headers).
+ * "Date" line has a fixed length and is re-rendered once per second by a timer,
+ * it is published under a sequence lock: readers copy it without taking locks
+ * or writing shared memory, and retry if the copy overlapped with an update.
+ */
+class http_common_headers : private staticlib::httpserver::noncopyable {
+    /**
+     * Length of the "Date: <IMF-fixdate>\r\n" line
+     */
+    static const std::size_t DATE_LINE_LENGTH = 37;
+
+    /**
+     * Number of words the "Date" line is stored in
+     */
+    static const std::size_t DATE_WORDS_COUNT = (DATE_LINE_LENGTH + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    /**
+     * Sequence number of the published "Date" line, odd while it is being updated
+     */
+    std::atomic<uint32_t> m_sequence;
+
+    /**
+     * Published "Date" line
+     */
+    std::array<std::atomic<uint64_t>, DATE_WORDS_COUNT> m_date_words;
+
+    /**
+     * Buffer the "Date" line is rendered into, used only by the updater
+     */
+    std::string m_date_line;
+
+    /**
+     * Time of the currently published block
+     */
+    std::atomic<std::time_t> m_current_time;
+
+    /**
+     * Fixed headers, rendered once
+     */
+    std::string m_fixed_headers;
+
+public:
+    /**
+     * Constructor, renders initial block with the current time
+     */
+    http_common_headers();
+
+    /**
+     * Adds a fixed header, must be called before the server is started
+     * 
+     * @param name header name
+     * @param value header value
+     */
+    void add_header(const std::string& name, const std::string& value);
+
+    /**
+     * Renders the block for the specified time and publishes it, does nothing
+     * if the block for this second is already published
+     * 
+     * @param now current time
+     */
+    void update(std::time_t now);
+
+    /**
+     * Appends current block (one or more "Name: value\r\n" lines) to the buffer
+     * 
+     * @param buf buffer to append headers to
+     */
+    void append_to(std::string& buf) const;
+};
+
+} // namespace
+}
+
+#endif	/* STATICLIB_HTTPSERVER_HTTP_COMMON_HEADERS_HPP */
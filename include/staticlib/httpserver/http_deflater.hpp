@@ -0,0 +1,116 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   http_deflater.hpp
+ * Author: agent
+ *
+ * Created on October 18, 2026, 6:56 PM
+ */
+
+#ifndef STATICLIB_HTTPSERVER_HTTP_DEFLATER_HPP
+#define	STATICLIB_HTTPSERVER_HTTP_DEFLATER_HPP
+
+#ifdef STATICLIB_HTTPSERVER_HAVE_ZLIB
+
+#include <memory>
+#include <string>
+
+#include "staticlib/httpserver/config.hpp"
+#include "staticlib/httpserver/noncopyable.hpp"
+
+namespace staticlib { 
+namespace httpserver {
+
+/**
+ * Incremental encoder for "gzip" and "deflate" content codings of the response body.
+ * zlib contexts are taken from the pool of the current thread and are returned
+ * to the pool of the thread that destroys the encoder, so zlib state is
+ * not allocated for each response.
+ */
+class http_deflater : private noncopyable {
+public:
+    /**
+     * Maximum number of idle zlib contexts of each coding kept by the thread
+     */
+    static const std::size_t POOL_MAX_SIZE;
+
+private:
+    class impl;
+
+    /**
+     * zlib state, taken from the thread pool
+     */
+    std::unique_ptr<impl> m_impl;
+
+public:
+    /**
+     * Constructor, takes zlib context from the thread pool
+     * 
+     * @param content_encoding "gzip" or "deflate"
+     * @throws httpserver_exception on unsupported encoding
+     */
+    explicit http_deflater(const std::string& content_encoding);
+
+    /**
+     * Destructor, returns zlib context to the thread pool
+     */
+    ~http_deflater();
+
+    /**
+     * Chooses content coding from the "Accept-Encoding" request header value
+     * taking "q" values into account, "gzip" is preferred to "deflate"
+     * 
+     * @param accept_encoding "Accept-Encoding" request header value
+     * @return "gzip", "deflate" or empty string if none of them is acceptable
+     */
+    static std::string negotiate(const std::string& accept_encoding);
+
+    /**
+     * Returns true if content of the specified type is worth compressing,
+     * returns false for images, audio, video and compressed archives
+     * 
+     * @param content_type "Content-Type" response header value
+     * @return true if content of the specified type is worth compressing
+     */
+    static bool is_compressible(const std::string& content_type);
+
+    /**
+     * Compresses the data appending output to the specified string, output may
+     * be buffered by zlib until the next 'flush' call
+     * 
+     * @param data data to compress
+     * @param len data length
+     * @param out string to append compressed data to
+     */
+    void deflate(const char* data, std::size_t len, std::string& out);
+
+    /**
+     * Flushes all pending output, stream can be decoded
+     * up to this point by client after the flush
+     * 
+     * @param finish true to finish the compressed stream
+     * @param out string to append compressed data to
+     */
+    void flush(bool finish, std::string& out);
+};
+
+} // namespace
+}
+
+#endif // STATICLIB_HTTPSERVER_HAVE_ZLIB
+
+#endif	/* STATICLIB_HTTPSERVER_HTTP_DEFLATER_HPP */
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   http_file_sink.hpp
+ * Author: agent
+ *
+ * Created on October 18, 2026, 6:30 PM
+ */
+
+#ifndef STATICLIB_HTTPSERVER_HTTP_FILE_SINK_HPP
+#define	STATICLIB_HTTPSERVER_HTTP_FILE_SINK_HPP
+
+#include <memory>
+#include <string>
+#include <cstdint>
+
+#include "staticlib/httpserver/config.hpp"
+
+namespace staticlib { 
+namespace httpserver {
+
+/**
+ * Payload handler that writes request body into a file. On Linux for
+ * unencrypted connections request reader recognizes this handler and moves
+ * body bytes from socket to file with 'splice()' without copying them
+ * to user space. Bytes that are already read into connection buffer
+ * (and all bytes for TLS connections) are written with 'write()' calls.
+ * Copies share the same file descriptor, it is closed when the last copy
+ * is destroyed or on explicit 'close()' call.
+ */
+class http_file_sink {
+    /**
+     * Shared file descriptor holder
+     */
+    std::shared_ptr<int> m_fd;
+
+public:
+    /**
+     * Opens (creates or truncates) specified file for writing
+     * 
+     * @param path path to file
+     * @throws httpserver_exception if file cannot be opened
+     */
+    explicit http_file_sink(const std::string& path);
+
+    /**
+     * Writes payload chunk to the file
+     * 
+     * @param data payload chunk
+     * @param len payload chunk length
+     * @throws httpserver_exception on write error
+     */
+    void operator()(const char* data, std::size_t len);
+
+    /**
+     * Returns underlying file descriptor
+     * 
+     * @return file descriptor, -1 if file is closed
+     */
+    int get_fd() const;
+
+    /**
+     * Closes the file, subsequent writes will fail
+     */
+    void close();
+};
+
+} // namespace
+}
+
+#endif	/* STATICLIB_HTTPSERVER_HTTP_FILE_SINK_HPP */
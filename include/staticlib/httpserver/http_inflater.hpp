@@ -0,0 +1,124 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   http_inflater.hpp
+ * Author: agent
+ *
+ * Created on October 18, 2026, 6:47 PM
+ */
+
+#ifndef STATICLIB_HTTPSERVER_HTTP_INFLATER_HPP
+#define	STATICLIB_HTTPSERVER_HTTP_INFLATER_HPP
+
+#ifdef STATICLIB_HTTPSERVER_HAVE_ZLIB
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <cstdint>
+
+#include "staticlib/httpserver/config.hpp"
+#include "staticlib/httpserver/noncopyable.hpp"
+
+namespace staticlib { 
+namespace httpserver {
+
+/**
+ * Incremental decoder for "gzip" and "deflate" content codings of the request body.
+ * Decoder state and output buffer are allocated once and reused for all requests
+ * of the connection that owns the decoder, so memory usage does not depend on
+ * the size of the body. Decoding is aborted if the size of decoded data exceeds
+ * the size of encoded data more than "ratio_max" times.
+ */
+class http_inflater : private noncopyable {
+public:
+    /**
+     * Function called with the decoded data
+     */
+    using output_handler_type = std::function<void(const char*, std::size_t)>;
+
+    /**
+     * Default maximum allowed ratio between decoded and encoded data sizes
+     */
+    static const uint32_t DEFAULT_RATIO_MAX;
+
+    /**
+     * Decoded data size below that the ratio limit is not enforced
+     */
+    static const std::size_t RATIO_CHECK_THRESHOLD;
+
+private:
+    class impl;
+
+    /**
+     * zlib state, allocated on the first use
+     */
+    std::unique_ptr<impl> m_impl;
+
+public:
+    /**
+     * Constructor, does not allocate zlib state
+     */
+    http_inflater();
+
+    /**
+     * Destructor
+     */
+    ~http_inflater();
+
+    /**
+     * Returns true if specified "Content-Encoding" header value is supported
+     * 
+     * @param content_encoding "Content-Encoding" header value
+     * @return true if content encoding is supported
+     */
+    static bool is_supported(const std::string& content_encoding);
+
+    /**
+     * Prepares decoder for the new request body
+     * 
+     * @param content_encoding "Content-Encoding" header value: "gzip", "x-gzip" or "deflate"
+     * @param ratio_max maximum allowed ratio between decoded and encoded data sizes
+     * @throws httpserver_exception on unsupported encoding
+     */
+    void reset(const std::string& content_encoding, uint32_t ratio_max = DEFAULT_RATIO_MAX);
+
+    /**
+     * Decodes next portion of the request body passing decoded data
+     * to the specified handler in one or more calls
+     * 
+     * @param data encoded data
+     * @param len encoded data length
+     * @param handler function called with the decoded data
+     * @throws httpserver_exception on invalid input or when ratio limit is exceeded
+     */
+    void inflate(const char* data, std::size_t len, const output_handler_type& handler);
+
+    /**
+     * Returns true if the end of compressed stream has been reached
+     * 
+     * @return true if the end of compressed stream has been reached
+     */
+    bool is_finished() const;
+};
+
+} // namespace
+}
+
+#endif // STATICLIB_HTTPSERVER_HAVE_ZLIB
+
+#endif	/* STATICLIB_HTTPSERVER_HTTP_INFLATER_HPP */
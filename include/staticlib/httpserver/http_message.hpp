@@ -47,6 +47,8 @@ namespace httpserver {
 class tcp_connection;
 // forward declaration of parser class
 class http_parser;
+// forward declaration of common headers block
+class http_common_headers;
     
 /**
  * Base container for HTTP messages
@@ -168,8 +170,11 @@ public:
     static const std::string RESPONSE_MESSAGE_METHOD_NOT_ALLOWED;
     static const std::string RESPONSE_MESSAGE_NOT_MODIFIED;
     static const std::string RESPONSE_MESSAGE_BAD_REQUEST;
+    static const std::string RESPONSE_MESSAGE_TOO_MANY_REQUESTS;
     static const std::string RESPONSE_MESSAGE_SERVER_ERROR;
     static const std::string RESPONSE_MESSAGE_NOT_IMPLEMENTED;
+    static const std::string RESPONSE_MESSAGE_SERVICE_UNAVAILABLE;
+    static const std::string RESPONSE_MESSAGE_GATEWAY_TIMEOUT;
     static const std::string RESPONSE_MESSAGE_CONTINUE;
 
     // common HTTP response codes
@@ -184,8 +189,11 @@ public:
     static const unsigned int RESPONSE_CODE_METHOD_NOT_ALLOWED;
     static const unsigned int RESPONSE_CODE_NOT_MODIFIED;
     static const unsigned int RESPONSE_CODE_BAD_REQUEST;
+    static const unsigned int RESPONSE_CODE_TOO_MANY_REQUESTS;
     static const unsigned int RESPONSE_CODE_SERVER_ERROR;
     static const unsigned int RESPONSE_CODE_NOT_IMPLEMENTED;
+    static const unsigned int RESPONSE_CODE_SERVICE_UNAVAILABLE;
+    static const unsigned int RESPONSE_CODE_GATEWAY_TIMEOUT;
     static const unsigned int RESPONSE_CODE_CONTINUE;
     
     // response to "Expect: 100-Continue" header
@@ -694,6 +702,19 @@ public:
     void prepare_buffers_for_send(write_buffers_type& write_buffers, const bool keep_alive,
             const bool using_chunks);
 
+    /**
+     * Renders the first line and all HTTP headers (including the final empty line)
+     * into a single contiguous buffer, so they can be sent as one write buffer
+     *
+     * @param buf buffer to append serialized headers to
+     * @param keep_alive true if the connection should be kept alive
+     * @param using_chunks true if the payload content will be sent in chunks
+     * @param common_headers (optional) precomputed headers block appended after
+     *        message headers as is, names are not checked for duplicates
+     */
+    void serialize_headers(std::string& buf, const bool keep_alive, const bool using_chunks,
+            const http_common_headers* common_headers = nullptr);
+
     /**
      * Sends the message over a TCP connection (blocks until finished)
      *
@@ -894,6 +915,13 @@ protected:
      */
     virtual void update_first_line() const = 0;
 
+    /**
+     * Appends the first line for the HTTP message followed by CRLF to the buffer
+     *
+     * @param buf buffer to append the first line to
+     */
+    virtual void append_first_line(std::string& buf) const;
+
 };
 
 
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   http_multipart_parser.hpp
+ * Author: agent
+ *
+ * Created on October 18, 2026, 6:41 PM
+ */
+
+#ifndef STATICLIB_HTTPSERVER_HTTP_MULTIPART_PARSER_HPP
+#define	STATICLIB_HTTPSERVER_HTTP_MULTIPART_PARSER_HPP
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "staticlib/httpserver/algorithm.hpp"
+#include "staticlib/httpserver/config.hpp"
+
+namespace staticlib {
+namespace httpserver {
+
+/**
+ * Incremental parser for "multipart/form-data" payload content
+ * (http://www.ietf.org/rfc/rfc2388.txt) that can be used as a payload handler.
+ * Part boundaries are found with Boyer-Moore-Horspool search, part data is
+ * passed to the data callback as it arrives, so memory usage does not depend
+ * on the size of the parts. Only a few bytes that may be a beginning
+ * of a boundary and the headers of the current part are buffered.
+ * Copies share the same parsing state.
+ */
+class http_multipart_parser {
+public:
+    /**
+     * Data type for part headers
+     */
+    using headers_type = std::unordered_multimap<std::string, std::string, algorithm::ihash, algorithm::iequal_to>;
+
+    /**
+     * Function called when part headers are parsed
+     */
+    using part_begin_handler_type = std::function<void(const headers_type&)>;
+
+    /**
+     * Function called with the part data
+     */
+    using part_data_handler_type = std::function<void(const char*, std::size_t)>;
+
+    /**
+     * Function called after all data of the part has been passed to data handler
+     */
+    using part_end_handler_type = std::function<void()>;
+
+    /**
+     * Maximum length of the part headers
+     */
+    static const std::size_t HEADERS_MAX;
+
+private:
+    class state;
+
+    /**
+     * Parsing state shared between copies
+     */
+    std::shared_ptr<state> m_state;
+
+public:
+    /**
+     * Constructor
+     *
+     * @param content_type value of the content-type HTTP header, must contain boundary
+     * @param part_begin function called when part headers are parsed
+     * @param part_data function called with the part data
+     * @param part_end function called after the end of the part
+     * @throws httpserver_exception if boundary is not specified in content type
+     */
+    http_multipart_parser(const std::string& content_type, part_begin_handler_type part_begin,
+            part_data_handler_type part_data, part_end_handler_type part_end);
+
+    /**
+     * Parses next portion of payload content
+     *
+     * @param data payload data
+     * @param len payload data length
+     * @throws httpserver_exception on invalid input
+     */
+    void operator()(const char* data, std::size_t len);
+
+    /**
+     * Returns true if the final boundary has been parsed
+     *
+     * @return true if the final boundary has been parsed
+     */
+    bool is_finished() const;
+
+    /**
+     * Extracts a parameter (like "name" or "filename") from the "Content-Disposition"
+     * header of the part
+     *
+     * @param headers part headers
+     * @param param parameter name
+     * @return parameter value, empty string if not found
+     */
+    static std::string get_disposition_param(const headers_type& headers, const std::string& param);
+};
+
+} // namespace
+}
+
+#endif	/* STATICLIB_HTTPSERVER_HTTP_MULTIPART_PARSER_HPP */
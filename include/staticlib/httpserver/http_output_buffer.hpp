@@ -0,0 +1,179 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   http_output_buffer.hpp
+ * Author: agent
+ *
+ * Created on October 18, 2026, 7:37 PM
+ */
+
+#ifndef STATICLIB_HTTPSERVER_HTTP_OUTPUT_BUFFER_HPP
+#define	STATICLIB_HTTPSERVER_HTTP_OUTPUT_BUFFER_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "staticlib/httpserver/config.hpp"
+#include "staticlib/httpserver/http_message.hpp"
+#include "staticlib/httpserver/noncopyable.hpp"
+
+namespace staticlib { 
+namespace httpserver {
+
+/**
+ * Chained buffer for the response content: copied data is appended into
+ * fixed-size slabs taken from the per-thread buffer pool, consecutive small
+ * writes into the same slab share a single write buffer; data that is
+ * not copied (persistent, moved or shared) is referenced in place.
+ * Slab memory is never reallocated, so write buffers stay valid until
+ * the buffer is cleared.
+ */
+class http_output_buffer : private staticlib::httpserver::noncopyable {
+public:
+    /**
+     * Capacity of the slab, larger copied data gets its own slab
+     */
+    static const std::size_t SLAB_SIZE;
+
+    /**
+     * Moved strings shorter than this are copied into slab
+     */
+    static const std::size_t INLINE_MAX;
+
+private:
+    /**
+     * Pooled slabs, the last one is being filled
+     */
+    std::vector<std::string> m_slabs;
+
+    /**
+     * Strings moved into buffer
+     */
+    std::vector<std::string> m_moved;
+
+    /**
+     * Shared immutable data referenced by this buffer
+     */
+    std::vector<std::shared_ptr<const std::string>> m_shared;
+
+    /**
+     * Write buffers pointing to the data in order
+     */
+    http_message::write_buffers_type m_buffers;
+
+    /**
+     * Summary length of the data
+     */
+    std::size_t m_length;
+
+    /**
+     * Whether next copied data may extend the last write buffer
+     */
+    bool m_extend_allowed;
+
+public:
+    /**
+     * Constructor
+     */
+    http_output_buffer();
+
+    /**
+     * Destructor, returns slabs to the pool
+     */
+    ~http_output_buffer();
+
+    /**
+     * Copies specified data into the slab
+     * 
+     * @param data data to append
+     * @param len data length
+     */
+    void append(const char* data, std::size_t len);
+
+    /**
+     * References specified data without copying, data must persist until
+     * the buffer is cleared
+     * 
+     * @param data data to append
+     * @param len data length
+     */
+    void append_no_copy(const char* data, std::size_t len);
+
+    /**
+     * Takes ownership of the specified string
+     * 
+     * @param data data to append
+     */
+    void append_move(std::string&& data);
+
+    /**
+     * References shared immutable data without copying, the same data
+     * can be appended to any number of buffers
+     * 
+     * @param data data to append
+     */
+    void append_shared(std::shared_ptr<const std::string> data);
+
+    /**
+     * Makes next appended data start a new write buffer, used to
+     * mark the position of the data sent separately
+     */
+    void split();
+
+    /**
+     * Accessor for write buffers pointing to the data
+     * 
+     * @return write buffers
+     */
+    http_message::write_buffers_type& get_buffers();
+
+    /**
+     * Returns summary length of the data
+     * 
+     * @return data length
+     */
+    std::size_t get_length() const;
+
+    /**
+     * Drops all the data, the first slab is kept for reuse
+     */
+    void clear();
+
+    /**
+     * Moves the data of the other buffer to the end of this one without
+     * copying it, write buffers stay valid, other buffer is left empty
+     * 
+     * @param other buffer to take the data from
+     */
+    void splice(http_output_buffer& other);
+
+    /**
+     * Exchanges the data with other buffer, write buffers stay valid
+     * 
+     * @param other buffer to exchange data with
+     */
+    void swap(http_output_buffer& other);
+
+private:
+    std::string& slab_for(std::size_t len);
+};
+
+} // namespace
+}
+
+#endif	/* STATICLIB_HTTPSERVER_HTTP_OUTPUT_BUFFER_HPP */
@@ -29,6 +29,7 @@
 #include <functional>
 #include <mutex>
 #include <string>
+#include <vector>
 #include <cstdint>
 
 #include "staticlib/httpserver/algorithm.hpp"
@@ -60,6 +61,12 @@ public:
      * Callback type used to consume payload content
      */
     using payload_handler_type = std::function<void(const char *, std::size_t)>;
+
+    /**
+     * Callback type used to obtain destination buffers for payload content,
+     * receives the number of content bytes remaining and the list of buffers to fill
+     */
+    using payload_buffers_provider_type = std::function<void(std::size_t, std::vector<asio::mutable_buffer>&)>;
     
     
     /**
@@ -84,6 +91,7 @@ public:
         ERROR_MISSING_CHUNK_DATA,
         ERROR_MISSING_HEADER_DATA,
         ERROR_MISSING_TOO_MUCH_CONTENT,
+        ERROR_CONTENT_ENCODING,
     };
     
     /**
@@ -178,6 +186,36 @@ protected:
      * Points to the end of the read_buffer (last byte + 1)
      */
     const char * m_read_end_ptr;    
+
+    /**
+     * Obtains destination buffers for the remaining payload content from
+     * the payload buffers provider, buffers are trimmed to the number
+     * of content bytes remaining, so they never receive bytes of the next
+     * pipelined message; does nothing if provider is not set or
+     * content length is unknown
+     * 
+     * @param buffers list to fill with destination buffers
+     * @return total size of the buffers obtained
+     */
+    std::size_t fill_payload_buffers(std::vector<asio::mutable_buffer>& buffers);
+
+    /**
+     * Returns the number of payload content bytes that have not yet been read,
+     * only for content with known length
+     * 
+     * @return number of content bytes remaining, zero if length is unknown
+     */
+    std::size_t get_content_bytes_remaining() const;
+
+    /**
+     * Accounts payload content bytes that were consumed from the socket
+     * directly, bypassing the read buffer and the payload handler
+     * 
+     * @param http_msg the HTTP message object being parsed
+     * @param len number of content bytes consumed
+     * @return tribool true if all content was consumed, indeterminate otherwise
+     */
+    staticlib::httpserver::tribool skip_content(http_message& http_msg, std::size_t len);
     
 private:
     /**
@@ -261,6 +299,11 @@ private:
      */
     payload_handler_type* m_payload_handler = nullptr;
 
+    /**
+     * If defined, this function is used to obtain destination buffers for payload content
+     */
+    payload_buffers_provider_type* m_payload_buffers_provider = nullptr;
+
     /**
      * Used for parsing the HTTP response status code
      */
@@ -524,6 +567,14 @@ public:
      */
     void set_payload_handler(payload_handler_type& h);
 
+    /**
+     * Defines a callback function to be used for obtaining destination buffers
+     * for payload content, used only together with payload handler
+     * 
+     * @param bp a callback function to be used for obtaining payload buffers
+     */
+    void set_payload_buffers_provider(payload_buffers_provider_type& bp);
+
     /**
      * Sets the maximum length for HTTP payload content
      * 
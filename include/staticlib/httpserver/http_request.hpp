@@ -27,6 +27,7 @@
 #define STATICLIB_HTTPSERVER_HTTP_REQUEST_HPP
 
 #include <functional>
+#include <memory>
 #include <string>
 
 #include "staticlib/httpserver/config.hpp"
@@ -36,6 +37,12 @@
 namespace staticlib { 
 namespace httpserver {
 
+// forward declaration
+class overload_admission;
+class handler_deadline;
+class cancellation_token;
+class response_pipeline;
+
 /**
  * Container for HTTP request information
  */
@@ -71,13 +78,48 @@ class http_request : public http_message {
      */
     http_parser::payload_handler_type m_payload_handler;
 
+    /**
+     * Payload buffers provider used with this request
+     */
+    http_parser::payload_buffers_provider_type m_payload_buffers_provider;
+
     /**
      * Non-owning pointer to request_reader to be used during parsing
      */
     http_parser* m_request_reader;    
+
+    /**
+     * Priority lane used for offloaded handler of this request
+     */
+    uint32_t m_priority_lane;
+
+    /**
+     * Admission of this request by the server overload controller
+     */
+    std::shared_ptr<overload_admission> m_admission;
+
+    /**
+     * Deadline of the handler of this request
+     */
+    std::shared_ptr<handler_deadline> m_deadline;
+
+    /**
+     * Responses to the batch of pipelined requests this request belongs to, may be null
+     */
+    std::shared_ptr<response_pipeline> m_pipeline;
+
+    /**
+     * Index of the response to this request in the batch
+     */
+    std::size_t m_pipeline_index;
     
 public:
 
+    /**
+     * Value of the priority lane of the request that was not assigned to a lane
+     */
+    static const uint32_t PRIORITY_LANE_UNSET;
+
     /**
      * Constructs a new request object
      *
@@ -237,6 +279,17 @@ public:
      * @param ph payload handler
      */
     void set_payload_handler(http_parser::payload_handler_type ph);
+
+    /**
+     * This method may be called from payload_handler_creator
+     * to supply destination buffers for the payload content;
+     * when the content length is known, the remaining content is read
+     * from the socket directly into these buffers (using scatter reads)
+     * and payload handler is called with pointers into them
+     * 
+     * @param bp payload buffers provider
+     */
+    void set_payload_buffers_provider(http_parser::payload_buffers_provider_type bp);
     
     /**
      * Access to the wrapped payload handler object
@@ -258,6 +311,88 @@ public:
      */
     void set_request_reader(http_parser* rr);
 
+    /**
+     * Sets the priority lane for the offloaded handler of this request,
+     * may be called from filters; when the lane is not set,
+     * the lane specified for the handler is used
+     * 
+     * @param lane_idx index of the lane in the server priority lanes
+     */
+    void set_priority_lane(uint32_t lane_idx);
+
+    /**
+     * Returns the priority lane set for this request
+     * 
+     * @return index of the lane, 'PRIORITY_LANE_UNSET' if not set
+     */
+    uint32_t get_priority_lane() const;
+
+    /**
+     * Internal method used by the server overload controller
+     * 
+     * @param admission admission of this request
+     */
+    void set_admission(std::shared_ptr<overload_admission> admission);
+
+    /**
+     * Internal method used by the server overload controller
+     * 
+     * @return admission of this request, null if request is not controlled
+     */
+    overload_admission* get_admission() const;
+
+    /**
+     * Internal method used by the server to limit the handler run time
+     * 
+     * @param deadline deadline of the handler
+     */
+    void set_deadline(std::shared_ptr<handler_deadline> deadline);
+
+    /**
+     * Internal method used by the response writers
+     * 
+     * @return deadline of the handler, null if the route has no deadline
+     */
+    const std::shared_ptr<handler_deadline>& get_deadline() const;
+
+    /**
+     * Returns the token that is cancelled when the handler deadline expires,
+     * handlers may poll or subscribe to it to stop their work early
+     * 
+     * @return cancellation token, null if the route has no deadline
+     */
+    std::shared_ptr<cancellation_token> get_cancellation_token() const;
+
+    /**
+     * Returns true if the handler deadline has expired and the timeout
+     * response was sent instead of the handler one
+     * 
+     * @return whether handler should stop its work
+     */
+    bool is_cancelled() const;
+
+    /**
+     * Internal method used by the server to handle pipelined requests concurrently
+     * 
+     * @param pipeline batch responses
+     * @param index index of the response to this request in the batch
+     */
+    void set_pipeline(std::shared_ptr<response_pipeline> pipeline, std::size_t index);
+
+    /**
+     * Internal method used by the response writers
+     * 
+     * @return batch responses, null if request is not handled as a part of the batch
+     */
+    const std::shared_ptr<response_pipeline>& get_pipeline() const;
+
+    /**
+     * Internal method used by the response writers
+     * 
+     * @return index of the response to this request in the batch
+     */
+    std::size_t get_pipeline_index() const;
+
 protected:
 
     /**
@@ -28,10 +28,12 @@
 
 #include <functional>
 #include <memory>
+#include <vector>
 
 #include "asio.hpp"
 
 #include "staticlib/httpserver/config.hpp"
+#include "staticlib/httpserver/http_inflater.hpp"
 #include "staticlib/httpserver/http_parser.hpp"
 #include "staticlib/httpserver/http_request.hpp"
 #include "staticlib/httpserver/tcp_connection.hpp"
@@ -96,6 +98,39 @@ private:
      * Function called after the HTTP message headers have been parsed
      */
     headers_parsing_finished_handler_type m_parsed_headers;    
+
+    /**
+     * Destination buffers obtained from the payload buffers provider
+     */
+    std::vector<asio::mutable_buffer> m_payload_buffers;
+
+    /**
+     * Whether only the data already in the read buffer may be parsed
+     */
+    bool m_buffered_only;
+
+    /**
+     * Whether parsing was stopped because the request cannot be read from the buffer
+     */
+    bool m_buffered_stop;
+
+#ifdef STATICLIB_HTTPSERVER_HAVE_ZLIB
+    /**
+     * Inflater of the connection that decodes the request body, null if the body is not encoded
+     */
+    http_inflater* m_inflater;
+
+    /**
+     * Payload handler used by the parser for the encoded body, passes
+     * the decoded data to the payload handler of the request
+     */
+    payload_handler_type m_decoding_handler;
+
+    /**
+     * Maximum allowed ratio between decoded and encoded body sizes
+     */
+    uint32_t m_inflate_ratio_max;
+#endif // STATICLIB_HTTPSERVER_HAVE_ZLIB
     
 public:
 
@@ -133,6 +168,23 @@ public:
      * @param h function pointer
      */
     void set_headers_parsed_callback(headers_parsing_finished_handler_type h);
+
+    /**
+     * Restricts parsing to the data already in the read buffer, reading is finished
+     * with "would_block" error if the request is incomplete or has a body
+     * 
+     * @param buffered_only whether socket reads are not allowed
+     */
+    void set_buffered_only(bool buffered_only);
+
+    /**
+     * Sets maximum allowed ratio between decoded and encoded sizes for the
+     * request bodies with "gzip" or "deflate" content encoding, does nothing
+     * if the library is built without zlib support
+     * 
+     * @param ratio_max maximum allowed ratio
+     */
+    void set_inflate_ratio_max(uint32_t ratio_max);
     
 private:
 
@@ -156,6 +208,31 @@ private:
      * Consumes bytes that have been read using an HTTP parser
      */
     void consume_bytes();
+
+    /**
+     * Consumes payload bytes that have been read directly into the payload buffers
+     * 
+     * @param read_error error status from the last read operation
+     * @param bytes_read number of bytes consumed by the last read operation
+     */
+    void consume_payload_buffers(const asio::error_code& read_error, std::size_t bytes_read);
+
+    /**
+     * Accounts payload bytes that have been spliced from socket to the file sink
+     * 
+     * @param read_error error status from the last splice operation
+     * @param bytes_read number of bytes moved by the last splice operation
+     */
+    void consume_spliced_bytes(const asio::error_code& read_error, std::size_t bytes_read);
+
+    /**
+     * Updates connection lifecycle and finishes reading or requests
+     * more bytes depending on the result of the last parse operation
+     * 
+     * @param result result of the last parse operation
+     * @param ec error code from the last parse operation
+     */
+    void handle_parse_result(staticlib::httpserver::tribool result, const asio::error_code& ec);
     
     /**
      * Reads more bytes for parsing, with timeout support
@@ -177,6 +254,20 @@ private:
      */
     void finished_parsing_headers(const asio::error_code& ec, staticlib::httpserver::tribool& rc);
 
+    /**
+     * Passes the request body through the inflater of the connection if it has
+     * a supported content encoding, payload handler of the request is kept
+     * unchanged and receives the decoded data
+     */
+    void start_decoding();
+
+    /**
+     * Returns true if the request body is decoded before passing it to the payload handler
+     * 
+     * @return whether the request body is decoded
+     */
+    bool is_decoding() const;
+
     /**
      * Reads more bytes from the TCP connection
      */
@@ -212,6 +212,14 @@ protected:
      * Updates the string containing the first line for the HTTP message
      */
     virtual void update_first_line() const;
+
+    /**
+     * Appends the status line to the buffer, uses precomputed
+     * lines for HTTP/1.1 responses with standard messages
+     *
+     * @param buf buffer to append the status line to
+     */
+    virtual void append_first_line(std::string& buf) const;
     
     /**
      * Appends HTTP headers for any cookies defined by the http::message
@@ -26,19 +26,27 @@
 #ifndef STATICLIB_HTTPSERVER_HTTP_RESPONSE_WRITER_HPP
 #define STATICLIB_HTTPSERVER_HTTP_RESPONSE_WRITER_HPP
 
+#include <deque>
+#include <exception>
 #include <functional>
-#include <list>
 #include <memory>
+#include <mutex>
+#include <sstream>
 #include <string>
 #include <vector>
+#include <cstdint>
 
 #include "asio.hpp"
 
 #include "staticlib/httpserver/config.hpp"
+#include "staticlib/httpserver/handler_deadline.hpp"
+#include "staticlib/httpserver/http_deflater.hpp"
 #include "staticlib/httpserver/logger.hpp"
 #include "staticlib/httpserver/noncopyable.hpp"
 #include "staticlib/httpserver/http_message.hpp"
+#include "staticlib/httpserver/http_output_buffer.hpp"
 #include "staticlib/httpserver/http_response.hpp"
+#include "staticlib/httpserver/response_pipeline.hpp"
 #include "staticlib/httpserver/tcp_connection.hpp"
 
 namespace staticlib { 
@@ -57,67 +65,138 @@ public:
      */
     using finished_handler_type = std::function<void(const asio::error_code&)>;
 
+    /**
+     * Default minimum length of content (sent without chunking) to compress
+     */
+    static const std::size_t DEFAULT_COMPRESSION_MIN_LENGTH;
+
+    /**
+     * Number of write buffers above which small content buffers are
+     * copied together, asio passes at most 64 buffers to a single 'writev'
+     * call, this is also well below IOV_MAX
+     */
+    static const std::size_t WRITE_BUFFERS_MAX;
+
+    /**
+     * Content buffers shorter than this are copied together
+     * when there are too many write buffers
+     */
+    static const std::size_t COALESCE_THRESHOLD;
+
+    /**
+     * Function that produces streamed body content: it should write
+     * up to 'len' bytes into 'buf' and return the number of bytes written,
+     * zero return value means the end of content
+     */
+    using body_source_type = std::function<std::size_t(char* buf, std::size_t len)>;
+
+    /**
+     * Default maximum number of streamed body bytes buffered by the writer
+     */
+    static const std::size_t DEFAULT_HIGH_WATERMARK;
+
+    /**
+     * Default minimum size of a streamed body chunk
+     */
+    static const std::size_t DEFAULT_LOW_WATERMARK;
+
 private:    
     
     /**
      * Data type for a function that handles write operations
      */
     using write_handler_type = std::function<void(const asio::error_code&, std::size_t)>;
-    
+
     /**
-     * Used to cache binary data included within the payload content
+     * Send operation made while a write was in progress
      */
-    class binary_cache_t : public std::vector<std::pair<const char *, size_t>> {
-        public:
+    struct queued_send {
+        /**
+         * Chunk framing followed by the references to the content buffers
+         */
+        http_output_buffer content;
+
+        /**
+         * Function called after the data has been sent
+         */
+        write_handler_type handler;
+
+        /**
+         * Number of bytes queued, including the file region
+         */
+        std::size_t length = 0;
+
+        /**
+         * Descriptor of the file to send, -1 if none
+         */
+        int file_fd = -1;
+
+        /**
+         * Offset of the file region
+         */
+        uint64_t file_offset = 0;
+
         /**
-         * Destructor
+         * Length of the file region
          */
-        ~binary_cache_t();
+        std::size_t file_length = 0;
 
         /**
-         * Add data to cache
-         * 
-         * @param ptr data
-         * @param size data length in bytes
-         * @return asio buffer pointing to copy of passed data
+         * Index in content buffers at which the file region must be sent
          */
-        asio::const_buffer add(const void *ptr, const size_t size);
+        std::size_t file_split = 0;
+
+        /**
+         * Whether this is the last write of the response
+         */
+        bool last = false;
     };
 
     /**
-     * Primary logging interface used by this class
+     * Buffer sequence referring to the write buffers owned by the writer,
+     * passing it instead of the vector avoids copying buffers into
+     * each write operation
      */
-    logger m_logger;
+    class write_buffers_ref {
+        const http_message::write_buffers_type* m_buffers;
 
-    /**
-     * The HTTP connection that we are writing the message to
-     */
-    tcp_connection_ptr m_tcp_conn;
+    public:
+        using value_type = asio::const_buffer;
+        using const_iterator = http_message::write_buffers_type::const_iterator;
 
-    /**
-     * I/O write buffers that wrap the payload content to be written
-     */
-    http_message::write_buffers_type m_content_buffers;
+        explicit write_buffers_ref(const http_message::write_buffers_type& buffers) :
+        m_buffers(std::addressof(buffers)) { }
+
+        const_iterator begin() const {
+            return m_buffers->begin();
+        }
 
+        const_iterator end() const {
+            return m_buffers->end();
+        }
+    };
+    
     /**
-     * Caches binary data included within the payload content
+     * Primary logging interface used by this class
      */
-    binary_cache_t m_binary_cache;
+    logger m_logger;
 
     /**
-     * Caches text (non-binary) data included within the payload content
+     * The HTTP connection that we are writing the message to
      */
-    std::list<std::string> m_text_cache;
+    tcp_connection_ptr m_tcp_conn;
 
     /**
-     * Caches strings moved into writer and included within the payload content
+     * Payload content to be written
      */
-    std::vector<std::string> m_moved_cache;
+    http_output_buffer m_content;
 
     /**
-     * Incrementally creates strings of text data for the text_cache
+     * Formats text data of types without a fast formatter, or when
+     * stream formatting flags were changed with manipulators,
+     * created on first use
      */
-    std::ostringstream m_content_stream;
+    std::unique_ptr<std::ostringstream> m_content_stream;
 
     /**
      * The length (in bytes) of the response content to be sent (Content-Length)
@@ -158,6 +237,161 @@ private:
      * The initial HTTP response header line
      */
     std::string m_response_line;
+
+    /**
+     * Contiguous pooled buffer with serialized headers and chunk framing
+     * written before the content
+     */
+    std::string m_head_buffer;
+
+    /**
+     * Pooled buffer with copies of small content buffers
+     */
+    std::string m_coalesced_buffer;
+
+    /**
+     * Buffers of the current send operation, reused between chunks
+     */
+    http_message::write_buffers_type m_write_buffers;
+
+    /**
+     * Guards the write in progress flag and the queue of sends, writer calls
+     * are not concurrent, but can run while the previous write completes
+     */
+    std::mutex m_write_mutex;
+
+    /**
+     * True while a write operation is in progress
+     */
+    bool m_write_in_flight;
+
+    /**
+     * Content of the write in progress, detached from the writer
+     */
+    http_output_buffer m_inflight_content;
+
+    /**
+     * Sends made while a write was in progress, in order
+     */
+    std::deque<std::unique_ptr<queued_send>> m_queued_sends;
+
+    /**
+     * Queued sends that are being written
+     */
+    std::vector<std::unique_ptr<queued_send>> m_flushed_sends;
+
+    /**
+     * Chunk framing of the queued send
+     */
+    std::string m_queued_head;
+
+    /**
+     * Descriptor of the file to send as a part of payload content, -1 if none
+     */
+    int m_file_fd;
+
+    /**
+     * Offset of the file region to send
+     */
+    uint64_t m_file_offset;
+
+    /**
+     * Length of the file region to send
+     */
+    std::size_t m_file_length;
+
+    /**
+     * Number of content buffers written before the file region
+     */
+    std::size_t m_file_buffers_pos;
+
+    /**
+     * Index in prepared write buffers at which the file region must be sent
+     */
+    std::size_t m_file_split;
+
+    /**
+     * True if the response content may be compressed
+     */
+    bool m_compression_enabled;
+
+    /**
+     * Minimum length of content (sent without chunking) to compress
+     */
+    std::size_t m_compression_min_length;
+
+    /**
+     * "Accept-Encoding" header of the request we are responding to
+     */
+    std::string m_accept_encoding;
+
+    /**
+     * Producer of the streamed body
+     */
+    body_source_type m_body_source;
+
+    /**
+     * Maximum number of streamed body bytes buffered (sent and pending)
+     */
+    std::size_t m_body_high_watermark;
+
+    /**
+     * Minimum size of a streamed body chunk
+     */
+    std::size_t m_body_low_watermark;
+
+    /**
+     * Pooled buffer with the chunk being written
+     */
+    std::string m_body_inflight;
+
+    /**
+     * Length of the chunk being written
+     */
+    std::size_t m_body_inflight_length;
+
+    /**
+     * Pooled buffer with the data pulled while the previous chunk is being written
+     */
+    std::string m_body_pending;
+
+    /**
+     * Length of the pending data
+     */
+    std::size_t m_body_pending_length;
+
+    /**
+     * True if the body source returned the end of content
+     */
+    bool m_body_source_finished;
+
+    /**
+     * Deadline of the handler that owns this writer, null if there is no deadline
+     */
+    std::shared_ptr<handler_deadline> m_deadline;
+
+    /**
+     * Ordered responses of the pipelined batch of the request, null if request is not pipelined
+     */
+    std::shared_ptr<response_pipeline> m_pipeline;
+
+    /**
+     * Index of the response in the pipelined batch
+     */
+    std::size_t m_pipeline_index;
+
+#ifdef STATICLIB_HTTPSERVER_HAVE_ZLIB
+    /**
+     * Content encoder, set when compression was negotiated and until the last data is sent
+     */
+    std::unique_ptr<http_deflater> m_deflater;
+
+    /**
+     * Compressed data of the current send operation,
+     * compressed data of queued sends is owned by their content
+     */
+    std::string m_compressed;
+#endif // STATICLIB_HTTPSERVER_HAVE_ZLIB
         
 public:
 
@@ -186,6 +420,11 @@ public:
     static std::shared_ptr<http_response_writer> create(tcp_connection_ptr& tcp_conn,
             const http_request_ptr& http_request, finished_handler_type handler);
 
+    /**
+     * Destructor, returns serialization buffers to the pool
+     */
+    ~http_response_writer();
+
     /**
      * Returns a non-const reference to the response that will be sent
      * 
@@ -199,17 +438,33 @@ public:
     void clear();
 
     /**
-     * Write text (non-binary) payload content
+     * Write text (non-binary) payload content; strings, characters and numbers
+     * are formatted directly into the content buffer the same way
+     * as 'std::ostream' does with default flags, other types are formatted
+     * using 'std::ostream'
      *
      * @param data the data to append to the payload content
      */
     template <typename T> void write(const T& data) {
         if (m_http_response->is_body_allowed()) {
-            m_content_stream << data;
-            if (m_stream_is_empty) m_stream_is_empty = false;
+            write_text(data);
         }
     }
 
+    /**
+     * Write text payload content, string is copied into the content buffer
+     *
+     * @param data the data to append to the payload content
+     */
+    void write(const std::string& data);
+
+    /**
+     * Write text payload content, string is copied into the content buffer
+     *
+     * @param data null-terminated string to append to the payload content
+     */
+    void write(const char* data);
+
     /**
      * Write using manipulator
      * 
@@ -250,6 +505,45 @@ public:
      * @param length the length, in bytes, of the binary data
      */
     void write_move(std::string&& data);
+
+    /**
+     * Write shared immutable payload content; the data is not copied,
+     * writer holds a reference to it until the message has finished
+     * sending, so the same data can be sent to many clients
+     *
+     * @param data the data to append to the payload content
+     */
+    void write_shared(std::shared_ptr<const std::string> data);
+
+    /**
+     * Write a region of the file as a part of payload content; file data is
+     * not read into memory, on Linux it is sent with 'sendfile()' for
+     * unencrypted connections, TLS connections use 'pread()'. File descriptor
+     * must stay open until the message has finished sending. Only one file
+     * region can be written per 'send' call, it is sent between the data
+     * written before and after it.
+     *
+     * @param fd file descriptor
+     * @param offset offset of the region in file
+     * @param length the length, in bytes, of the region
+     * @throws httpserver_exception if a file region was already written
+     *         or if previous chunks were compressed
+     */
+    void write_file(int fd, uint64_t offset, std::size_t length);
+
+    /**
+     * Enables compression of the response content with "gzip" or "deflate"
+     * coding chosen from the "Accept-Encoding" header of the request; has no
+     * effect if library is built without zlib support. Content is not compressed
+     * if it has an incompressible type (images, archives etc), if
+     * "Content-Encoding" is already set, if it contains a file region and, when
+     * sent without chunking, if it is shorter than specified minimum length.
+     * Chunks are compressed incrementally as a single stream. Must be called
+     * before the headers are sent.
+     *
+     * @param min_length minimum length of content sent without chunking to compress
+     */
+    void enable_compression(std::size_t min_length = DEFAULT_COMPRESSION_MIN_LENGTH);
     
     /**
      * Sends all data buffered as a single HTTP message (without chunking).
@@ -272,14 +566,17 @@ public:
     }
     
     /**
-     * Sends all data buffered as a single HTTP chunk.  Following a call to this
-     * function, it is not thread safe to use your reference to the writer
-     * object until the send_handler has been called.
+     * Sends all data buffered as a single HTTP chunk.  More data may be written
+     * and sent without waiting for the send_handler: chunks sent while a write
+     * is in progress are queued without copying the content, consecutive
+     * queued chunks are then written together with a single gathered write,
+     * file regions are sent separately. Calls to the writer must not be made
+     * concurrently from different threads, including the send_handler thread.
      * 
      * @param send_handler function that is called after the chunk has been sent
      *                     to the client.  Your callback function must end by
-     *                     calling one of send_chunk() or send_final_chunk().  Also,
-     *                     be sure to clear() the writer before writing data to it.
+     *                     calling one of send_chunk() or send_final_chunk(),
+     *                     unless these were already called.
      */
     template <typename SendHandler> void send_chunk(SendHandler send_handler) {
         m_sending_chunks = true;
@@ -316,7 +613,43 @@ public:
      * reference to the writer object.
      */ 
     void send_final_chunk();
+
+    /**
+     * Streams the body produced by the specified source in chunks; the source
+     * is pulled only when the buffered data falls below the limits: chunk is sent
+     * as soon as previous one is written and at least 'low_watermark' bytes
+     * are pending, before the chunk write is started, the next one is prefetched
+     * until 'high_watermark' bytes are buffered in total. Slow clients
+     * cause the source to be pulled less often, memory usage does not
+     * depend on the client speed. Errors thrown by the source on the first
+     * pull are propagated to the caller, on later pulls the connection
+     * is closed. Following a call to this function, it is not thread safe
+     * to use your reference to the writer object.
+     *
+     * @param source function that produces body content
+     * @param high_watermark maximum number of body bytes buffered
+     * @param low_watermark minimum size of a chunk (except the last one),
+     *        should not be greater than the half of 'high_watermark'
+     */
+    void send_body(body_source_type source, std::size_t high_watermark = DEFAULT_HIGH_WATERMARK,
+            std::size_t low_watermark = DEFAULT_LOW_WATERMARK);
     
+    /**
+     * Runs the specified handler with this writer using the connection's
+     * io_service, serially with the writer's send handlers; lets handlers
+     * that finish the response in other threads use the writer without locking.
+     * Can be called from any thread.
+     *
+     * @param handler function that takes 'http_response_writer&' argument, must not throw
+     */
+    template <typename Handler>
+    void post(Handler handler) {
+        auto self = shared_from_this();
+        m_tcp_conn->post([self, handler]() mutable {
+            handler(*self);
+        });
+    }
+
     /**
      * Returns a shared pointer to the TCP connection
      * 
@@ -368,6 +701,85 @@ public:
 
 private:
 
+    /**
+     * Formats data of types without a fast formatter
+     * 
+     * @param data data to format
+     */
+    template <typename T> void write_text(const T& data) {
+        write_to_stream(data);
+    }
+
+    // fast formatters, fall back to the content stream if its flags were changed
+    void write_text(bool data);
+    void write_text(char data);
+    void write_text(signed char data);
+    void write_text(unsigned char data);
+    void write_text(short data);
+    void write_text(unsigned short data);
+    void write_text(int data);
+    void write_text(unsigned int data);
+    void write_text(long data);
+    void write_text(unsigned long data);
+    void write_text(long long data);
+    void write_text(unsigned long long data);
+    void write_text(float data);
+    void write_text(double data);
+
+    /**
+     * Formats data using the content stream
+     * 
+     * @param data data to format
+     */
+    template <typename T> void write_to_stream(const T& data) {
+        get_content_stream() << data;
+        m_stream_is_empty = false;
+    }
+
+    /**
+     * Formats signed integer number with the fast formatter if possible
+     * 
+     * @param data number to format
+     */
+    template <typename T> void write_signed(T data);
+
+    /**
+     * Formats unsigned integer number with the fast formatter if possible
+     * 
+     * @param data number to format
+     */
+    template <typename T> void write_unsigned(T data);
+
+    /**
+     * Formats integer number into the content buffer
+     * 
+     * @param magnitude absolute value of the number
+     * @param negative whether the number is negative
+     */
+    void write_integer(unsigned long long magnitude, bool negative);
+
+    /**
+     * Formats floating point number into the content buffer
+     * 
+     * @param data number to format
+     */
+    void write_floating(double data);
+
+    /**
+     * Returns true if the content stream has default formatting flags,
+     * so the fast formatters produce the same output
+     * 
+     * @return true if fast formatters can be used
+     */
+    bool is_default_formatting() const;
+
+    /**
+     * Returns content stream creating it if necessary
+     * 
+     * @return content stream
+     */
+    std::ostringstream& get_content_stream();
+
     /**
      * called after we have finished sending the HTTP message
      * 
@@ -386,11 +798,9 @@ private:
             finished_handler_type handler);
 
     /**
-     * Initializes a vector of write buffers with the HTTP message information
-     *
-     * @param write_buffers vector of write buffers to initialize
+     * Serializes the HTTP message first line and headers into the head buffer
      */
-    void prepare_buffers_for_send(http_message::write_buffers_type& write_buffers);
+    void prepare_buffers_for_send();
 
     /**
      * Returns a function bound to http::writer::handle_write()
@@ -415,20 +825,120 @@ private:
      */
     template <typename SendHandler>
     void send_more_data(const bool send_final_chunk, SendHandler send_handler) {
+        if (!m_sent_headers && m_deadline && !m_deadline->start_response()) {
+            // timeout response was sent and the connection is finished already,
+            // handlers are not called, so streaming loops stop here
+            STATICLIB_HTTPSERVER_LOG_DEBUG(m_logger, "Response discarded after handler deadline");
+            return;
+        }
         // make sure that we did not lose the TCP connection
         if (m_tcp_conn->is_open()) {
             // make sure that the content-length is up-to-date
             flush_content_stream();
+            if (!start_write_in_flight()) {
+                // data is sent after the write in progress
+                queue_more_data(send_final_chunk, send_handler);
+                return;
+            }
+            // replace content with its compressed form if necessary
+            compress_content(send_final_chunk, false);
             // prepare the write buffers to be sent
-            http_message::write_buffers_type write_buffers;
-            prepare_write_buffers(write_buffers, send_final_chunk);
-            // send data in the write buffers
-            m_tcp_conn->async_write(write_buffers, send_handler);
+            m_write_buffers.clear();
+            prepare_write_buffers(m_write_buffers, send_final_chunk);
+            // content is detached, so more data can be written while it is sent
+            m_inflight_content.swap(m_content);
+            m_content_length = 0;
+            auto self = shared_from_this();
+            auto handler = [self, send_handler](const asio::error_code& ec, std::size_t bytes_written) {
+                // serialized with the handlers posted to the connection
+                self->m_tcp_conn->dispatch([self, send_handler, ec, bytes_written] {
+                    self->finish_write(ec);
+                    send_handler(ec, bytes_written);
+                });
+            };
+            // file region is consumed by this send
+            int fd = m_file_fd;
+            m_file_fd = -1;
+            start_write(fd, m_file_offset, m_file_length, m_file_split,
+                    send_final_chunk || !m_sending_chunks, std::move(handler));
         } else {
             finished_writing(asio::error::connection_reset);
         }
     }
+
+    /**
+     * Marks the write as being in progress
+     *
+     * @return false if another write is in progress already
+     */
+    bool start_write_in_flight();
+
+    /**
+     * Starts writing prepared write buffers
+     *
+     * @param fd descriptor of the file to send between the buffers, -1 if none
+     * @param file_offset offset of the file region
+     * @param file_length length of the file region
+     * @param file_split index in write buffers at which the file region must be sent
+     * @param last whether this is the last write of the response
+     * @param handler function called after all the data has been sent
+     */
+    void start_write(int fd, uint64_t file_offset, std::size_t file_length, std::size_t file_split,
+            bool last, write_handler_type handler);
+
+    /**
+     * Moves references to the buffered data into the queue of sends,
+     * the data is sent after the write in progress
+     *
+     * @param send_final_chunk true if the final 0-byte chunk should be included
+     * @param send_handler function called after the data has been sent
+     */
+    void queue_more_data(const bool send_final_chunk, write_handler_type send_handler);
+
+    /**
+     * Starts a gathered write of the queued sends up to the next file region,
+     * must be called by the owner of the write in progress flag
+     */
+    void send_queued_data();
+
+    /**
+     * Releases the content of the finished write and sends queued data, if any;
+     * queued sends are failed with the write error
+     *
+     * @param ec error status of the finished write
+     */
+    void finish_write(const asio::error_code& ec);
+
+    /**
+     * Called after the queued data is written
+     *
+     * @param ec error status of the write operation
+     * @param bytes_written number of bytes written
+     */
+    void handle_queued_write(const asio::error_code& ec, std::size_t bytes_written);
+
+    /**
+     * Appends the chunk framing to be sent before the content
+     *
+     * @param head buffer to append the framing to
+     * @param send_final_chunk true if the final 0-byte chunk should be included
+     * @return framing to be sent after the content, null if not needed
+     */
+    const std::string* prepare_chunk_head(std::string& head, const bool send_final_chunk);
     
+    /**
+     * Sends prepared buffers splitting them around the file region
+     *
+     * @param write_buffers prepared buffers
+     * @param fd descriptor of the file to send
+     * @param offset offset of the file region
+     * @param length length of the file region
+     * @param file_split index in write buffers at which the file region must be sent
+     * @param send_handler function called after all the data has been sent
+     */
+    void send_with_file(const http_message::write_buffers_type& write_buffers, int fd, uint64_t offset,
+            std::size_t length, std::size_t file_split, write_handler_type send_handler);
+
     /**
      * Prepares write_buffers for next send operation
      *
@@ -439,9 +949,50 @@ private:
             const bool send_final_chunk);
     
     /**
-     * Flushes any text data in the content stream after caching it in the text_cache_t
+     * Flushes any text data in the content stream into the content buffer
      */
     void flush_content_stream();
+
+    /**
+     * Copies runs of small content buffers into a single buffer
+     * if there are too many content buffers
+     */
+    void coalesce_content_buffers();
+
+    /**
+     * Compresses content buffers if compression was negotiated for this response
+     *
+     * @param send_final_chunk true if this is the last portion of the content
+     * @param queued true if the content is being queued while a write is in progress
+     */
+    void compress_content(const bool send_final_chunk, const bool queued);
+
+    /**
+     * Pulls data from the body source into the pending buffer
+     *
+     * @param limit pending data length to pull up to
+     */
+    void pull_body(std::size_t limit);
+
+    /**
+     * Pulls the next chunk and sends pending body data
+     */
+    void send_body_chunk();
+
+    /**
+     * Called after a body chunk is written
+     *
+     * @param ec error status of the write operation
+     * @param bytes_written number of bytes written
+     */
+    void handle_body_write(const asio::error_code& ec, std::size_t bytes_written);
+
+    /**
+     * Closes the connection after the body source error
+     *
+     * @param e error thrown by the body source
+     */
+    void abort_body(const std::exception& e);
     
 };
 
@@ -24,6 +24,8 @@
 #ifndef STATICLIB_HTTPSERVER_HTTP_SERVER_HPP
 #define	STATICLIB_HTTPSERVER_HTTP_SERVER_HPP
 
+#include <chrono>
+#include <memory>
 #include <vector>
 #include <unordered_map>
 #include <utility>
@@ -33,8 +35,11 @@
 
 #include "staticlib/httpserver/config.hpp"
 #include "staticlib/httpserver/tribool.hpp"
+#include "staticlib/httpserver/http_common_headers.hpp"
 #include "staticlib/httpserver/http_parser.hpp"
 #include "staticlib/httpserver/http_request.hpp"
+#include "staticlib/httpserver/overload_controller.hpp"
+#include "staticlib/httpserver/rate_limiter.hpp"
 #include "staticlib/httpserver/tcp_connection.hpp"
 #include "staticlib/httpserver/tcp_server.hpp"
 
@@ -71,6 +76,11 @@ protected:
      * Type for filters
      */
     using request_filter_type = std::function<void(http_request_ptr&, tcp_connection_ptr&, http_filter_chain&)>;
+
+    /**
+     * Type of function that returns the rate limiting key for the request
+     */
+    using rate_limit_key_type = std::function<std::string(http_request&)>;
     
     /**
      * Data type for a map of resources to request handlers
@@ -180,6 +190,53 @@ protected:
      */
     filter_map_type options_filters;
 
+    /**
+     * Maximum allowed ratio between decoded and encoded request body sizes
+     */
+    uint32_t inflate_ratio_max;
+
+    /**
+     * Headers block added to all responses and the timer that updates it
+     */
+    class common_headers_updater;
+    std::shared_ptr<common_headers_updater> common_headers;
+
+    /**
+     * Priority lanes for offloaded handlers, placed in front of the worker pool
+     */
+    std::unique_ptr<priority_lanes> handler_lanes;
+
+    /**
+     * Pool of threads that run offloaded handlers and other blocking work,
+     * declared after the lanes, so tasks drained on destruction can access them
+     */
+    std::unique_ptr<work_stealing_pool> worker_pool;
+
+    /**
+     * Overload controller for offloaded handlers, null if overload control is not enabled
+     */
+    std::unique_ptr<overload_controller> overload;
+
+    /**
+     * Concurrency limits of offloaded handlers, keys contain method and resource
+     */
+    std::unordered_map<std::string, std::shared_ptr<adaptive_limit>> route_limits;
+
+    /**
+     * Upper bound of the concurrency limits of offloaded handlers
+     */
+    uint32_t route_limit_max;
+
+    /**
+     * Time limits of handlers, keys contain method and resource
+     */
+    std::unordered_map<std::string, std::chrono::milliseconds> handler_deadlines;
+
+    /**
+     * Maximum number of pipelined requests handled concurrently on a single connection
+     */
+    uint32_t pipeline_depth;
+
 public:
     ~http_server() STATICLIB_HTTPSERVER_NOEXCEPT;
     
@@ -220,6 +277,109 @@ public:
     void add_handler(const std::string& method, const std::string& resource,
             request_handler_type request_handler);
 
+    /**
+     * Adds a new web service to the HTTP server, its handler is run in the
+     * worker pool instead of the IO thread, so it may block or perform
+     * CPU-heavy computations without delaying other connections; filters
+     * are still run in the IO thread and may choose another lane for the request
+     *
+     * @param method HTTP method name
+     * @param resource the resource name or uri-stem to bind to the handler
+     * @param request_handler function used to handle requests to the resource
+     * @param lane_idx (optional) priority lane for the requests to the resource
+     */
+    void add_offloaded_handler(const std::string& method, const std::string& resource,
+            request_handler_type request_handler, uint32_t lane_idx = priority_lanes::DEFAULT_LANE);
+
+    /**
+     * Adds a priority lane for offloaded handlers
+     * 
+     * @param name lane name used in logs and stats
+     * @param weight relative share of worker threads given to this lane
+     * @param max_running (optional) maximum number of running handlers from this lane, zero for no limit
+     * @return index of the new lane
+     */
+    uint32_t add_priority_lane(const std::string& name, uint32_t weight, uint32_t max_running = 0);
+
+    /**
+     * Returns the priority lanes of offloaded handlers, may be used
+     * to read queue-time metrics or to post other work into the lanes
+     * 
+     * @return priority lanes
+     */
+    priority_lanes& get_priority_lanes();
+
+    /**
+     * Returns the pool of worker threads, handlers may post blocking
+     * or CPU-heavy work there; pool is started on the first use and
+     * is stopped with the server after all the posted work is finished
+     * 
+     * @return worker pool
+     */
+    work_stealing_pool& get_worker_pool();
+
+    /**
+     * Sets the number of threads in the worker pool and the number of
+     * offloaded handlers that may run at the same time, number of CPU
+     * cores is used by default. Must be called before the pool is used.
+     * 
+     * @param number_of_threads number of worker threads
+     */
+    void set_worker_threads(uint32_t number_of_threads);
+
+    /**
+     * Enables overload control for offloaded handlers: queue delay from
+     * the moment request is read to the start of its handler is measured,
+     * when it stays above target, new requests to offloaded handlers are
+     * rejected with "503 Service Unavailable" before running filters or
+     * reading request body; requests are also rejected when the number of
+     * requests in flight for the handler reaches its limit, limits are
+     * adjusted with AIMD using the same queue delay.
+     * Must be called before the server is started.
+     * 
+     * @param limit_max upper bound of the concurrency limits of offloaded handlers
+     * @param target_delay (optional) acceptable queue delay
+     * @param interval (optional) time during which queue delay should stay
+     *        above target to consider server overloaded
+     */
+    void enable_overload_control(uint32_t limit_max,
+            std::chrono::milliseconds target_delay = overload_controller::DEFAULT_TARGET_DELAY,
+            std::chrono::milliseconds interval = overload_controller::DEFAULT_INTERVAL);
+
+    /**
+     * Returns overload controller, may be used to read the number of rejected requests
+     * 
+     * @return overload controller
+     * @throws httpserver_exception if overload control is not enabled
+     */
+    overload_controller& get_overload_controller();
+
+    /**
+     * Returns the concurrency limit of offloaded handler
+     * 
+     * @param method HTTP method name
+     * @param resource the resource name or uri-stem the handler is bound to
+     * @return concurrency limit
+     * @throws httpserver_exception if overload control is not enabled or handler is not found
+     */
+    const adaptive_limit& get_route_limit(const std::string& method, const std::string& resource);
+
+    /**
+     * Limits the time the handler may take before it starts sending the response,
+     * the time is counted from the moment the request is passed to the filters of
+     * the route, so it includes filters and, for offloaded handlers, the time spent
+     * waiting for a worker thread; when it expires, "504 Gateway Timeout" is sent
+     * and the connection is shut down, request cancellation token is cancelled,
+     * responses sent by the handler afterwards are discarded.
+     * Must be called before the server is started.
+     * 
+     * @param method HTTP method name
+     * @param resource the resource name or uri-stem the handler is bound to
+     * @param timeout time limit for the handler
+     */
+    void set_handler_deadline(const std::string& method, const std::string& resource,
+            std::chrono::milliseconds timeout);
+
     /**
      * Sets the function that handles bad HTTP requests
      * 
@@ -240,6 +400,41 @@ public:
      * @param h the function that handles requests which match no other web services
      */
     void set_error_handler(error_handler_type handler);
+
+    /**
+     * Sets maximum allowed ratio between decoded and encoded sizes for the
+     * request bodies with "gzip" or "deflate" content encoding, such bodies
+     * are decoded before passing them to payload handlers when the library
+     * is built with zlib support; request is rejected when limit is exceeded
+     * 
+     * @param ratio_max maximum allowed ratio
+     */
+    void set_inflate_ratio_max(uint32_t ratio_max);
+
+    /**
+     * Sets maximum number of pipelined requests that are handled concurrently
+     * on a single connection, requests that are already read completely are
+     * passed to handlers together and their responses are sent in request order,
+     * responses that are ready at the same time are sent with a single write.
+     * Filters and handlers of the batch requests are run in the worker pool,
+     * including the ones added with "add_handler".
+     * Responses must be sent with "http_response_writer" or "http_canned_response".
+     * Default value 1 disables concurrent handling.
+     * 
+     * @param depth maximum number of requests handled concurrently
+     */
+    void set_pipeline_depth(uint32_t depth);
+
+    /**
+     * Adds a header that will be sent with every response (e.g. "Server"
+     * or security headers), "Date" header is always sent; header block is
+     * precomputed and is not checked for duplicates with headers
+     * set by request handlers. Must be called before the server is started.
+     * 
+     * @param name header name
+     * @param value header value
+     */
+    void add_common_header(const std::string& name, const std::string& value);
     
     /**
      * Adds a new payload_handler to the HTTP server
@@ -261,6 +456,21 @@ public:
     void add_filter(const std::string& method, const std::string& resource,
             request_filter_type filter);
 
+    /**
+     * Adds a filter that limits the rate of requests per client with token buckets,
+     * requests over the limit are answered with "429 Too Many Requests"
+     *
+     * @param method HTTP method name
+     * @param resource the resource name or uri-stem to bind the filter to
+     * @param rate number of requests per second allowed for a single client
+     * @param burst number of requests a client may send at once after being idle
+     * @param key (optional) function that returns client key for the request,
+     *        remote IP address is used by default
+     * @return rate limiter used by the filter, may be shared with other filters
+     */
+    std::shared_ptr<rate_limiter> add_rate_limit(const std::string& method, const std::string& resource,
+            double rate, double burst, rate_limit_key_type key = nullptr);
+
 protected:
     
     /**
@@ -269,6 +479,16 @@ protected:
      * @param tcp_conn the new TCP connection to handle
      */
     virtual void handle_connection(tcp_connection_ptr& conn) override;
+
+    /**
+     * Starts the timer that updates common headers block
+     */
+    virtual void before_starting() override;
+
+    /**
+     * Stops the timer that updates common headers block
+     */
+    virtual void after_stopping() override;
     
     /**
      * Handles a new HTTP request
@@ -290,6 +510,36 @@ protected:
      */
     virtual void handle_request(http_request_ptr request,
             tcp_connection_ptr& conn, const asio::error_code& ec);
+
+    /**
+     * Parses pipelined requests that follow the specified one in the read buffer
+     * and passes them all to handlers
+     *
+     * @param request the first HTTP request of the batch
+     * @param conn TCP connection containing the requests
+     */
+    void handle_pipelined_requests(http_request_ptr request, tcp_connection_ptr& conn);
+
+    /**
+     * Runs filters and handler of a pipelined request in the worker pool,
+     * so the handlers of the batch run concurrently
+     *
+     * @param request the HTTP request to handle
+     * @param conn TCP connection containing the request
+     * @param chain filters and handler of the request
+     */
+    void dispatch_pipelined(http_request_ptr& request, tcp_connection_ptr& conn,
+            std::shared_ptr<http_filter_chain> chain);
+
+    /**
+     * Starts the deadline timer for the handler of the request
+     *
+     * @param request the HTTP request to handle
+     * @param conn TCP connection containing the request
+     * @param timeout time limit for the handler
+     */
+    void start_deadline(http_request_ptr& request, tcp_connection_ptr& conn,
+            std::chrono::milliseconds timeout);
    
     
 };    
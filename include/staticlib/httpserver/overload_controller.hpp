@@ -0,0 +1,315 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   overload_controller.hpp
+ * Author: agent
+ *
+ * Created on October 18, 2026, 9:39 PM
+ */
+
+#ifndef STATICLIB_HTTPSERVER_OVERLOAD_CONTROLLER_HPP
+#define	STATICLIB_HTTPSERVER_OVERLOAD_CONTROLLER_HPP
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+#include "staticlib/httpserver/config.hpp"
+#include "staticlib/httpserver/noncopyable.hpp"
+
+namespace staticlib {
+namespace httpserver {
+
+/**
+ * Concurrency limit of a single route adjusted with AIMD: the limit grows
+ * by one per the limit number of uncongested samples while at least half
+ * of it is used; on a congested sample the number of requests in flight
+ * multiplied by the decrease factor becomes the new limit, this happens
+ * at most once per backoff period
+ */
+class adaptive_limit : private staticlib::httpserver::noncopyable {
+    /**
+     * Mutex that guards the limit
+     */
+    mutable std::mutex m_mutex;
+
+    /**
+     * Current limit
+     */
+    double m_limit;
+
+    /**
+     * Lower bound of the limit
+     */
+    uint32_t m_min_limit;
+
+    /**
+     * Upper bound of the limit
+     */
+    uint32_t m_max_limit;
+
+    /**
+     * Number of admitted requests that are not finished yet
+     */
+    uint32_t m_in_flight;
+
+    /**
+     * Minimum time between decreases
+     */
+    std::chrono::steady_clock::duration m_backoff;
+
+    /**
+     * Time of the last decrease
+     */
+    std::chrono::steady_clock::time_point m_last_decrease;
+
+public:
+    /**
+     * Factor the limit is multiplied by on congestion
+     */
+    static const double DECREASE_FACTOR;
+
+    /**
+     * Constructor, limit starts from the upper bound
+     *
+     * @param min_limit lower bound of the limit
+     * @param max_limit upper bound of the limit
+     * @param backoff minimum time between decreases
+     */
+    adaptive_limit(uint32_t min_limit, uint32_t max_limit, std::chrono::steady_clock::duration backoff);
+
+    /**
+     * Takes a slot if the number of requests in flight is below the limit
+     *
+     * @return true if slot was taken
+     */
+    bool try_acquire();
+
+    /**
+     * Returns the slot taken by the finished request
+     */
+    void release();
+
+    /**
+     * Adjusts the limit using the queue delay of the started request
+     *
+     * @param congested whether queue delay was above target
+     */
+    void add_sample(bool congested);
+
+    /**
+     * Returns current limit
+     *
+     * @return current limit
+     */
+    uint32_t get_limit() const;
+
+    /**
+     * Returns number of requests in flight
+     *
+     * @return number of requests in flight
+     */
+    uint32_t get_in_flight() const;
+};
+
+/**
+ * Admission of a single request, keeps the route slot until
+ * the request is destroyed
+ */
+class overload_admission : private staticlib::httpserver::noncopyable {
+    /**
+     * Limit of the route, null if request was rejected
+     */
+    std::shared_ptr<adaptive_limit> m_limit;
+
+    /**
+     * Time since which request waits for the handler
+     */
+    std::chrono::steady_clock::time_point m_queued_since;
+
+public:
+    /**
+     * Constructor
+     *
+     * @param limit limit with the slot already taken, null if request was rejected
+     */
+    explicit overload_admission(std::shared_ptr<adaptive_limit> limit);
+
+    /**
+     * Destructor, releases the slot
+     */
+    ~overload_admission() STATICLIB_HTTPSERVER_NOEXCEPT;
+
+    /**
+     * Returns true if request was rejected
+     *
+     * @return whether request was rejected
+     */
+    bool is_rejected() const;
+
+    /**
+     * Marks the start of the wait for the handler
+     *
+     * @param time start time
+     */
+    void set_queued_since(std::chrono::steady_clock::time_point time);
+
+    /**
+     * Returns the time since which request waits for the handler
+     *
+     * @return start time
+     */
+    std::chrono::steady_clock::time_point get_queued_since() const;
+
+    /**
+     * Returns limit of the route
+     *
+     * @return limit, null if request was rejected
+     */
+    adaptive_limit* get_limit() const;
+};
+
+/**
+ * Overload detection based on CoDel (https://queue.acm.org/detail.cfm?id=2209336):
+ * the server is considered overloaded during the interval when the minimal queue
+ * delay observed in the previous interval was above target, that means a standing
+ * queue is built, bursts that are drained in one interval are not counted.
+ * New requests to controlled routes are rejected when the server is overloaded
+ * or when the route limit is reached.
+ */
+class overload_controller : private staticlib::httpserver::noncopyable {
+    /**
+     * Mutex that guards the interval state
+     */
+    std::mutex m_mutex;
+
+    /**
+     * Acceptable queue delay
+     */
+    std::chrono::steady_clock::duration m_target;
+
+    /**
+     * Length of the observation interval
+     */
+    std::chrono::steady_clock::duration m_interval;
+
+    /**
+     * End of the current interval
+     */
+    std::chrono::steady_clock::time_point m_interval_end;
+
+    /**
+     * Minimal delay observed in the current interval
+     */
+    std::chrono::steady_clock::duration m_interval_min;
+
+    /**
+     * Whether there were samples in the current interval
+     */
+    bool m_has_samples;
+
+    /**
+     * Whether the server is overloaded in the current interval
+     */
+    bool m_overloaded;
+
+    /**
+     * Number of rejected requests
+     */
+    std::atomic<uint64_t> m_rejected_count;
+
+public:
+    /**
+     * Default acceptable queue delay
+     */
+    static const std::chrono::milliseconds DEFAULT_TARGET_DELAY;
+
+    /**
+     * Default length of the observation interval
+     */
+    static const std::chrono::milliseconds DEFAULT_INTERVAL;
+
+    /**
+     * Constructor
+     *
+     * @param target_delay acceptable queue delay
+     * @param interval length of the observation interval
+     */
+    overload_controller(std::chrono::steady_clock::duration target_delay,
+            std::chrono::steady_clock::duration interval);
+
+    /**
+     * Decides whether the request to the route is admitted,
+     * rejected requests are counted
+     *
+     * @param limit limit of the route
+     * @return admission of the request
+     */
+    std::shared_ptr<overload_admission> admit(const std::shared_ptr<adaptive_limit>& limit);
+
+    /**
+     * Records queue delay of the request whose handler starts now
+     * and adjusts the route limit
+     *
+     * @param admission admission of the request
+     */
+    void handler_started(const overload_admission& admission);
+
+    /**
+     * Returns true if the server is overloaded
+     *
+     * @return whether server is overloaded
+     */
+    bool is_overloaded();
+
+    /**
+     * Returns acceptable queue delay
+     *
+     * @return acceptable queue delay
+     */
+    std::chrono::steady_clock::duration get_target_delay() const;
+
+    /**
+     * Returns length of the observation interval
+     *
+     * @return length of the observation interval
+     */
+    std::chrono::steady_clock::duration get_interval() const;
+
+    /**
+     * Returns number of rejected requests
+     *
+     * @return number of rejected requests
+     */
+    uint64_t get_rejected_count() const;
+
+private:
+    /**
+     * Starts the new interval if the current one is over,
+     * must be called with mutex locked
+     *
+     * @param now current time
+     */
+    void roll_interval(std::chrono::steady_clock::time_point now);
+};
+
+} // namespace
+}
+
+#endif	/* STATICLIB_HTTPSERVER_OVERLOAD_CONTROLLER_HPP */
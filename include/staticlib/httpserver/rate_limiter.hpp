@@ -0,0 +1,173 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   rate_limiter.hpp
+ * Author: agent
+ *
+ * Created on October 18, 2026, 9:50 PM
+ */
+
+#ifndef STATICLIB_HTTPSERVER_RATE_LIMITER_HPP
+#define	STATICLIB_HTTPSERVER_RATE_LIMITER_HPP
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "staticlib/httpserver/config.hpp"
+#include "staticlib/httpserver/noncopyable.hpp"
+
+namespace staticlib {
+namespace httpserver {
+
+/**
+ * Token bucket rate limiter for many keys (e.g. client IP addresses),
+ * buckets are spread between lock-striped shards, so threads checking
+ * different keys rarely contend on the same mutex. Buckets that were idle
+ * long enough to refill completely are dropped lazily.
+ */
+class rate_limiter : private staticlib::httpserver::noncopyable {
+    class stripe;
+
+    /**
+     * Shards of the buckets map
+     */
+    std::vector<std::unique_ptr<stripe>> m_stripes;
+
+    /**
+     * Tokens added to the bucket per second
+     */
+    double m_rate;
+
+    /**
+     * Bucket capacity
+     */
+    double m_burst;
+
+public:
+    /**
+     * Number of shards
+     */
+    static const std::size_t STRIPES_COUNT;
+
+    /**
+     * Constructor
+     *
+     * @param rate number of tokens added to the bucket per second
+     * @param burst bucket capacity, new buckets are full
+     */
+    rate_limiter(double rate, double burst);
+
+    /**
+     * Destructor
+     */
+    ~rate_limiter() STATICLIB_HTTPSERVER_NOEXCEPT;
+
+    /**
+     * Takes tokens from the bucket of the specified key
+     *
+     * @param key bucket key
+     * @param tokens number of tokens to take
+     * @return true if bucket had enough tokens
+     */
+    bool try_acquire(const std::string& key, double tokens = 1);
+
+    /**
+     * Returns approximate number of buckets
+     *
+     * @return number of buckets
+     */
+    std::size_t get_keys_count() const;
+
+private:
+    /**
+     * Chooses the shard for the key
+     *
+     * @param key bucket key
+     * @return shard
+     */
+    stripe& choose_stripe(const std::string& key) const;
+};
+
+/**
+ * Counter of concurrent connections per key (e.g. client IP address),
+ * lock-striped the same way as rate_limiter
+ */
+class connection_limiter : private staticlib::httpserver::noncopyable {
+    class stripe;
+
+    /**
+     * Shards of the counters map
+     */
+    std::vector<std::unique_ptr<stripe>> m_stripes;
+
+    /**
+     * Maximum number of connections per key
+     */
+    uint32_t m_max_per_key;
+
+public:
+    /**
+     * Constructor
+     *
+     * @param max_per_key maximum number of connections per key
+     */
+    explicit connection_limiter(uint32_t max_per_key);
+
+    /**
+     * Destructor
+     */
+    ~connection_limiter() STATICLIB_HTTPSERVER_NOEXCEPT;
+
+    /**
+     * Counts new connection if the limit for the key is not reached
+     *
+     * @param key connection key
+     * @return true if connection was counted
+     */
+    bool try_acquire(const std::string& key);
+
+    /**
+     * Removes connection from the counter
+     *
+     * @param key connection key
+     */
+    void release(const std::string& key);
+
+    /**
+     * Returns number of connections for the key
+     *
+     * @param key connection key
+     * @return number of connections
+     */
+    uint32_t get_count(const std::string& key) const;
+
+private:
+    /**
+     * Chooses the shard for the key
+     *
+     * @param key connection key
+     * @return shard
+     */
+    stripe& choose_stripe(const std::string& key) const;
+};
+
+} // namespace
+}
+
+#endif	/* STATICLIB_HTTPSERVER_RATE_LIMITER_HPP */
@@ -0,0 +1,184 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   response_pipeline.hpp
+ * Author: agent
+ *
+ * Created on October 18, 2026, 11:31 PM
+ */
+
+#ifndef STATICLIB_HTTPSERVER_RESPONSE_PIPELINE_HPP
+#define	STATICLIB_HTTPSERVER_RESPONSE_PIPELINE_HPP
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "asio.hpp"
+
+#include "staticlib/httpserver/config.hpp"
+#include "staticlib/httpserver/noncopyable.hpp"
+#include "staticlib/httpserver/tcp_connection.hpp"
+
+namespace staticlib {
+namespace httpserver {
+
+/**
+ * Responses to a batch of pipelined requests that are handled concurrently;
+ * writes of each response are held until all preceding responses are written,
+ * writes that become ready together are sent with a single gathered operation.
+ * Response is considered written after its last write or after the
+ * connection is finished for it, connection must be finished once
+ * for every response in request order.
+ */
+class response_pipeline : public std::enable_shared_from_this<response_pipeline>,
+        private staticlib::httpserver::noncopyable {
+    class entry;
+    class slot;
+
+    /**
+     * Mutex that guards the state
+     */
+    std::mutex m_mutex;
+
+    /**
+     * Responses in request order
+     */
+    std::vector<std::unique_ptr<slot>> m_slots;
+
+    /**
+     * Index of the first response that is not completely written
+     */
+    std::size_t m_write_head;
+
+    /**
+     * Number of responses the connection was finished for
+     */
+    std::size_t m_finished_count;
+
+    /**
+     * Whether writes are allowed, writes made before are gathered
+     */
+    bool m_started;
+
+    /**
+     * Whether a write is in progress
+     */
+    bool m_writing;
+
+public:
+    /**
+     * Operation that writes to the connection exclusively and calls the handler when done
+     */
+    using operation_type = std::function<void(tcp_connection::io_handler_type)>;
+
+    /**
+     * Constructor
+     */
+    response_pipeline();
+
+    /**
+     * Destructor
+     */
+    ~response_pipeline() STATICLIB_HTTPSERVER_NOEXCEPT;
+
+    /**
+     * Adds response for the next request of the batch
+     *
+     * @param keep_alive whether response should keep the connection alive
+     * @return index of the response
+     */
+    std::size_t add_response(bool keep_alive);
+
+    /**
+     * Returns number of responses in the batch
+     *
+     * @return number of responses
+     */
+    std::size_t get_size();
+
+    /**
+     * Returns true if response should keep the connection alive
+     *
+     * @param idx index of the response
+     * @return whether response should keep the connection alive
+     */
+    bool get_keep_alive(std::size_t idx);
+
+    /**
+     * Allows writes and sends the responses written so far
+     *
+     * @param conn connection of the batch
+     */
+    void start(tcp_connection_ptr& conn);
+
+    /**
+     * Writes data of the response to the connection in order
+     *
+     * @param conn connection of the batch
+     * @param idx index of the response
+     * @param buffers data to write, must stay valid until the handler is called
+     * @param last whether this is the last write of the response
+     * @param handler called after the data has been written
+     */
+    void async_write(tcp_connection_ptr& conn, std::size_t idx, const std::vector<asio::const_buffer>& buffers,
+            bool last, tcp_connection::io_handler_type handler);
+
+    /**
+     * Runs the operation that writes data of the response to the connection in order,
+     * no other writes are made while it runs
+     *
+     * @param conn connection of the batch
+     * @param idx index of the response
+     * @param last whether this is the last write of the response
+     * @param operation write operation, it is passed the function to call when done
+     * @param handler called after the operation has completed
+     */
+    void run(tcp_connection_ptr& conn, std::size_t idx, bool last, operation_type operation,
+            tcp_connection::io_handler_type handler);
+
+    /**
+     * Counts the finished response
+     *
+     * @param conn connection of the batch
+     * @return true if connection was finished for all responses of the batch
+     */
+    bool finish_response(tcp_connection_ptr& conn);
+
+private:
+    /**
+     * Queues the write of the response and starts writing if possible
+     *
+     * @param conn connection of the batch
+     * @param idx index of the response
+     * @param en write to queue
+     */
+    void enqueue(tcp_connection_ptr& conn, std::size_t idx, entry en);
+
+    /**
+     * Sends queued writes that are allowed to go next
+     *
+     * @param conn connection of the batch
+     */
+    void flush(tcp_connection_ptr& conn);
+};
+
+} // namespace
+}
+
+#endif	/* STATICLIB_HTTPSERVER_RESPONSE_PIPELINE_HPP */
@@ -26,11 +26,14 @@
 #ifndef STATICLIB_HTTPSERVER_SCHEDULER_HPP
 #define STATICLIB_HTTPSERVER_SCHEDULER_HPP
 
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <deque>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <thread>
 #include <vector>
 #include <cassert>
@@ -106,9 +109,55 @@ protected:
      * True if the thread scheduler is running
      */
     bool m_is_running;    
+
+    /**
+     * Time IO threads poll for ready handlers before blocking, zero to always block
+     */
+    std::chrono::microseconds m_busy_poll_interval;
+
+    /**
+     * CPUs to pin IO threads to, empty if threads are not pinned
+     */
+    std::vector<uint32_t> m_cpu_affinity;
+
+    /**
+     * Nanoseconds spent polling without finding handlers
+     */
+    std::atomic<uint64_t> m_spin_nanos;
+
+    /**
+     * Nanoseconds spent blocked waiting for handlers
+     */
+    std::atomic<uint64_t> m_block_nanos;
+
+    /**
+     * Number of times IO threads blocked after polling
+     */
+    std::atomic<uint64_t> m_blocks_count;
     
 public:
 
+    /**
+     * Time IO threads spent spinning and blocking in busy-poll mode
+     */
+    struct busy_poll_stats {
+        /**
+         * Microseconds spent polling without finding handlers
+         */
+        uint64_t spin_micros;
+
+        /**
+         * Microseconds spent blocked waiting for handlers, includes
+         * the run time of the handlers that woke threads up
+         */
+        uint64_t block_micros;
+
+        /**
+         * Number of times threads found no handlers for the whole interval and blocked
+         */
+        uint64_t blocks_count;
+    };
+
     /**
      * Constructor
      */
@@ -180,6 +229,31 @@ public:
      * @return logger instance
      */
     logger get_logger(void);
+
+    /**
+     * Enables busy-poll mode: IO threads keep polling the IO service for ready
+     * handlers and block only after finding none for the specified interval,
+     * this removes the wake-up latency at the cost of CPU time.
+     * Must be called before the scheduler is started.
+     * 
+     * @param spin_interval time to poll before blocking, zero to disable busy-poll
+     */
+    void set_busy_poll(std::chrono::microseconds spin_interval);
+
+    /**
+     * Pins IO threads to CPUs, thread N is pinned to 'cpus[N % cpus.size()]',
+     * supported only on Linux. Must be called before the scheduler is started.
+     * 
+     * @param cpus CPU indices, empty to not pin threads
+     */
+    void set_cpu_affinity(std::vector<uint32_t> cpus);
+
+    /**
+     * Returns time IO threads spent spinning and blocking in busy-poll mode
+     * 
+     * @return busy-poll counters
+     */
+    busy_poll_stats get_busy_poll_stats() const;
     
     /**
      * Returns an async I/O service used to schedule work
@@ -236,6 +310,22 @@ public:
 
 protected:
 
+    /**
+     * Pins the current thread to the CPU from the affinity list, does nothing
+     * if the list is empty
+     * 
+     * @param thread_idx index of the thread in the pool
+     */
+    void pin_current_thread(uint32_t thread_idx);
+
+    /**
+     * Runs handlers of the IO service polling it before blocking,
+     * returns when the service is stopped
+     * 
+     * @param service asio service
+     */
+    void busy_poll(asio::io_service& service);
+
     /**
      * Stops all services used to schedule work
      */
@@ -352,6 +442,327 @@ protected:
      */
     virtual void finish_services();
 };
+
+
+/**
+ * Pool of worker threads for blocking and CPU-heavy work, separate from
+ * the threads that run IO services. Each worker has its own deques of tasks:
+ * tasks posted from a worker thread are pushed to its own deque and taken
+ * back in LIFO order, tasks posted from other threads are distributed
+ * between workers in turn and are taken in FIFO order; idle workers steal
+ * the oldest tasks from the others. Pool is started on the first post,
+ * posts made after the shutdown are rejected until it is started again.
+ */
+class work_stealing_pool : private staticlib::httpserver::noncopyable {
+    class worker;
+
+    /**
+     * Primary logging interface used by this class
+     */
+    logger m_logger;
+
+    /**
+     * Mutex used to start and stop the pool and to put workers to sleep
+     */
+    std::mutex m_mutex;
+
+    /**
+     * Condition triggered when tasks are posted or the pool is stopped
+     */
+    std::condition_variable m_work_available;
+
+    /**
+     * Workers with their deques
+     */
+    std::vector<std::unique_ptr<worker>> m_workers;
+
+    /**
+     * Worker threads
+     */
+    std::vector<std::thread> m_threads;
+
+    /**
+     * Number of worker threads
+     */
+    uint32_t m_num_threads;
+
+    /**
+     * Number of posted tasks that are not taken by workers yet
+     */
+    std::atomic<std::size_t> m_pending;
+
+    /**
+     * Number of workers waiting for tasks
+     */
+    std::atomic<uint32_t> m_sleeping;
+
+    /**
+     * Counter used to distribute tasks posted from other threads
+     */
+    std::atomic<std::size_t> m_next_worker;
+
+    /**
+     * True if the pool is running
+     */
+    std::atomic<bool> m_is_running;
+
+    /**
+     * True if the pool was shut down and was not started again
+     */
+    std::atomic<bool> m_is_shut_down;
+
+public:
+    /**
+     * Constructor
+     * 
+     * @param num_threads number of worker threads, zero to use the number of CPU cores
+     */
+    explicit work_stealing_pool(uint32_t num_threads = 0);
+
+    /**
+     * Destructor, calls shutdown
+     */
+    ~work_stealing_pool();
+
+    /**
+     * Starts the worker threads (this is called automatically when necessary)
+     */
+    void startup();
+
+    /**
+     * Stops the worker threads after all the posted tasks are finished
+     */
+    void shutdown();
+
+    /**
+     * Returns true if the pool is running
+     * 
+     * @return whether pool is running
+     */
+    bool is_running() const;
+
+    /**
+     * Returns true if the pool was shut down and was not started again
+     * 
+     * @return whether pool is shut down
+     */
+    bool is_shut_down() const;
+
+    /**
+     * Sets the number of worker threads, takes effect only if the pool
+     * was not started yet, workers are created once on the first startup
+     * 
+     * @param n number of threads, zero to use the number of CPU cores
+     */
+    void set_num_threads(const uint32_t n);
+
+    /**
+     * Returns the number of worker threads
+     * 
+     * @return number of threads
+     */
+    uint32_t get_num_threads() const;
+
+    /**
+     * Schedules work to be performed by one of the worker threads,
+     * exceptions thrown by the work function are logged; tasks posted
+     * from the worker threads are accepted while the pool is draining
+     *
+     * @param work_func work function to be executed
+     * @throws httpserver_exception if the pool is shut down
+     */
+    void post(std::function<void()> work_func);
+
+private:
+    /**
+     * Thread function of the worker
+     * 
+     * @param idx worker index
+     */
+    void run(std::size_t idx);
+
+    /**
+     * Takes the newest task posted by the worker itself, or the oldest task
+     * posted from outside, or steals the oldest one from the other workers
+     * 
+     * @param idx worker index
+     * @param task set to the task taken
+     * @return true if the task was taken
+     */
+    bool take_task(std::size_t idx, std::function<void()>& task);
+};
+
+/**
+ * Priority lanes placed in front of an executor (usually a worker pool):
+ * work is queued per lane and is passed to the executor only when the number
+ * of running tasks is below the limit, so the executor queue stays short and
+ * the order of execution is chosen here. Lanes are served with weighted fair
+ * queuing: each lane gets a share of executor slots proportional to its weight
+ * while it has queued work. Work is FIFO inside the lane.
+ */
+class priority_lanes : private staticlib::httpserver::noncopyable {
+public:
+    /**
+     * Function that runs the work passed to it
+     */
+    using executor_type = std::function<void(std::function<void()>)>;
+
+    /**
+     * Index of the lane created by constructor, it has the weight of 1 and no concurrency limit
+     */
+    static const uint32_t DEFAULT_LANE;
+
+    /**
+     * Snapshot of the lane state and queue-time metrics
+     */
+    struct lane_stats {
+        /**
+         * Lane name
+         */
+        std::string name;
+
+        /**
+         * Lane weight
+         */
+        uint32_t weight;
+
+        /**
+         * Maximum number of running tasks from this lane, zero for no limit
+         */
+        uint32_t max_running;
+
+        /**
+         * Number of tasks waiting in the lane
+         */
+        std::size_t queued;
+
+        /**
+         * Number of tasks running now
+         */
+        std::size_t running;
+
+        /**
+         * Number of tasks passed to the executor
+         */
+        uint64_t dispatched;
+
+        /**
+         * Sum of the time spent by dispatched tasks in the queue, in microseconds
+         */
+        uint64_t queue_time_total_micros;
+
+        /**
+         * Longest time spent by a task in the queue, in microseconds
+         */
+        uint64_t queue_time_max_micros;
+    };
+
+private:
+    class lane;
+
+    /**
+     * Mutex that guards all the lanes
+     */
+    mutable std::mutex m_mutex;
+
+    /**
+     * Function that runs dispatched work
+     */
+    executor_type m_executor;
+
+    /**
+     * Lanes in the order of creation
+     */
+    std::vector<std::unique_ptr<lane>> m_lanes;
+
+    /**
+     * Maximum number of running tasks from all lanes
+     */
+    uint32_t m_max_running;
+
+    /**
+     * Number of running tasks from all lanes
+     */
+    uint32_t m_running;
+
+    /**
+     * Virtual time of the last dispatched task
+     */
+    uint64_t m_virtual_time;
+
+public:
+    /**
+     * Constructor
+     * 
+     * @param executor function that runs dispatched work
+     * @param max_running maximum number of tasks passed to the executor
+     *        at the same time, usually equal to the number of its threads
+     */
+    priority_lanes(executor_type executor, uint32_t max_running);
+
+    /**
+     * Destructor
+     */
+    ~priority_lanes();
+
+    /**
+     * Adds a new lane
+     * 
+     * @param name lane name used in logs and stats
+     * @param weight relative share of executor slots given to this lane
+     * @param max_running maximum number of running tasks from this lane, zero for no limit
+     * @return index of the new lane
+     */
+    uint32_t add_lane(const std::string& name, uint32_t weight, uint32_t max_running = 0);
+
+    /**
+     * Sets the maximum number of tasks passed to the executor at the same time
+     * 
+     * @param max_running number of tasks
+     */
+    void set_max_running(uint32_t max_running);
+
+    /**
+     * Returns the number of lanes
+     * 
+     * @return number of lanes
+     */
+    std::size_t get_lanes_count() const;
+
+    /**
+     * Returns the state and queue-time metrics of the lane
+     * 
+     * @param lane_idx lane index
+     * @return lane stats
+     */
+    lane_stats get_stats(uint32_t lane_idx) const;
+
+    /**
+     * Queues work into the lane
+     * 
+     * @param lane_idx lane index
+     * @param work_func work function to be executed
+     * @throws httpserver_exception if lane index is invalid, errors
+     *         of the executor are propagated if it rejects the work
+     */
+    void post(uint32_t lane_idx, std::function<void()> work_func);
+
+private:
+    /**
+     * Passes queued work to the executor while there are free slots,
+     * the lock is released while executor is called
+     * 
+     * @param lock lock owning the mutex
+     */
+    void dispatch(std::unique_lock<std::mutex>& lock);
+
+    /**
+     * Releases the slot taken by the finished task
+     * 
+     * @param lane_idx lane index
+     */
+    void finished(std::size_t lane_idx);
+};
         
 } // namespace
 }
@@ -27,9 +27,14 @@
 #define STATICLIB_HTTPSERVER_TCP_CONNECTION_HPP
 
 #include <array>
+#include <atomic>
+#include <chrono>
 #include <functional>
 #include <memory>
+#include <new>
 #include <string>
+#include <vector>
+#include <cstdint>
 
 #include "asio.hpp"
 #ifdef STATICLIB_HTTPSERVER_HAVE_SSL
@@ -38,11 +43,53 @@
 
 #include "staticlib/httpserver/algorithm.hpp"
 #include "staticlib/httpserver/config.hpp"
+#include "staticlib/httpserver/http_common_headers.hpp"
+#include "staticlib/httpserver/http_inflater.hpp"
 #include "staticlib/httpserver/noncopyable.hpp"
+#include "staticlib/httpserver/rate_limiter.hpp"
 
 namespace staticlib { 
 namespace httpserver {
 
+class response_pipeline;
+class uring_transport;
+
+/**
+ * Counters of the non-blocking reads and writes that are attempted
+ * before waiting for the socket readiness, shared by server connections
+ */
+class speculative_io_counters : private staticlib::httpserver::noncopyable {
+public:
+    /**
+     * Reads that completed without waiting
+     */
+    std::atomic<uint64_t> reads_completed;
+
+    /**
+     * Reads that found no data and were passed to the reactor
+     */
+    std::atomic<uint64_t> reads_would_block;
+
+    /**
+     * Writes that completed without waiting
+     */
+    std::atomic<uint64_t> writes_completed;
+
+    /**
+     * Writes that did not fit into the socket buffer, rest was passed to the reactor
+     */
+    std::atomic<uint64_t> writes_would_block;
+
+    /**
+     * Constructor
+     */
+    speculative_io_counters() :
+    reads_completed(0),
+    reads_would_block(0),
+    writes_completed(0),
+    writes_would_block(0) { }
+};
+
 /**
  * Represents a single tcp connection
  */
@@ -64,11 +111,30 @@ public:
      * Size of the read buffer
      */
     enum { READ_BUFFER_SIZE = 8192 };
+
+    /**
+     * Maximum number of buffers in a read or write that is done without the reactor
+     */
+    enum { SPECULATIVE_WRITE_BUFFERS_MAX = 64 };
+
+    /**
+     * Slow client deadlines of the connection
+     */
+    enum deadline_type {
+        DEADLINE_NONE,
+        DEADLINE_HEADERS,
+        DEADLINE_WRITE
+    };
     
     /**
      * Data type for a function that handles TCP connection objects
      */
     using connection_handler = std::function<void(std::shared_ptr<tcp_connection>&)>;
+
+    /**
+     * Data type for a function called after I/O operation has completed
+     */
+    using io_handler_type = std::function<void(const asio::error_code&, std::size_t)>;
     
     /**
      * Data type for an I/O read buffer
@@ -114,6 +180,41 @@ public:
     
 private:
 
+    /**
+     * Task posted to the connection, tasks are linked into a list
+     */
+    class task {
+    public:
+        task* next = nullptr;
+
+        std::size_t size = 0;
+
+        virtual ~task() { }
+
+        virtual void run() { }
+    };
+
+    /**
+     * Task that calls the specified handler
+     */
+    template <typename Handler>
+    class handler_task : public task {
+        Handler m_handler;
+
+    public:
+        explicit handler_task(Handler handler) :
+        m_handler(std::move(handler)) { }
+
+        virtual void run() override {
+            m_handler();
+        }
+    };
+
+    /**
+     * Marker placed into the tasks stack while the tasks are being run
+     */
+    static task TASKS_RUNNING;
+
     /**
      * SSL connection socket
      */
@@ -144,6 +245,101 @@ private:
      */
     connection_handler m_finished_handler;        
 
+    /**
+     * Pipe used to splice data from socket to files, created lazily
+     */
+    std::array<int, 2> m_splice_pipe;
+
+    /**
+     * Capacity of the splice pipe
+     */
+    std::size_t m_splice_pipe_size;
+
+    /**
+     * Headers block added to all responses sent over this connection, owned by server
+     */
+    const http_common_headers* m_common_headers;
+
+    /**
+     * Lock-free stack of posted tasks (in reverse order), null if no
+     * tasks are running, 'TASKS_RUNNING' if they are running and none is pending
+     */
+    std::atomic<task*> m_tasks_head;
+
+    /**
+     * Tasks taken from the stack (in posting order) that are not run yet,
+     * accessed only by the thread running the tasks
+     */
+    task* m_tasks_list;
+
+    /**
+     * Memory block of a finished task kept for the next one; tasks are often
+     * created and run in different threads, so per-thread pools do not help
+     */
+    std::atomic<void*> m_spare_task;
+
+    /**
+     * Per-client connections counter this connection is counted in, may be null
+     */
+    std::shared_ptr<connection_limiter> m_connection_limiter;
+
+    /**
+     * Key of this connection in the per-client connections counter
+     */
+    std::string m_connection_limiter_key;
+
+    /**
+     * Time limit for receiving request headers, zero if not limited
+     */
+    std::chrono::steady_clock::duration m_header_timeout;
+
+    /**
+     * Base time limit for a write operation, zero if writes are not limited
+     */
+    std::chrono::steady_clock::duration m_write_timeout;
+
+    /**
+     * Minimum write bandwidth in bytes per second, zero if not limited
+     */
+    uint32_t m_min_write_rate;
+
+    /**
+     * Time (in steady clock ticks) when request headers must be received, zero if not armed
+     */
+    std::atomic<std::chrono::steady_clock::rep> m_header_deadline;
+
+    /**
+     * Time (in steady clock ticks) when the current write must complete, zero if not armed
+     */
+    std::atomic<std::chrono::steady_clock::rep> m_write_deadline;
+
+    /**
+     * Responses to the batch of pipelined requests in progress, may be null
+     */
+    std::shared_ptr<response_pipeline> m_response_pipeline;
+
+    /**
+     * Whether 'TCP_NODELAY' was enabled with 'set_no_delay', restored after the pipelined batch
+     */
+    bool m_no_delay;
+
+    /**
+     * Counters of non-blocking operations, null if reads and writes always wait for the reactor
+     */
+    std::shared_ptr<speculative_io_counters> m_speculative_io;
+
+    /**
+     * Transport used instead of the reactor for reads and writes, may be null
+     */
+    std::shared_ptr<uring_transport> m_uring;
+
+#ifdef STATICLIB_HTTPSERVER_HAVE_ZLIB
+    /**
+     * Request body decoder, reused for all requests of this connection
+     */
+    http_inflater m_inflater;
+#endif // STATICLIB_HTTPSERVER_HAVE_ZLIB
+
 public:
     
     /**
@@ -225,7 +421,12 @@ public:
                                          handler);
         else
 #endif      
+        if (m_uring) {
+            asio::mutable_buffer buffer(m_read_buffer.data(), m_read_buffer.size());
+            uring_read_some(std::addressof(buffer), 1, handler);
+        } else {
             m_ssl_socket.next_layer().async_read_some(asio::buffer(m_read_buffer), handler);
+        }
     }
     
     /**
@@ -243,7 +444,15 @@ public:
             m_ssl_socket.async_read_some(read_buffer, handler);
         else
 #endif      
-            m_ssl_socket.next_layer().async_read_some(read_buffer, handler);
+        {
+            std::array<asio::mutable_buffer, SPECULATIVE_WRITE_BUFFERS_MAX> buffers;
+            std::size_t count = m_uring ? copy_buffers(read_buffer, buffers.data(), buffers.size()) : 0;
+            if (count > 0) {
+                uring_read_some(buffers.data(), count, handler);
+            } else {
+                m_ssl_socket.next_layer().async_read_some(read_buffer, handler);
+            }
+        }
     }
     
     /**
@@ -375,13 +584,72 @@ public:
      */
     template <typename ConstBufferSequence, typename write_handler_t>
     void async_write(const ConstBufferSequence& buffers, write_handler_t handler) {
-#ifdef STATICLIB_HTTPSERVER_HAVE_SSL
-        if (get_ssl_flag())
-            asio::async_write(m_ssl_socket, buffers, handler);
-        else
-#endif      
-            asio::async_write(m_ssl_socket.next_layer(), buffers, handler);
-    }   
+        std::array<asio::const_buffer, SPECULATIVE_WRITE_BUFFERS_MAX> spec_buffers;
+        std::size_t count = 0;
+        if (m_speculative_io && !get_ssl_flag()) {
+            count = copy_buffers(buffers, spec_buffers.data(), spec_buffers.size());
+        }
+        if (0 == count) {
+            async_write_with_deadline(buffers, std::move(handler));
+            return;
+        }
+        // socket buffer usually has room for the whole response, so it is written
+        // right away and only the rest waits for the reactor, handler is not run inline
+        asio::error_code ec;
+        std::size_t written = try_write_some(spec_buffers.data(), count, ec);
+        if (asio::error::would_block != ec) {
+            get_io_service().post([handler, ec, written]() mutable {
+                handler(ec, written);
+            });
+            return;
+        }
+        if (0 == written) {
+            async_write_with_deadline(buffers, std::move(handler));
+            return;
+        }
+        std::vector<asio::const_buffer> rest;
+        std::size_t skip = written;
+        for (std::size_t i = 0; i < count; i++) {
+            std::size_t len = asio::buffer_size(spec_buffers[i]);
+            if (skip >= len) {
+                skip -= len;
+            } else {
+                rest.emplace_back(spec_buffers[i] + skip);
+                skip = 0;
+            }
+        }
+        async_write_with_deadline(rest, [handler, written](const asio::error_code& ec,
+                std::size_t bytes_written) mutable {
+            handler(ec, written + bytes_written);
+        });
+    }
+
+    /**
+     * Reads some data into the connection's read buffer without waiting,
+     * supported only for unencrypted connections on Linux
+     *
+     * @param ec set to "would_block" if no data is available or non-blocking reads are not enabled
+     * @return number of bytes read
+     */
+    std::size_t try_read_some(asio::error_code& ec);
+
+    /**
+     * Sets counters of non-blocking reads and writes, reads and writes are
+     * attempted without waiting for the reactor only if counters are set
+     *
+     * @param counters counters shared by server connections, may be null
+     */
+    void set_speculative_io(std::shared_ptr<speculative_io_counters> counters);
+
+    /**
+     * Sets transport that is used instead of the reactor for "async_read_some" and
+     * "async_write" calls, supported only for unencrypted connections; socket is
+     * left in blocking mode, so the ring waits for its readiness with a single request
+     *
+     * @param transport transport shared by server connections, may be null
+     */
+    void set_uring_transport(std::shared_ptr<uring_transport> transport);
+
         
     /**
      * Writes data to the connection (blocks until finished)
@@ -404,7 +672,188 @@ public:
     }   
     
     /**
-     * This function should be called when a server has finished handling the connection
+     * Returns true if data can be moved from this connection's socket
+     * to a file descriptor without copying to user space, requires Linux
+     * and unencrypted connection
+     * 
+     * @return true if splice operations are supported
+     */
+    bool is_splice_supported() const;
+
+    /**
+     * Asynchronously moves some data from the socket to the specified file
+     * descriptor (at its current offset) using splice() through a pipe;
+     * completes as soon as at least one byte is moved and no more data is
+     * available immediately
+     * 
+     * @param fd destination file descriptor
+     * @param max_len maximum number of bytes to move
+     * @param handler called after the splice operation has completed
+     */
+    void async_splice_some(int fd, std::size_t max_len, io_handler_type handler);
+
+    /**
+     * Asynchronously writes a region of the specified file to the connection;
+     * uses 'sendfile()' on Linux for unencrypted connections, reads the file
+     * in blocks with 'pread()' and writes them to the socket otherwise
+     * 
+     * @param fd source file descriptor
+     * @param offset offset of the region in file
+     * @param length length of the region in bytes
+     * @param handler called after the whole region has been written
+     */
+    void async_write_file(int fd, uint64_t offset, std::size_t length, io_handler_type handler);
+
+    /**
+     * Enables or disables 'TCP_CORK' on the socket, while enabled partial
+     * frames are not sent, so the data written with several operations
+     * (like headers followed by a file region) is packed into full segments;
+     * does nothing on platforms without 'TCP_CORK'
+     * 
+     * @param enabled whether to hold partial frames
+     */
+    void set_cork(bool enabled);
+
+    /**
+     * Enables or disables 'TCP_NODELAY' on the socket, while enabled small
+     * writes are sent without waiting for the acknowledgement of the previous ones
+     * 
+     * @param enabled whether to disable Nagle's algorithm
+     */
+    void set_no_delay(bool enabled);
+
+    /**
+     * Sets 'SO_BUSY_POLL' on the socket, while set the kernel polls the device
+     * queue for the specified time on reads that would otherwise block;
+     * setting it usually requires 'CAP_NET_ADMIN', supported only on Linux
+     * 
+     * @param interval polling time, zero to disable
+     * @return true if the option was set
+     */
+    bool set_busy_poll(std::chrono::microseconds interval);
+
+    /**
+     * Runs the specified handler using the io_service of this connection; handlers
+     * posted or dispatched to the same connection are run one at a time in order,
+     * so the writer and the connection can be used from them without locking.
+     * Can be called from any thread, handler is queued without locks.
+     * 
+     * @param handler function to run, must not throw
+     */
+    template <typename Handler>
+    void post(Handler handler) {
+        push_task(make_task(std::move(handler)));
+    }
+
+    /**
+     * Runs the specified handler in the calling thread if no other handler
+     * is running for this connection, posts it otherwise; used for
+     * I/O completion handlers
+     * 
+     * @param handler function to run
+     */
+    template <typename Handler>
+    void dispatch(Handler handler) {
+        task* idle = nullptr;
+        if (m_tasks_head.compare_exchange_strong(idle, std::addressof(TASKS_RUNNING))) {
+            try {
+                handler();
+            } catch (...) {
+                // tasks posted meanwhile are run after the error is reported
+                schedule_tasks();
+                throw;
+            }
+            run_tasks();
+        } else {
+            push_task(make_task(std::move(handler)));
+        }
+    }
+
+    /**
+     * Sets headers block that will be added to all responses sent over this connection
+     * 
+     * @param common_headers headers block, must outlive the connection, may be null
+     */
+    void set_common_headers(const http_common_headers* common_headers);
+
+    /**
+     * Returns headers block that should be added to all responses sent over this connection
+     * 
+     * @return headers block, null if not set
+     */
+    const http_common_headers* get_common_headers() const;
+
+    /**
+     * Sets the per-client connections counter this connection is counted in,
+     * connection is removed from it when this object is destroyed
+     * 
+     * @param limiter connections counter
+     * @param key key of this connection in the counter
+     */
+    void set_connection_limiter(std::shared_ptr<connection_limiter> limiter, std::string key);
+
+    /**
+     * Sets slow client limits for this connection, should be called before
+     * the first request is read
+     * 
+     * @param header_timeout time limit for receiving request headers, zero to disable
+     * @param write_timeout base time limit for a write operation, zero to disable
+     *        write limits
+     * @param min_write_rate minimum write bandwidth in bytes per second, each write
+     *        is allowed additional time for its length at this rate, zero to disable
+     */
+    void set_slow_client_limits(std::chrono::steady_clock::duration header_timeout,
+            std::chrono::steady_clock::duration write_timeout, uint32_t min_write_rate);
+
+    /**
+     * Arms the request headers deadline, does nothing if it is already armed
+     * or if headers are not limited
+     */
+    void start_header_deadline();
+
+    /**
+     * Disarms the request headers deadline
+     */
+    void stop_header_deadline();
+
+    /**
+     * Disarms the deadline that has passed, can be called from any thread
+     * 
+     * @param now current time
+     * @return kind of the passed deadline, 'DEADLINE_NONE' if no deadline has passed
+     */
+    deadline_type expire_deadline(std::chrono::steady_clock::time_point now);
+
+    /**
+     * Shuts down the socket in both directions, so pending and subsequent operations
+     * fail and the connection is finished by its own handlers; unlike close()
+     * can be called while the connection is used by another thread
+     */
+    void abort();
+
+#ifdef STATICLIB_HTTPSERVER_HAVE_ZLIB
+    /**
+     * Returns request body decoder owned by this connection, its zlib
+     * state is allocated on first use and reused for subsequent requests
+     * 
+     * @return request body decoder
+     */
+    http_inflater& get_inflater();
+#endif // STATICLIB_HTTPSERVER_HAVE_ZLIB
+    
+    /**
+     * Sets responses to the batch of pipelined requests that are handled
+     * concurrently, connection finish is reported only after all of them;
+     * responses of the batch that are not ready together are sent with separate
+     * writes, so 'TCP_NODELAY' is enabled until the batch is finished
+     * 
+     * @param pipeline batch responses
+     */
+    void set_response_pipeline(std::shared_ptr<response_pipeline> pipeline);
+
+    /**
+     * This function should be called when a server has finished handling the connection;
+     * during pipelined batch it should be called once for every request of the batch
      */
     void finish();
     
@@ -538,6 +987,214 @@ protected:
      */
     tcp_connection(asio::io_service& io_service, ssl_context_type& ssl_context, const bool ssl_flag,
             connection_handler finished_handler);
+
+private:
+
+    /**
+     * Asynchronously writes data to the connection through the reactor
+     *
+     * @param buffers one or more buffers containing the data to be written
+     * @param handler called after the data has been written
+     */
+    template <typename ConstBufferSequence, typename write_handler_t>
+    void async_write_with_deadline(const ConstBufferSequence& buffers, write_handler_t handler) {
+        if (m_write_timeout.count() > 0 && start_write_deadline(asio::buffer_size(buffers))) {
+            auto self = shared_from_this();
+            async_write_unchecked(buffers, [self, handler](const asio::error_code& ec,
+                    std::size_t bytes_written) mutable {
+                self->stop_write_deadline();
+                handler(ec, bytes_written);
+            });
+        } else {
+            // writes nested into the armed operation (like file blocks) share its deadline
+            async_write_unchecked(buffers, std::move(handler));
+        }
+    }
+
+    /**
+     * Copies buffers of the sequence into the array
+     *
+     * @param buffers buffer sequence
+     * @param dest destination array
+     * @param max_count size of the destination array
+     * @return number of buffers copied, zero if sequence does not fit into the array
+     */
+    template <typename BufferSequence, typename Buffer>
+    static std::size_t copy_buffers(const BufferSequence& buffers, Buffer* dest,
+            std::size_t max_count) {
+        std::size_t count = 0;
+        for (auto it = buffers.begin(); it != buffers.end(); ++it) {
+            if (count == max_count) return 0;
+            dest[count++] = *it;
+        }
+        return count;
+    }
+
+    /**
+     * Copies single buffer into the array
+     *
+     * @param buffer buffer
+     * @param dest destination array
+     * @param max_count size of the destination array
+     * @return number of buffers copied
+     */
+    static std::size_t copy_buffers(const asio::const_buffer& buffer, asio::const_buffer* dest,
+            std::size_t max_count);
+
+    /**
+     * Copies single buffer into the array
+     *
+     * @param buffer buffer
+     * @param dest destination array
+     * @param max_count size of the destination array
+     * @return number of buffers copied
+     */
+    static std::size_t copy_buffers(const asio::mutable_buffer& buffer, asio::mutable_buffer* dest,
+            std::size_t max_count);
+
+    /**
+     * Asynchronously reads some data using the transport
+     *
+     * @param buffers buffers to read into
+     * @param count number of buffers
+     * @param handler called after the read operation has completed
+     */
+    void uring_read_some(const asio::mutable_buffer* buffers, std::size_t count, io_handler_type handler);
+
+    /**
+     * Asynchronously writes data using the transport
+     *
+     * @param buffers data to write
+     * @param count number of buffers
+     * @param handler called after the data has been written
+     */
+    void uring_write(const asio::const_buffer* buffers, std::size_t count, io_handler_type handler);
+
+    /**
+     * Writes some data to the socket without waiting
+     *
+     * @param buffers buffers to write
+     * @param count number of buffers
+     * @param ec set to "would_block" if not all the data was written
+     * @return number of bytes written
+     */
+    std::size_t try_write_some(const asio::const_buffer* buffers, std::size_t count, asio::error_code& ec);
+
+    /**
+     * Asynchronously writes data to the connection without the write deadline
+     *
+     * @param buffers one or more buffers containing the data to be written
+     * @param handler called after the data has been written
+     */
+    template <typename ConstBufferSequence, typename write_handler_t>
+    void async_write_unchecked(const ConstBufferSequence& buffers, write_handler_t handler) {
+#ifdef STATICLIB_HTTPSERVER_HAVE_SSL
+        if (get_ssl_flag())
+            asio::async_write(m_ssl_socket, buffers, handler);
+        else
+#endif      
+        {
+            std::array<asio::const_buffer, SPECULATIVE_WRITE_BUFFERS_MAX> uring_buffers;
+            std::size_t count = m_uring ? copy_buffers(buffers, uring_buffers.data(), uring_buffers.size()) : 0;
+            if (count > 0) {
+                uring_write(uring_buffers.data(), count, handler);
+            } else {
+                asio::async_write(m_ssl_socket.next_layer(), buffers, handler);
+            }
+        }
+    }
+
+    /**
+     * Arms the write deadline unless it is already armed by an enclosing operation
+     * 
+     * @param length number of bytes to write
+     * @return true if deadline was armed by this call
+     */
+    bool start_write_deadline(std::size_t length);
+
+    /**
+     * Disarms the write deadline
+     */
+    void stop_write_deadline();
+
+    /**
+     * Sets 'TCP_NODELAY' on the socket without changing the state requested with 'set_no_delay'
+     *
+     * @param enabled whether to disable Nagle's algorithm
+     */
+    void apply_no_delay(bool enabled);
+
+    /**
+     * Moves the data immediately available on the socket to the specified
+     * file descriptor without blocking
+     * 
+     * @param fd destination file descriptor
+     * @param max_len maximum number of bytes to move
+     * @param ec set to "would_block" if no data is available
+     * @return number of bytes moved
+     */
+    std::size_t splice_some(int fd, std::size_t max_len, asio::error_code& ec);
+
+    /**
+     * Creates a task that calls the specified handler
+     * 
+     * @param handler function to call
+     * @return task
+     */
+    template <typename Handler>
+    task* make_task(Handler handler) {
+        std::size_t size = sizeof(handler_task<Handler>);
+        void* mem = allocate_task(size);
+        try {
+            task* res = new (mem) handler_task<Handler>(std::move(handler));
+            res->size = size;
+            return res;
+        } catch (...) {
+            deallocate_task(mem, size);
+            throw;
+        }
+    }
+
+    /**
+     * Allocates memory for the task, reuses the spare block if possible
+     * 
+     * @param size task size
+     * @return allocated memory
+     */
+    void* allocate_task(std::size_t size);
+
+    /**
+     * Frees memory of the task, keeps it as a spare block if possible
+     * 
+     * @param ptr memory to free
+     * @param size task size
+     */
+    void deallocate_task(void* ptr, std::size_t size);
+
+    /**
+     * Destroys the task and frees its memory
+     * 
+     * @param t task to destroy
+     */
+    void destroy_task(task* t);
+
+    /**
+     * Pushes the task into the stack, schedules running the tasks if none is running
+     * 
+     * @param t task to push, ownership is taken
+     */
+    void push_task(task* t);
+
+    /**
+     * Posts running the tasks to the io_service
+     */
+    void schedule_tasks();
+
+    /**
+     * Runs the tasks until the stack is empty, must be called only
+     * by the thread that marked the tasks as running
+     */
+    void run_tasks();
 };
 
 /**
@@ -26,7 +26,9 @@
 #ifndef STATICLIB_HTTPSERVER_TCP_SERVER_HPP
 #define STATICLIB_HTTPSERVER_TCP_SERVER_HPP
 
+#include <chrono>
 #include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <set>
 
@@ -37,6 +39,7 @@
 #include "staticlib/httpserver/noncopyable.hpp"
 #include "staticlib/httpserver/scheduler.hpp"
 #include "staticlib/httpserver/tcp_connection.hpp"
+#include "staticlib/httpserver/uring_transport.hpp"
 
 namespace staticlib { 
 namespace httpserver {
@@ -45,6 +48,20 @@ namespace httpserver {
  * Multi-threaded, asynchronous TCP server
  */
 class tcp_server : private staticlib::httpserver::noncopyable {
+public:
+    /**
+     * Transports used for reads and writes of unencrypted connections
+     */
+    enum transport_type {
+        /**
+         * asio reactor (epoll on Linux)
+         */
+        TRANSPORT_REACTOR,
+        /**
+         * Linux io_uring, see 'uring_transport'
+         */
+        TRANSPORT_IO_URING
+    };
 
 protected:
 
@@ -111,9 +128,85 @@ private:
      * Mutex to make class thread-safe
      */
     mutable std::mutex m_mutex;    
+
+    /**
+     * Counter of connections per client IP address, null if connections are not limited
+     */
+    std::shared_ptr<connection_limiter> m_connection_limiter;
+
+    /**
+     * Closes connections that violate slow client limits
+     */
+    class connection_sweeper;
+    std::shared_ptr<connection_sweeper> m_sweeper;
+
+    /**
+     * Counters of non-blocking reads and writes, null if they are disabled
+     */
+    std::shared_ptr<speculative_io_counters> m_speculative_io;
+
+    /**
+     * Transport selected for unencrypted connections
+     */
+    transport_type m_transport;
+
+    /**
+     * io_uring transport, null if the reactor is used or the server is not running
+     */
+    std::shared_ptr<uring_transport> m_uring;
+
+    /**
+     * Value of 'SO_BUSY_POLL' set on accepted sockets, zero to leave it unset
+     */
+    std::chrono::microseconds m_socket_busy_poll;
     
 public:
 
+    /**
+     * Numbers of connections closed for violating slow client limits
+     */
+    struct slow_client_stats {
+        /**
+         * Connections that did not send request headers in time
+         */
+        uint64_t header_timeouts;
+
+        /**
+         * Connections that did not accept response data in time
+         */
+        uint64_t write_timeouts;
+    };
+
+    /**
+     * Numbers of reads and writes attempted without waiting for the reactor
+     */
+    struct speculative_io_stats {
+        /**
+         * Reads that returned data without waiting
+         */
+        uint64_t reads_completed;
+
+        /**
+         * Reads that found no data and waited for the reactor
+         */
+        uint64_t reads_would_block;
+
+        /**
+         * Writes that were completed without waiting
+         */
+        uint64_t writes_completed;
+
+        /**
+         * Writes that did not fit into the socket buffer and waited for the reactor
+         */
+        uint64_t writes_would_block;
+    };
+
+    /**
+     * Interval of the slow client limits checks
+     */
+    static const std::chrono::milliseconds SLOW_CLIENT_CHECK_INTERVAL;
+
     /**
      * Virtual destructor
      */
@@ -150,6 +243,86 @@ public:
      */
     std::size_t get_connections() const;
 
+    /**
+     * Limits the number of concurrent connections from a single IP address,
+     * connections over the limit are closed right after accept, before
+     * SSL handshake and request parsing. Must be called before the server is started.
+     * 
+     * @param max_connections maximum number of connections, zero to disable the limit
+     */
+    void set_max_connections_per_ip(uint32_t max_connections);
+
+    /**
+     * Sets limits that protect the server from clients that send requests
+     * or receive responses too slowly (like slowloris). Instead of per-operation
+     * timers connections store their deadlines and are checked by a single timer
+     * every 'SLOW_CLIENT_CHECK_INTERVAL', violating connections are closed and counted.
+     * Must be called before the server is started.
+     * 
+     * @param header_timeout time limit for receiving request headers counted
+     *        from the accept for the first request and from the first byte
+     *        for subsequent requests, zero to disable
+     * @param write_timeout base time limit for a write operation, zero to disable
+     *        write limits
+     * @param min_write_bytes_per_second minimum write bandwidth, each write is allowed
+     *        additional time for its length at this rate, zero to disable
+     */
+    void set_slow_client_policy(std::chrono::steady_clock::duration header_timeout,
+            std::chrono::steady_clock::duration write_timeout, uint32_t min_write_bytes_per_second);
+
+    /**
+     * Returns numbers of connections closed for violating slow client limits
+     * 
+     * @return slow client counters
+     */
+    slow_client_stats get_slow_client_stats() const;
+
+    /**
+     * Enables or disables speculative I/O (enabled by default): the next request
+     * on a keep-alive connection is read and responses are written with non-blocking
+     * calls first, the reactor is used only if the socket is not ready.
+     * Applies to unencrypted connections on Linux. Must be called before the server is started.
+     * 
+     * @param enabled whether to attempt reads and writes without waiting for the reactor
+     */
+    void set_speculative_io(bool enabled);
+
+    /**
+     * Returns numbers of reads and writes attempted without waiting for the reactor
+     * 
+     * @return speculative I/O counters
+     */
+    speculative_io_stats get_speculative_io_stats() const;
+
+    /**
+     * Selects transport for reads and writes of unencrypted connections (reactor
+     * by default). If io_uring is selected but is not supported by the kernel
+     * or the library is built without it, server falls back to the reactor
+     * on start. Accept and SSL connections always use the reactor.
+     * Must be called before the server is started.
+     * 
+     * @param transport transport to use
+     */
+    void set_transport(transport_type transport);
+
+    /**
+     * Returns transport used for reads and writes of unencrypted connections,
+     * after the start it reflects the fallback to the reactor
+     * 
+     * @return transport in use
+     */
+    transport_type get_transport() const;
+
+    /**
+     * Sets 'SO_BUSY_POLL' on accepted sockets, so the kernel polls the device
+     * queue instead of waiting for the interrupt; pairs with the busy-poll mode
+     * of the scheduler. Setting it usually requires 'CAP_NET_ADMIN', failures
+     * are logged and ignored. Must be called before the server is started.
+     * 
+     * @param interval polling time, zero to leave the option unset
+     */
+    void set_socket_busy_poll(std::chrono::microseconds interval);
+
     /**
      * Returns tcp port number that the server listens for connections on
      */
@@ -307,6 +480,14 @@ public:
      * @return scheduler
      */
     scheduler& get_active_scheduler();
+
+    /**
+     * Stops the server and joins the threads of the default scheduler, should be
+     * called from the destructor of the derived class, so the handlers that still
+     * run on these threads after their connections were finished do not outlive it;
+     * external scheduler is left running
+     */
+    void finish_default_scheduler();
     
 private:
         
@@ -0,0 +1,221 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   uring_transport.hpp
+ * Author: agent
+ *
+ * Created on October 19, 2026, 12:40 AM
+ */
+
+#ifndef STATICLIB_HTTPSERVER_URING_TRANSPORT_HPP
+#define	STATICLIB_HTTPSERVER_URING_TRANSPORT_HPP
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "asio.hpp"
+
+#include "staticlib/httpserver/config.hpp"
+#include "staticlib/httpserver/noncopyable.hpp"
+
+namespace staticlib {
+namespace httpserver {
+
+/**
+ * Socket reads and writes done through the Linux io_uring instead of the reactor.
+ * Operations are queued by the callers and submitted by a dedicated thread that
+ * also reaps completions and posts their handlers to the IO service of the operation,
+ * so kernel runs completion work in the thread that waits for it. Available only
+ * on Linux when built with STATICLIB_HTTPSERVER_HAVE_IO_URING.
+ */
+class uring_transport : private staticlib::httpserver::noncopyable {
+    class ring;
+    class operation;
+
+    /**
+     * Submission and completion queues
+     */
+    std::unique_ptr<ring> m_ring;
+
+    /**
+     * Mutex that guards queued operations and cancellations
+     */
+    std::mutex m_mutex;
+
+    /**
+     * Operations queued for submission
+     */
+    std::vector<operation*> m_queue;
+
+    /**
+     * Owners which operations are queued for cancellation
+     */
+    std::vector<const void*> m_cancel_queue;
+
+    /**
+     * Whether the completion thread was woken up and has not taken the queues yet
+     */
+    bool m_wake_pending;
+
+    /**
+     * Whether the transport is stopped and does not accept new operations
+     */
+    bool m_stopped;
+
+    /**
+     * Operations submitted and not completed yet, used only by the completion thread
+     */
+    std::unordered_set<operation*> m_pending;
+
+    /**
+     * Thread that waits for completions
+     */
+    std::thread m_completion_thread;
+
+public:
+    /**
+     * Function called when the operation has completed
+     */
+    using io_handler_type = std::function<void(const asio::error_code&, std::size_t)>;
+
+    /**
+     * Creates the transport, probes the kernel for the required operations
+     *
+     * @param entries size of the submission queue
+     * @return transport, or null if io_uring is not available
+     */
+    static std::shared_ptr<uring_transport> create(uint32_t entries);
+
+    /**
+     * Destructor, stops the transport
+     */
+    ~uring_transport() STATICLIB_HTTPSERVER_NOEXCEPT;
+
+    /**
+     * Asynchronously reads some data from the socket
+     *
+     * @param io_service IO service to run the handler on
+     * @param owner object the operation belongs to, must stay alive until the handler is called
+     * @param fd socket descriptor
+     * @param buffers buffers to read into, must stay valid until the handler is called
+     * @param count number of buffers
+     * @param handler called after the read operation has completed
+     */
+    void async_read_some(asio::io_service& io_service, const void* owner, int fd,
+            const asio::mutable_buffer* buffers, std::size_t count, io_handler_type handler);
+
+    /**
+     * Asynchronously writes all the data to the socket
+     *
+     * @param io_service IO service to run the handler on
+     * @param owner object the operation belongs to, must stay alive until the handler is called
+     * @param fd socket descriptor
+     * @param buffers data to write, must stay valid until the handler is called
+     * @param count number of buffers
+     * @param handler called after the data has been written
+     */
+    void async_write(asio::io_service& io_service, const void* owner, int fd,
+            const asio::const_buffer* buffers, std::size_t count, io_handler_type handler);
+
+    /**
+     * Cancels operations of the owner, their handlers are called with
+     * "operation_aborted" error; operations are matched by their owner
+     * rather than by socket descriptor, that may be reused by a new
+     * connection before the cancellation is processed
+     *
+     * @param owner object the operations belong to
+     */
+    void cancel(const void* owner);
+
+    /**
+     * Stops the transport: pending operations are cancelled and their handlers
+     * are posted with "operation_aborted" error, operations started later fail
+     * the same way; operations that are not completed in time are released
+     * after the queues are closed
+     */
+    void stop();
+
+private:
+    /**
+     * Private constructor, use create()
+     *
+     * @param ring opened queues
+     */
+    explicit uring_transport(std::unique_ptr<ring> ring);
+
+    /**
+     * Queues operation for the completion thread,
+     * completes it with an error if the transport is stopped
+     *
+     * @param op operation to submit
+     */
+    void enqueue(operation* op);
+
+    /**
+     * Wakes up the completion thread
+     */
+    void wake();
+
+    /**
+     * Adds operation to the submission queue, called by the completion thread
+     *
+     * @param op operation to submit
+     * @return false if submission queue is full
+     */
+    bool submit(operation* op);
+
+    /**
+     * Adds cancellation of the operation to the submission queue,
+     * called by the completion thread
+     *
+     * @param op operation to cancel
+     */
+    void submit_cancel(operation* op);
+
+    /**
+     * Handles the completion of the operation, resubmits it if it is not done,
+     * called by the completion thread
+     *
+     * @param op operation
+     * @param res result of the operation
+     * @param stopping whether the transport is stopping
+     */
+    void handle_completion(operation* op, int res, bool stopping);
+
+    /**
+     * Posts handler of the operation and releases it
+     *
+     * @param op operation
+     * @param ec result of the operation
+     */
+    void complete(operation* op, const asio::error_code& ec);
+
+    /**
+     * Body of the completion thread
+     */
+    void run();
+};
+
+} // namespace
+}
+
+#endif	/* STATICLIB_HTTPSERVER_URING_TRANSPORT_HPP */
@@ -0,0 +1,1179 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   perf_test.cpp
+ * Author: agent
+ *
+ * Created on October 19, 2026, 1:08 AM
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <new>
+#include <stdexcept>
+
+#include "asio.hpp"
+
+#include "staticlib/httpserver/buffer_pool.hpp"
+#include "staticlib/httpserver/http_common_headers.hpp"
+#include "staticlib/httpserver/http_file_sink.hpp"
+#include "staticlib/httpserver/http_output_buffer.hpp"
+#include "staticlib/httpserver/http_response_writer.hpp"
+#include "staticlib/httpserver/http_server.hpp"
+#include "staticlib/httpserver/rate_limiter.hpp"
+
+namespace sh = staticlib::httpserver;
+
+const uint16_t TCP_PORT = 8090;
+const std::size_t UPLOAD_SIZE = 128 * 1024 * 1024;
+const std::string UPLOAD_FILE = "perf_upload.dat";
+const std::size_t DOWNLOAD_SIZE = 128 * 1024 * 1024;
+const std::string DOWNLOAD_FILE = "perf_download.dat";
+const std::size_t JSON_REQUESTS = 1000;
+const std::size_t SERIALIZE_ITERATIONS = 200000;
+
+const std::size_t STREAM_CHUNKS = 20000;
+const std::size_t STREAM_CHUNK_SIZE = 16 * 1024;
+const std::size_t QUEUED_CHUNKS = 200000;
+const std::size_t HEAVY_ITERATIONS = 20000000;
+const std::size_t HEAVY_CLIENTS = 4;
+const std::size_t OVERLOAD_CLIENTS = 32;
+const std::size_t OVERLOAD_SECONDS = 2;
+const std::size_t RATE_LIMIT_THREADS = 8;
+const std::size_t RATE_LIMIT_KEYS = 10000;
+const std::size_t RATE_LIMIT_CHECKS = 1000000;
+const std::size_t DEADLINE_CLIENTS = 8;
+const std::size_t DEADLINE_SECONDS = 2;
+const std::size_t SLOW_HANDLER_MILLIS = 500;
+const std::size_t SLOWLORIS_CLIENTS = 256;
+const std::size_t SLOWLORIS_SECONDS = 3;
+const std::size_t SLOWLORIS_BYTE_MILLIS = 250;
+const std::size_t PIPELINE_DEPTH = 16;
+const std::size_t PIPELINE_BATCHES = 100;
+const std::size_t PIPELINE_HANDLER_MILLIS = 2;
+const std::size_t KEEPALIVE_CLIENTS = 16;
+const std::size_t KEEPALIVE_SECONDS = 2;
+const std::size_t BUSY_POLL_CLIENTS = 2;
+const std::size_t BUSY_POLL_MICROS = 50;
+
+// counts heap allocations made by all threads
+std::atomic<std::size_t> allocations_count{0};
+
+void* operator new(std::size_t size) {
+    allocations_count.fetch_add(1, std::memory_order_relaxed);
+    void* ptr = std::malloc(size > 0 ? size : 1);
+    if (nullptr == ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void* ptr) STATICLIB_HTTPSERVER_NOEXCEPT {
+    std::free(ptr);
+}
+
+class OfstreamWriter {
+    std::shared_ptr<std::ofstream> stream;
+
+public:
+    OfstreamWriter(const std::string& filename) :
+    stream(std::make_shared<std::ofstream>(filename, std::ios::out | std::ios::binary)) { }
+
+    void operator()(const char* s, std::size_t n) {
+        stream->write(s, n);
+    }
+};
+
+void upload_done(sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+    auto writer = sh::http_response_writer::create(conn, req);
+    writer << "OK";
+    writer->send();
+}
+
+double elapsed_seconds(std::chrono::steady_clock::time_point start) {
+    auto dur = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration_cast<std::chrono::microseconds>(dur).count() / 1000000.0;
+}
+
+double upload(const std::string& path, std::size_t size) {
+    asio::io_service io_service;
+    asio::ip::tcp::socket socket(io_service);
+    socket.connect(asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), TCP_PORT));
+    std::string head = "POST " + path + " HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n"
+            "Content-Length: " + std::to_string(size) + "\r\n\r\n";
+    std::vector<char> block(1024 * 1024, 'x');
+    auto start = std::chrono::steady_clock::now();
+    asio::write(socket, asio::buffer(head));
+    for (std::size_t sent = 0; sent < size; sent += block.size()) {
+        asio::write(socket, asio::buffer(block.data(), std::min(block.size(), size - sent)));
+    }
+    // wait for the response
+    std::array<char, 1024> resp;
+    asio::error_code ec;
+    while (!ec) {
+        socket.read_some(asio::buffer(resp), ec);
+    }
+    return elapsed_seconds(start);
+}
+
+void bench_upload() {
+    sh::http_server server(2, TCP_PORT);
+    server.add_handler("POST", "/ofstream", upload_done);
+    server.add_payload_handler("POST", "/ofstream", [](sh::http_request_ptr&) {
+        return OfstreamWriter{UPLOAD_FILE};
+    });
+    server.add_handler("POST", "/splice", upload_done);
+    server.add_payload_handler("POST", "/splice", [](sh::http_request_ptr&) {
+        return sh::http_file_sink{UPLOAD_FILE};
+    });
+    server.start();
+    double mb = static_cast<double>(UPLOAD_SIZE) / (1024 * 1024);
+    double ofs = upload("/ofstream", UPLOAD_SIZE);
+    double spl = upload("/splice", UPLOAD_SIZE);
+    std::cout << "upload, ofstream handler: " << mb / ofs << " MB/s" << std::endl;
+    std::cout << "upload, file sink:        " << mb / spl << " MB/s" << std::endl;
+    server.stop(true);
+    std::remove(UPLOAD_FILE.c_str());
+}
+
+class FileSender : public std::enable_shared_from_this<FileSender> {
+    sh::http_response_writer_ptr writer;
+    std::ifstream stream;
+    std::array<char, 8192> buf;
+
+public:
+    FileSender(const std::string& filename, sh::http_response_writer_ptr writer) :
+    writer(writer),
+    stream(filename, std::ios::in | std::ios::binary) { }
+
+    void send() {
+        asio::error_code ec{};
+        handle_write(ec, 0);
+    }
+
+    void handle_write(const asio::error_code& ec, std::size_t) {
+        if (ec) return;
+        stream.read(buf.data(), buf.size());
+        writer->clear();
+        writer->write_no_copy(buf.data(), static_cast<size_t> (stream.gcount()));
+        if (stream) {
+            auto self = shared_from_this();
+            writer->send_chunk([self](const asio::error_code& ec, size_t bt) {
+                self->handle_write(ec, bt);
+            });
+        } else {
+            writer->send_final_chunk();
+        }
+    }
+};
+
+double download(const std::string& path, std::size_t expected) {
+    asio::io_service io_service;
+    asio::ip::tcp::socket socket(io_service);
+    socket.connect(asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), TCP_PORT));
+    std::string req = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n";
+    auto start = std::chrono::steady_clock::now();
+    asio::write(socket, asio::buffer(req));
+    std::vector<char> buf(1024 * 1024);
+    std::size_t received = 0;
+    asio::error_code ec;
+    while (!ec) {
+        received += socket.read_some(asio::buffer(buf), ec);
+    }
+    double res = elapsed_seconds(start);
+    if (received < expected) {
+        throw std::runtime_error("Download failed, received: [" + std::to_string(received) + "] bytes");
+    }
+    return res;
+}
+
+void bench_download() {
+    {
+        std::ofstream out(DOWNLOAD_FILE, std::ios::out | std::ios::binary);
+        std::vector<char> block(1024 * 1024, 'x');
+        for (std::size_t i = 0; i < DOWNLOAD_SIZE; i += block.size()) {
+            out.write(block.data(), block.size());
+        }
+    }
+    sh::http_server server(2, TCP_PORT);
+    server.add_handler("GET", "/filesender", [](sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+        auto writer = sh::http_response_writer::create(conn, req);
+        std::make_shared<FileSender>(DOWNLOAD_FILE, writer)->send();
+    });
+    server.add_handler("GET", "/writefile", [](sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+        std::FILE* file = std::fopen(DOWNLOAD_FILE.c_str(), "rb");
+        auto writer = sh::http_response_writer::create(conn, req, [file, conn](const asio::error_code&) {
+            std::fclose(file);
+            conn->finish();
+        });
+        writer->write_file(fileno(file), 0, DOWNLOAD_SIZE);
+        writer->send();
+    });
+    server.start();
+    double mb = static_cast<double>(DOWNLOAD_SIZE) / (1024 * 1024);
+    double fs = download("/filesender", DOWNLOAD_SIZE);
+    double wf = download("/writefile", DOWNLOAD_SIZE);
+    std::cout << "download, FileSender chunks: " << mb / fs << " MB/s" << std::endl;
+    std::cout << "download, write_file:        " << mb / wf << " MB/s" << std::endl;
+    server.stop(true);
+    std::remove(DOWNLOAD_FILE.c_str());
+}
+
+std::size_t fetch(const std::string& path, const std::string& accept_encoding) {
+    asio::io_service io_service;
+    asio::ip::tcp::socket socket(io_service);
+    socket.connect(asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), TCP_PORT));
+    std::string req = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n"
+            "Accept-Encoding: " + accept_encoding + "\r\n\r\n";
+    asio::write(socket, asio::buffer(req));
+    std::array<char, 65536> buf;
+    std::size_t received = 0;
+    asio::error_code ec;
+    while (!ec) {
+        received += socket.read_some(asio::buffer(buf), ec);
+    }
+    return received;
+}
+
+void bench_compression() {
+    auto json = std::make_shared<std::string>();
+    for (std::size_t i = 0; i < 2000; i++) {
+        *json += "{\"id\": " + std::to_string(i) + ", \"name\": \"item " + std::to_string(i) + "\", \"active\": true},";
+    }
+    sh::http_server server(2, TCP_PORT);
+    server.add_handler("GET", "/json", [json](sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+        auto writer = sh::http_response_writer::create(conn, req);
+        writer->get_response().set_content_type("application/json");
+        writer->enable_compression();
+        writer->write_no_copy(*json);
+        writer->send();
+    });
+    server.start();
+    for (const std::string enc : {"identity", "gzip"}) {
+        std::size_t bytes = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < JSON_REQUESTS; i++) {
+            bytes += fetch("/json", enc);
+        }
+        double secs = elapsed_seconds(start);
+        std::cout << "json, " << enc << ": " << bytes / JSON_REQUESTS << " bytes per response, "
+                << JSON_REQUESTS / secs << " req/s" << std::endl;
+    }
+    server.stop(true);
+}
+
+void fill_response(sh::http_response& resp) {
+    resp.set_content_type("application/json");
+    resp.set_content_length(12345);
+    resp.add_header("Cache-Control", "no-cache, no-store, must-revalidate");
+    resp.add_header("X-Content-Type-Options", "nosniff");
+    resp.add_header("X-Frame-Options", "DENY");
+    resp.add_header("X-Request-Id", "2f1e3c4d-5b6a-7980-a1b2-c3d4e5f60718");
+    resp.add_header("Server", "staticlib_httpserver");
+    resp.add_header("Date", "Mon, 21 Nov 2016 10:00:00 GMT");
+}
+
+void bench_serialization() {
+    sh::http_request req;
+    req.set_version_major(1);
+    req.set_version_minor(1);
+    std::size_t iovecs = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < SERIALIZE_ITERATIONS; i++) {
+        sh::http_response resp(req);
+        fill_response(resp);
+        sh::http_message::write_buffers_type buffers;
+        resp.prepare_buffers_for_send(buffers, true, false);
+        iovecs = buffers.size();
+    }
+    double bufs = elapsed_seconds(start);
+    start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < SERIALIZE_ITERATIONS; i++) {
+        sh::http_response resp(req);
+        fill_response(resp);
+        std::string buf = sh::buffer_pool::acquire(512);
+        resp.serialize_headers(buf, true, false);
+        sh::buffer_pool::release(std::move(buf));
+    }
+    double ser = elapsed_seconds(start);
+    std::cout << "headers, write buffers: " << bufs * 1000000000 / SERIALIZE_ITERATIONS << " ns, "
+            << iovecs << " buffers" << std::endl;
+    std::cout << "headers, serialized:    " << ser * 1000000000 / SERIALIZE_ITERATIONS << " ns, 1 buffer" << std::endl;
+}
+
+void bench_common_headers() {
+    sh::http_request req;
+    req.set_version_major(1);
+    req.set_version_minor(1);
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < SERIALIZE_ITERATIONS; i++) {
+        sh::http_response resp(req);
+        std::string date;
+        sh::algorithm::append_http_date(date, std::time(nullptr));
+        resp.add_header("Date", date);
+        resp.add_header("Server", "staticlib_httpserver");
+        resp.add_header("X-Content-Type-Options", "nosniff");
+        std::string buf = sh::buffer_pool::acquire(512);
+        resp.serialize_headers(buf, true, false);
+        sh::buffer_pool::release(std::move(buf));
+    }
+    double per_resp = elapsed_seconds(start);
+    sh::http_common_headers common;
+    common.add_header("Server", "staticlib_httpserver");
+    common.add_header("X-Content-Type-Options", "nosniff");
+    start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < SERIALIZE_ITERATIONS; i++) {
+        sh::http_response resp(req);
+        std::string buf = sh::buffer_pool::acquire(512);
+        resp.serialize_headers(buf, true, false, std::addressof(common));
+        sh::buffer_pool::release(std::move(buf));
+    }
+    double cached = elapsed_seconds(start);
+    std::cout << "common headers, per response: " << per_resp * 1000000000 / SERIALIZE_ITERATIONS << " ns" << std::endl;
+    std::cout << "common headers, cached block: " << cached * 1000000000 / SERIALIZE_ITERATIONS << " ns" << std::endl;
+}
+
+void bench_canned_response() {
+    sh::http_server server(2, TCP_PORT);
+    // error response built the same way as the default handlers did before
+    server.add_handler("GET", "/writer", [](sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+        auto writer = sh::http_response_writer::create(conn, req);
+        writer->get_response().set_status_code(sh::http_message::RESPONSE_CODE_NOT_FOUND);
+        writer->get_response().set_status_message(sh::http_message::RESPONSE_MESSAGE_NOT_FOUND);
+        writer->write_no_copy("{\"code\": 404, \"message\": \"Not Found\", \"description\": \"[");
+        writer->write_move(sh::algorithm::xml_encode(req->get_resource()));
+        writer->write_no_copy("] was not found\"}");
+        writer->send();
+    });
+    server.start();
+    for (const std::string path : {"/writer", "/canned"}) {
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < JSON_REQUESTS; i++) {
+            fetch(path, "identity");
+        }
+        double secs = elapsed_seconds(start);
+        std::cout << "404, " << path << ": " << JSON_REQUESTS / secs << " req/s" << std::endl;
+    }
+    server.stop(true);
+}
+
+void bench_output_buffer() {
+    const std::string piece = "{\"id\": 42, \"ok\": true},";
+    std::size_t buffers = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < SERIALIZE_ITERATIONS / 100; i++) {
+        // heap copy per write, as the writer did before
+        std::vector<std::unique_ptr<char[]>> copies;
+        sh::http_message::write_buffers_type bufs;
+        for (std::size_t j = 0; j < 1000; j++) {
+            copies.emplace_back(new char[piece.length()]);
+            std::memcpy(copies.back().get(), piece.data(), piece.length());
+            bufs.emplace_back(copies.back().get(), piece.length());
+        }
+    }
+    double heap = elapsed_seconds(start);
+    start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < SERIALIZE_ITERATIONS / 100; i++) {
+        sh::http_output_buffer buf;
+        for (std::size_t j = 0; j < 1000; j++) {
+            buf.append(piece.data(), piece.length());
+        }
+        buffers = buf.get_buffers().size();
+    }
+    double slabs = elapsed_seconds(start);
+    std::cout << "1000 small writes, heap copies: " << heap * 1000000 / (SERIALIZE_ITERATIONS / 100) << " us, 1000 buffers" << std::endl;
+    std::cout << "1000 small writes, slabs:       " << slabs * 1000000 / (SERIALIZE_ITERATIONS / 100) << " us, "
+            << buffers << " buffers" << std::endl;
+}
+
+template<typename Out>
+void emit_json(Out& out) {
+    // about 10 KB
+    out << "[";
+    for (int i = 0; i < 225; i++) {
+        if (i > 0) out << ",";
+        out << "{\"id\": " << i << ", \"score\": " << i * 1.5 << ", \"name\": \"item" << i << "\"}";
+    }
+    out << "]";
+}
+
+void bench_text_formatting() {
+    sh::http_server server(2, TCP_PORT);
+    server.add_handler("GET", "/stream", [](sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+        // formatting through iostreams, as the writer did before
+        std::ostringstream stream;
+        emit_json(stream);
+        auto writer = sh::http_response_writer::create(conn, req);
+        writer->write_move(stream.str());
+        writer->send();
+    });
+    server.add_handler("GET", "/writer", [](sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+        auto writer = sh::http_response_writer::create(conn, req);
+        emit_json(writer);
+        writer->send();
+    });
+    server.start();
+    for (const std::string path : {"/stream", "/writer"}) {
+        std::size_t bytes = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < JSON_REQUESTS; i++) {
+            bytes += fetch(path, "identity");
+        }
+        double secs = elapsed_seconds(start);
+        std::cout << "json via <<, " << path << ": " << bytes / JSON_REQUESTS << " bytes per response, "
+                << JSON_REQUESTS / secs << " req/s" << std::endl;
+    }
+    server.stop(true);
+}
+
+class ChunkStreamer : public std::enable_shared_from_this<ChunkStreamer> {
+    sh::http_response_writer_ptr writer;
+    std::shared_ptr<std::string> block;
+    std::size_t sent = 0;
+
+public:
+    ChunkStreamer(sh::http_response_writer_ptr writer, std::shared_ptr<std::string> block) :
+    writer(writer),
+    block(block) { }
+
+    void send() {
+        if (sent++ < STREAM_CHUNKS) {
+            writer->clear();
+            writer->write_no_copy(*block);
+            auto self = shared_from_this();
+            writer->send_chunk([self](const asio::error_code& ec, std::size_t) {
+                if (!ec) self->send();
+            });
+        } else {
+            writer->send_final_chunk();
+        }
+    }
+};
+
+void bench_chunked_streaming() {
+    auto block = std::make_shared<std::string>(STREAM_CHUNK_SIZE, 'x');
+    sh::http_server server(2, TCP_PORT);
+    server.add_handler("GET", "/stream", [block](sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+        auto writer = sh::http_response_writer::create(conn, req);
+        std::make_shared<ChunkStreamer>(writer, block)->send();
+    });
+    server.start();
+    std::size_t allocs_before = allocations_count.load();
+    double secs = download("/stream", STREAM_CHUNKS * STREAM_CHUNK_SIZE);
+    std::size_t allocs = allocations_count.load() - allocs_before;
+    double mb = static_cast<double>(STREAM_CHUNKS * STREAM_CHUNK_SIZE) / (1024 * 1024);
+    std::cout << "chunked streaming: " << mb / secs << " MB/s, "
+            << static_cast<double>(allocs) / STREAM_CHUNKS << " allocations per chunk" << std::endl;
+    server.stop(true);
+}
+
+void bench_body_source() {
+    sh::http_server server(2, TCP_PORT);
+    server.add_handler("GET", "/source", [](sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+        auto writer = sh::http_response_writer::create(conn, req);
+        auto remaining = std::make_shared<std::size_t>(STREAM_CHUNKS * STREAM_CHUNK_SIZE);
+        writer->send_body([remaining](char* buf, std::size_t len) {
+            std::size_t res = (std::min)(len, *remaining);
+            std::memset(buf, 'x', res);
+            *remaining -= res;
+            return res;
+        });
+    });
+    server.start();
+    std::size_t allocs_before = allocations_count.load();
+    double secs = download("/source", STREAM_CHUNKS * STREAM_CHUNK_SIZE);
+    std::size_t allocs = allocations_count.load() - allocs_before;
+    double mb = static_cast<double>(STREAM_CHUNKS * STREAM_CHUNK_SIZE) / (1024 * 1024);
+    std::cout << "body source streaming: " << mb / secs << " MB/s, "
+            << static_cast<double>(allocs) / mb << " allocations per MB, "
+            << sh::http_response_writer::DEFAULT_HIGH_WATERMARK / 1024 << " KB max buffered" << std::endl;
+    server.stop(true);
+}
+
+void bench_queued_chunks() {
+    sh::http_server server(2, TCP_PORT);
+    server.add_handler("GET", "/queued", [](sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+        auto writer = sh::http_response_writer::create(conn, req);
+        for (std::size_t i = 0; i < QUEUED_CHUNKS; i++) {
+            writer->write("{\"id\": ");
+            writer->write(i);
+            writer->write("}\n");
+            // chunks are not waited for, they are queued while a write is in progress
+            writer->send_chunk([](const asio::error_code&, std::size_t) { });
+        }
+        writer->send_final_chunk();
+    });
+    server.start();
+    auto start = std::chrono::steady_clock::now();
+    download("/queued", QUEUED_CHUNKS * 10);
+    double secs = elapsed_seconds(start);
+    std::cout << "queued small chunks: " << static_cast<double>(QUEUED_CHUNKS) / secs << " chunks/s" << std::endl;
+    server.stop(true);
+}
+
+// single thread that runs offloaded work, like a DB client callback thread
+class OffloadWorker {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::function<void()>> tasks;
+    bool stopped = false;
+    std::thread thread;
+
+public:
+    OffloadWorker() :
+    thread([this] { run(); }) { }
+
+    ~OffloadWorker() {
+        {
+            std::lock_guard<std::mutex> guard{mutex};
+            stopped = true;
+        }
+        cv.notify_one();
+        thread.join();
+    }
+
+    void submit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> guard{mutex};
+            tasks.emplace_back(std::move(task));
+        }
+        cv.notify_one();
+    }
+
+private:
+    void run() {
+        std::vector<std::function<void()>> batch;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock{mutex};
+                cv.wait(lock, [this] { return stopped || !tasks.empty(); });
+                if (stopped && tasks.empty()) return;
+                batch.swap(tasks);
+            }
+            for (auto& task : batch) {
+                task();
+            }
+            batch.clear();
+        }
+    }
+};
+
+void bench_cross_thread_completion() {
+    OffloadWorker worker;
+    sh::http_server server(2, TCP_PORT);
+    server.add_handler("GET", "/direct", [&worker](sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+        auto writer = sh::http_response_writer::create(conn, req);
+        worker.submit([writer] {
+            writer->write("{\"result\": 42}");
+            writer->send();
+        });
+    });
+    server.add_handler("GET", "/posted", [&worker](sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+        auto writer = sh::http_response_writer::create(conn, req);
+        worker.submit([writer] {
+            writer->post([](sh::http_response_writer& wr) {
+                wr.write("{\"result\": 42}");
+                wr.send();
+            });
+        });
+    });
+    server.start();
+    for (const std::string path : {"/direct", "/posted"}) {
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < JSON_REQUESTS; i++) {
+            fetch(path, "identity");
+        }
+        double secs = elapsed_seconds(start);
+        std::cout << "cross-thread completion, " << path << ": " << JSON_REQUESTS / secs << " req/s" << std::endl;
+    }
+    server.stop(true);
+}
+
+void heavy_handler(sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+    // CPU-bound work standing in for template rendering or hashing
+    volatile uint64_t acc = 0;
+    for (std::size_t i = 0; i < HEAVY_ITERATIONS; i++) {
+        acc = acc * 31 + i;
+    }
+    auto writer = sh::http_response_writer::create(conn, req);
+    writer->write(std::to_string(acc));
+    writer->send();
+}
+
+void bench_offloaded_handlers() {
+    for (bool offloaded : {false, true}) {
+        sh::http_server server(2, TCP_PORT);
+        if (offloaded) {
+            server.add_offloaded_handler("GET", "/heavy", heavy_handler);
+        } else {
+            server.add_handler("GET", "/heavy", heavy_handler);
+        }
+        server.add_handler("GET", "/light", [](sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+            auto writer = sh::http_response_writer::create(conn, req);
+            writer->write("{\"result\": 42}");
+            writer->send();
+        });
+        server.start();
+        std::atomic<bool> running{true};
+        std::vector<std::thread> clients;
+        for (std::size_t i = 0; i < HEAVY_CLIENTS; i++) {
+            clients.emplace_back([&running] {
+                while (running) {
+                    fetch("/heavy", "identity");
+                }
+            });
+        }
+        double worst = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < JSON_REQUESTS / 10; i++) {
+            auto req_start = std::chrono::steady_clock::now();
+            fetch("/light", "identity");
+            worst = (std::max)(worst, elapsed_seconds(req_start));
+        }
+        double secs = elapsed_seconds(start);
+        running = false;
+        for (auto& th : clients) {
+            th.join();
+        }
+        server.stop(true);
+        std::cout << "light requests next to heavy ones, " << (offloaded ? "offloaded" : "inline") << ": "
+                << JSON_REQUESTS / 10 / secs << " req/s, worst latency: " << worst * 1000 << " ms" << std::endl;
+    }
+}
+
+void bench_priority_lanes() {
+    for (bool lanes : {false, true}) {
+        sh::http_server server(2, TCP_PORT);
+        server.set_worker_threads(2);
+        uint32_t reports = sh::priority_lanes::DEFAULT_LANE;
+        uint32_t lookups = sh::priority_lanes::DEFAULT_LANE;
+        if (lanes) {
+            reports = server.add_priority_lane("reports", 1, 1);
+            lookups = server.add_priority_lane("lookups", 8);
+        }
+        server.add_offloaded_handler("GET", "/report", heavy_handler, reports);
+        server.add_offloaded_handler("GET", "/lookup", [](sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+            auto writer = sh::http_response_writer::create(conn, req);
+            writer->write("{\"result\": 42}");
+            writer->send();
+        }, lookups);
+        server.start();
+        std::atomic<bool> running{true};
+        std::vector<std::thread> clients;
+        for (std::size_t i = 0; i < HEAVY_CLIENTS; i++) {
+            clients.emplace_back([&running] {
+                while (running) {
+                    fetch("/report", "identity");
+                }
+            });
+        }
+        double worst = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < JSON_REQUESTS / 10; i++) {
+            auto req_start = std::chrono::steady_clock::now();
+            fetch("/lookup", "identity");
+            worst = (std::max)(worst, elapsed_seconds(req_start));
+        }
+        double secs = elapsed_seconds(start);
+        running = false;
+        for (auto& th : clients) {
+            th.join();
+        }
+        auto stats = server.get_priority_lanes().get_stats(lookups);
+        server.stop(true);
+        std::cout << "lookups next to reports, " << (lanes ? "separate lanes" : "single lane") << ": "
+                << JSON_REQUESTS / 10 / secs << " req/s, worst latency: " << worst * 1000 << " ms, "
+                << "max queue time: " << stats.queue_time_max_micros / 1000.0 << " ms" << std::endl;
+    }
+}
+
+void moderate_handler(sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+    volatile uint64_t acc = 0;
+    for (std::size_t i = 0; i < HEAVY_ITERATIONS / 20; i++) {
+        acc = acc * 31 + i;
+    }
+    auto writer = sh::http_response_writer::create(conn, req);
+    writer->write(std::to_string(acc));
+    writer->send();
+}
+
+bool fetch_ok(const std::string& path) {
+    asio::io_service io_service;
+    asio::ip::tcp::socket socket(io_service);
+    socket.connect(asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), TCP_PORT));
+    std::string req = "GET " + path + " HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n";
+    asio::write(socket, asio::buffer(req));
+    std::array<char, 4096> buf;
+    std::string resp;
+    asio::error_code ec;
+    while (!ec) {
+        std::size_t len = socket.read_some(asio::buffer(buf), ec);
+        resp.append(buf.data(), len);
+    }
+    return 0 == resp.compare(0, 12, "HTTP/1.1 200");
+}
+
+void bench_overload_control() {
+    for (bool control : {false, true}) {
+        sh::http_server server(2, TCP_PORT);
+        server.set_worker_threads(2);
+        if (control) {
+            server.enable_overload_control(64);
+        }
+        server.add_offloaded_handler("GET", "/work", moderate_handler);
+        server.start();
+        std::mutex mutex;
+        std::vector<double> latencies;
+        std::atomic<std::size_t> rejected{0};
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(OVERLOAD_SECONDS);
+        std::vector<std::thread> clients;
+        for (std::size_t i = 0; i < OVERLOAD_CLIENTS; i++) {
+            clients.emplace_back([&] {
+                std::vector<double> local;
+                while (std::chrono::steady_clock::now() < deadline) {
+                    auto start = std::chrono::steady_clock::now();
+                    if (fetch_ok("/work")) {
+                        local.push_back(elapsed_seconds(start));
+                    } else {
+                        rejected += 1;
+                        // client honours "Retry-After" in a shortened form
+                        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                    }
+                }
+                std::lock_guard<std::mutex> guard{mutex};
+                latencies.insert(latencies.end(), local.begin(), local.end());
+            });
+        }
+        for (auto& th : clients) {
+            th.join();
+        }
+        server.stop(true);
+        std::sort(latencies.begin(), latencies.end());
+        double p50 = latencies.empty() ? 0 : latencies[latencies.size() / 2];
+        double p99 = latencies.empty() ? 0 : latencies[latencies.size() * 99 / 100];
+        std::cout << "overload, control " << (control ? "on: " : "off: ") << latencies.size() / OVERLOAD_SECONDS
+                << " ok req/s, rejected: " << rejected << ", p50: " << p50 * 1000 << " ms, p99: "
+                << p99 * 1000 << " ms" << std::endl;
+    }
+}
+
+// token buckets behind a single mutex, baseline for the striped limiter
+class global_rate_limiter {
+    struct bucket {
+        double tokens;
+        std::chrono::steady_clock::time_point updated;
+    };
+    std::mutex mutex;
+    std::unordered_map<std::string, bucket> buckets;
+    double rate;
+    double burst;
+
+public:
+    global_rate_limiter(double rate, double burst) :
+    rate(rate),
+    burst(burst) { }
+
+    bool try_acquire(const std::string& key) {
+        auto now = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> guard{mutex};
+        auto it = buckets.find(key);
+        if (buckets.end() == it) {
+            it = buckets.emplace(key, bucket{burst, now}).first;
+        } else {
+            double secs = std::chrono::duration<double>(now - it->second.updated).count();
+            it->second.tokens = std::min(it->second.tokens + secs * rate, burst);
+            it->second.updated = now;
+        }
+        if (it->second.tokens < 1) return false;
+        it->second.tokens -= 1;
+        return true;
+    }
+};
+
+template<typename Limiter>
+double run_rate_limiter(Limiter& limiter, const std::vector<std::string>& keys) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < RATE_LIMIT_THREADS; i++) {
+        threads.emplace_back([&limiter, &keys, i] {
+            uint32_t seed = static_cast<uint32_t>(i + 1);
+            for (std::size_t j = 0; j < RATE_LIMIT_CHECKS; j++) {
+                seed = seed * 1664525 + 1013904223;
+                limiter.try_acquire(keys[(seed >> 8) % keys.size()]);
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    return RATE_LIMIT_THREADS * RATE_LIMIT_CHECKS / elapsed_seconds(start);
+}
+
+void bench_rate_limiter() {
+    std::vector<std::string> keys;
+    for (std::size_t i = 0; i < RATE_LIMIT_KEYS; i++) {
+        keys.push_back("10." + std::to_string(i / 65536) + "." + std::to_string(i / 256 % 256) + "." +
+                std::to_string(i % 256));
+    }
+    global_rate_limiter global(100, 50);
+    double global_rate = run_rate_limiter(global, keys);
+    sh::rate_limiter striped(100, 50);
+    double striped_rate = run_rate_limiter(striped, keys);
+    std::cout << "rate limiter, " << RATE_LIMIT_THREADS << " threads, single mutex: " <<
+            static_cast<uint64_t>(global_rate) << " checks/s, striped: " <<
+            static_cast<uint64_t>(striped_rate) << " checks/s" << std::endl;
+}
+
+void slow_handler(sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+    // waits for a slow backend, gives up as soon as the request is cancelled
+    for (std::size_t i = 0; i < SLOW_HANDLER_MILLIS && !req->is_cancelled(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    auto writer = sh::http_response_writer::create(conn, req);
+    writer->write("slow");
+    writer->send();
+}
+
+void bench_handler_deadlines() {
+    for (bool limited : {false, true}) {
+        sh::http_server server(2, TCP_PORT);
+        server.set_worker_threads(4);
+        server.add_offloaded_handler("GET", "/slow", slow_handler);
+        if (limited) {
+            server.set_handler_deadline("GET", "/slow", std::chrono::milliseconds(50));
+        }
+        server.start();
+        std::atomic<std::size_t> responses{0};
+        std::atomic<uint64_t> total_micros{0};
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(DEADLINE_SECONDS);
+        std::vector<std::thread> clients;
+        for (std::size_t i = 0; i < DEADLINE_CLIENTS; i++) {
+            clients.emplace_back([&] {
+                while (std::chrono::steady_clock::now() < deadline) {
+                    auto start = std::chrono::steady_clock::now();
+                    fetch_ok("/slow");
+                    responses += 1;
+                    total_micros += static_cast<uint64_t>(elapsed_seconds(start) * 1000000);
+                }
+            });
+        }
+        for (auto& th : clients) {
+            th.join();
+        }
+        server.stop(true);
+        std::cout << "slow handlers, deadline " << (limited ? "50 ms: " : "off: ") << responses / DEADLINE_SECONDS
+                << " resp/s, mean latency: " << total_micros / (responses * 1000) << " ms" << std::endl;
+    }
+}
+
+void bench_slow_clients() {
+    for (bool limited : {false, true}) {
+        sh::http_server server(2, TCP_PORT);
+        server.add_handler("GET", "/", [](sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+            auto writer = sh::http_response_writer::create(conn, req);
+            writer->write("hello");
+            writer->send();
+        });
+        if (limited) {
+            server.set_slow_client_policy(std::chrono::seconds(1), std::chrono::seconds(1), 64 * 1024);
+        }
+        server.start();
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(SLOWLORIS_SECONDS);
+        // each slowloris sends a header byte well within the read timeout
+        std::thread slowloris([&] {
+            asio::io_service io_service;
+            std::vector<std::unique_ptr<asio::ip::tcp::socket>> sockets;
+            for (std::size_t i = 0; i < SLOWLORIS_CLIENTS; i++) {
+                sockets.emplace_back(new asio::ip::tcp::socket(io_service));
+                sockets.back()->connect(asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), TCP_PORT));
+                asio::write(*sockets.back(), asio::buffer(std::string("GET / HTTP/1.1\r\n")));
+            }
+            while (std::chrono::steady_clock::now() < deadline) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(SLOWLORIS_BYTE_MILLIS));
+                for (auto& sock : sockets) {
+                    asio::error_code ec;
+                    asio::write(*sock, asio::buffer(std::string("X")), ec);
+                }
+            }
+            std::size_t held = server.get_connections();
+            auto stats = server.get_slow_client_stats();
+            std::cout << "slowloris clients, policy " << (limited ? "on: " : "off: ") << held
+                    << " connections held after " << SLOWLORIS_SECONDS << " s, "
+                    << stats.header_timeouts << " closed" << std::endl;
+        });
+        std::size_t requests = 0;
+        auto start = std::chrono::steady_clock::now();
+        while (std::chrono::steady_clock::now() < deadline) {
+            fetch_ok("/");
+            requests += 1;
+        }
+        double secs = elapsed_seconds(start);
+        slowloris.join();
+        server.stop(false);
+        std::cout << "normal client next to slowloris, policy " << (limited ? "on: " : "off: ")
+                << requests / secs << " req/s" << std::endl;
+    }
+}
+
+void bench_pipelining() {
+    for (uint32_t depth : {1u, static_cast<uint32_t>(PIPELINE_DEPTH)}) {
+        sh::http_server server(2, TCP_PORT);
+        server.set_worker_threads(PIPELINE_DEPTH);
+        server.set_pipeline_depth(depth);
+        server.add_offloaded_handler("GET", "/", [](sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(PIPELINE_HANDLER_MILLIS));
+            auto writer = sh::http_response_writer::create(conn, req);
+            writer->write("ok");
+            writer->send();
+        });
+        server.start();
+        std::string batch;
+        for (std::size_t i = 0; i < PIPELINE_DEPTH; i++) {
+            batch.append("GET / HTTP/1.1\r\nHost: 127.0.0.1\r\n\r\n");
+        }
+        asio::io_service io_service;
+        asio::ip::tcp::socket socket(io_service);
+        socket.connect(asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), TCP_PORT));
+        std::array<char, 8192> buf;
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < PIPELINE_BATCHES; i++) {
+            // all requests of the batch are sent with a single write
+            asio::write(socket, asio::buffer(batch));
+            std::string received;
+            std::size_t responses = 0;
+            std::size_t pos = 0;
+            while (responses < PIPELINE_DEPTH) {
+                std::size_t len = socket.read_some(asio::buffer(buf));
+                received.append(buf.data(), len);
+                while (std::string::npos != (pos = received.find("\r\n\r\nok", pos))) {
+                    responses += 1;
+                    pos += 6;
+                }
+                pos = received.length() > 5 ? received.length() - 5 : 0;
+            }
+        }
+        double secs = elapsed_seconds(start);
+        socket.close();
+        server.stop(true);
+        std::cout << "pipelined requests, depth " << depth << ": "
+                << PIPELINE_BATCHES * PIPELINE_DEPTH / secs << " req/s" << std::endl;
+    }
+}
+
+void bench_speculative_io() {
+    for (bool speculative : {false, true}) {
+        sh::http_server server(2, TCP_PORT);
+        server.set_speculative_io(speculative);
+        server.add_handler("GET", "/", [](sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+            auto writer = sh::http_response_writer::create(conn, req);
+            writer->write("hello");
+            writer->send();
+        });
+        server.start();
+        std::atomic<std::size_t> requests{0};
+        std::atomic<uint64_t> total_micros{0};
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(KEEPALIVE_SECONDS);
+        std::vector<std::thread> clients;
+        for (std::size_t i = 0; i < KEEPALIVE_CLIENTS; i++) {
+            clients.emplace_back([&] {
+                asio::io_service io_service;
+                asio::ip::tcp::socket socket(io_service);
+                socket.connect(asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), TCP_PORT));
+                socket.set_option(asio::ip::tcp::no_delay(true));
+                std::string req = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+                std::array<char, 4096> buf;
+                while (std::chrono::steady_clock::now() < deadline) {
+                    auto start = std::chrono::steady_clock::now();
+                    asio::write(socket, asio::buffer(req));
+                    std::string resp;
+                    while (resp.length() < 5 || 0 != resp.compare(resp.length() - 5, 5, "hello")) {
+                        std::size_t len = socket.read_some(asio::buffer(buf));
+                        resp.append(buf.data(), len);
+                    }
+                    requests += 1;
+                    total_micros += static_cast<uint64_t>(elapsed_seconds(start) * 1000000);
+                }
+            });
+        }
+        for (auto& th : clients) {
+            th.join();
+        }
+        server.stop(true);
+        auto stats = server.get_speculative_io_stats();
+        double count = static_cast<double>(requests);
+        std::cout << "keep-alive requests, speculative I/O " << (speculative ? "on: " : "off: ")
+                << requests / KEEPALIVE_SECONDS << " req/s, mean latency: " << total_micros / requests << " us, "
+                << "per request: non-blocking reads " << stats.reads_completed / count << " ("
+                << stats.reads_would_block / count << " would block), non-blocking writes "
+                << stats.writes_completed / count << " (" << stats.writes_would_block / count << " would block)"
+                << std::endl;
+    }
+}
+
+void bench_io_uring() {
+    for (auto transport : {sh::tcp_server::TRANSPORT_REACTOR, sh::tcp_server::TRANSPORT_IO_URING}) {
+        for (bool speculative : {false, true}) {
+            sh::http_server server(2, TCP_PORT);
+            server.set_transport(transport);
+            server.set_speculative_io(speculative);
+            server.add_handler("GET", "/", [](sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+                auto writer = sh::http_response_writer::create(conn, req);
+                writer->write("hello");
+                writer->send();
+            });
+            server.start();
+            if (server.get_transport() != transport) {
+                std::cout << "keep-alive requests, io_uring: not available" << std::endl;
+                server.stop(true);
+                break;
+            }
+            std::atomic<std::size_t> requests{0};
+            std::atomic<uint64_t> total_micros{0};
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(KEEPALIVE_SECONDS);
+            std::vector<std::thread> clients;
+            for (std::size_t i = 0; i < KEEPALIVE_CLIENTS; i++) {
+                clients.emplace_back([&] {
+                    asio::io_service io_service;
+                    asio::ip::tcp::socket socket(io_service);
+                    socket.connect(asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), TCP_PORT));
+                    socket.set_option(asio::ip::tcp::no_delay(true));
+                    std::string req = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+                    std::array<char, 4096> buf;
+                    while (std::chrono::steady_clock::now() < deadline) {
+                        auto start = std::chrono::steady_clock::now();
+                        asio::write(socket, asio::buffer(req));
+                        std::string resp;
+                        while (resp.length() < 5 || 0 != resp.compare(resp.length() - 5, 5, "hello")) {
+                            std::size_t len = socket.read_some(asio::buffer(buf));
+                            resp.append(buf.data(), len);
+                        }
+                        requests += 1;
+                        total_micros += static_cast<uint64_t>(elapsed_seconds(start) * 1000000);
+                    }
+                });
+            }
+            for (auto& th : clients) {
+                th.join();
+            }
+            server.stop(true);
+            std::cout << "keep-alive requests, "
+                    << (sh::tcp_server::TRANSPORT_IO_URING == transport ? "io_uring" : "reactor")
+                    << (speculative ? " with speculative I/O: " : ": ")
+                    << requests / KEEPALIVE_SECONDS << " req/s, mean latency: "
+                    << total_micros / requests << " us" << std::endl;
+        }
+    }
+}
+
+void bench_busy_poll() {
+    for (bool busy_poll : {false, true}) {
+        sh::http_server server(2, TCP_PORT);
+        if (busy_poll) {
+            server.get_active_scheduler().set_busy_poll(std::chrono::microseconds(BUSY_POLL_MICROS));
+        }
+        server.add_handler("GET", "/", [](sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+            auto writer = sh::http_response_writer::create(conn, req);
+            writer->write("hello");
+            writer->send();
+        });
+        server.start();
+        std::atomic<std::size_t> requests{0};
+        std::atomic<uint64_t> total_micros{0};
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(KEEPALIVE_SECONDS);
+        std::vector<std::thread> clients;
+        for (std::size_t i = 0; i < BUSY_POLL_CLIENTS; i++) {
+            clients.emplace_back([&] {
+                asio::io_service io_service;
+                asio::ip::tcp::socket socket(io_service);
+                socket.connect(asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), TCP_PORT));
+                socket.set_option(asio::ip::tcp::no_delay(true));
+                std::string req = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n";
+                std::array<char, 4096> buf;
+                while (std::chrono::steady_clock::now() < deadline) {
+                    auto start = std::chrono::steady_clock::now();
+                    asio::write(socket, asio::buffer(req));
+                    std::string resp;
+                    while (resp.length() < 5 || 0 != resp.compare(resp.length() - 5, 5, "hello")) {
+                        std::size_t len = socket.read_some(asio::buffer(buf));
+                        resp.append(buf.data(), len);
+                    }
+                    requests += 1;
+                    total_micros += static_cast<uint64_t>(elapsed_seconds(start) * 1000000);
+                }
+            });
+        }
+        for (auto& th : clients) {
+            th.join();
+        }
+        server.stop(true);
+        auto stats = server.get_active_scheduler().get_busy_poll_stats();
+        std::cout << "keep-alive requests, busy-poll " << (busy_poll ? "on: " : "off: ")
+                << requests / KEEPALIVE_SECONDS << " req/s, mean latency: " << total_micros / requests << " us";
+        if (busy_poll) {
+            std::cout << ", spin: " << stats.spin_micros / 1000 << " ms, blocked: "
+                    << stats.block_micros / 1000 << " ms (" << stats.blocks_count << " times)";
+        }
+        std::cout << std::endl;
+    }
+}
+
+int main() {
+    try {
+        bench_upload();
+        bench_download();
+        bench_compression();
+        bench_serialization();
+        bench_common_headers();
+        bench_canned_response();
+        bench_output_buffer();
+        bench_text_formatting();
+        bench_chunked_streaming();
+        bench_body_source();
+        bench_queued_chunks();
+        bench_cross_thread_completion();
+        bench_offloaded_handlers();
+        bench_priority_lanes();
+        bench_overload_control();
+        bench_rate_limiter();
+        bench_handler_deadlines();
+        bench_slow_clients();
+        bench_pipelining();
+        bench_speculative_io();
+        bench_io_uring();
+        bench_busy_poll();
+    } catch (const std::exception& e) {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -32,6 +32,8 @@
 #include <climits>
 #include <cerrno>
 #include <cctype>
+#include <cstring>
+#include <memory>
 
 namespace staticlib { 
 namespace httpserver {
@@ -75,6 +77,52 @@ uint16_t parse_uint16(const std::string& str) {
     return static_cast<uint16_t> (l);
 }
 
+void append_decimal(std::string& str, uint64_t num) {
+    // enough for 2^64
+    char buf[20];
+    char* end = buf + sizeof(buf);
+    char* ptr = end;
+    do {
+        *--ptr = static_cast<char>('0' + num % 10);
+        num /= 10;
+    } while (num > 0);
+    str.append(ptr, static_cast<std::size_t>(end - ptr));
+}
+
+void append_http_date(std::string& str, std::time_t t) {
+    static const char* days = "SunMonTueWedThuFriSat";
+    static const char* months = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    struct tm tm_val;
+#ifdef _WIN32
+    gmtime_s(std::addressof(tm_val), std::addressof(t));
+#else
+    gmtime_r(std::addressof(t), std::addressof(tm_val));
+#endif // _WIN32
+    char buf[29];
+    auto two_digits = [](char* dest, int val) {
+        dest[0] = static_cast<char>('0' + val / 10);
+        dest[1] = static_cast<char>('0' + val % 10);
+    };
+    std::memcpy(buf, days + tm_val.tm_wday * 3, 3);
+    buf[3] = ',';
+    buf[4] = ' ';
+    two_digits(buf + 5, tm_val.tm_mday);
+    buf[7] = ' ';
+    std::memcpy(buf + 8, months + tm_val.tm_mon * 3, 3);
+    buf[11] = ' ';
+    int year = tm_val.tm_year + 1900;
+    two_digits(buf + 12, year / 100);
+    two_digits(buf + 14, year % 100);
+    buf[16] = ' ';
+    two_digits(buf + 17, tm_val.tm_hour);
+    buf[19] = ':';
+    two_digits(buf + 20, tm_val.tm_min);
+    buf[22] = ':';
+    two_digits(buf + 23, tm_val.tm_sec);
+    std::memcpy(buf + 25, " GMT", 4);
+    str.append(buf, sizeof(buf));
+}
+
 // http://stackoverflow.com/a/17976541
 std::string trim(const std::string& s) {
     auto wsfront = std::find_if_not(s.begin(), s.end(), [](int c) {
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   buffer_pool.cpp
+ * Author: agent
+ *
+ * Created on October 18, 2026, 7:06 PM
+ */
+
+#include "staticlib/httpserver/buffer_pool.hpp"
+
+#include <vector>
+
+namespace staticlib { 
+namespace httpserver {
+namespace buffer_pool {
+
+namespace { // anonymous
+
+std::vector<std::string>& thread_pool() {
+    thread_local std::vector<std::string> pool;
+    return pool;
+}
+
+} // namespace
+
+std::string acquire(std::size_t capacity) {
+    auto& pool = thread_pool();
+    std::string res;
+    if (!pool.empty()) {
+        res = std::move(pool.back());
+        pool.pop_back();
+    }
+    res.reserve(capacity);
+    return res;
+}
+
+void release(std::string&& buf) {
+    auto& pool = thread_pool();
+    if (buf.capacity() <= BUFFER_MAX_CAPACITY && pool.size() < POOL_MAX_SIZE) {
+        buf.clear();
+        pool.emplace_back(std::move(buf));
+    } else {
+        std::string().swap(buf);
+    }
+}
+
+} // namespace
+} // namespace
+}
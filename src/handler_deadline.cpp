@@ -0,0 +1,120 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   handler_deadline.cpp
+ * Author: agent
+ *
+ * Created on October 18, 2026, 10:36 PM
+ */
+
+#include "staticlib/httpserver/handler_deadline.hpp"
+
+namespace staticlib {
+namespace httpserver {
+
+namespace { // anonymous
+
+const int STATE_PENDING = 0;
+const int STATE_RESPONDING = 1;
+const int STATE_EXPIRED = 2;
+
+} // namespace
+
+// cancellation_token
+
+cancellation_token::cancellation_token() :
+m_cancelled(false) { }
+
+bool cancellation_token::is_cancelled() const {
+    return m_cancelled.load(std::memory_order_acquire);
+}
+
+void cancellation_token::subscribe(std::function<void()> callback) {
+    {
+        std::lock_guard<std::mutex> guard{m_mutex};
+        if (!m_cancelled.load(std::memory_order_relaxed)) {
+            m_callbacks.emplace_back(std::move(callback));
+            return;
+        }
+    }
+    callback();
+}
+
+bool cancellation_token::cancel() {
+    std::vector<std::function<void()>> callbacks;
+    {
+        std::lock_guard<std::mutex> guard{m_mutex};
+        if (m_cancelled.load(std::memory_order_relaxed)) return false;
+        m_cancelled.store(true, std::memory_order_release);
+        callbacks.swap(m_callbacks);
+    }
+    // callbacks may subscribe again, so they are run unlocked
+    for (auto& cb : callbacks) {
+        cb();
+    }
+    return true;
+}
+
+// handler_deadline
+
+handler_deadline::handler_deadline(asio::io_service& io_service) :
+m_token(std::make_shared<cancellation_token>()),
+m_timer(io_service),
+m_state(STATE_PENDING) { }
+
+void handler_deadline::start(std::chrono::steady_clock::duration timeout, expired_handler_type handler) {
+    m_expiry = std::chrono::steady_clock::now() + timeout;
+    m_timer.expires_at(m_expiry);
+    auto self = shared_from_this();
+    m_timer.async_wait([self, handler](const asio::error_code& ec) {
+        self->timer_callback(ec, handler);
+    });
+}
+
+bool handler_deadline::start_response() {
+    int expected = STATE_PENDING;
+    if (m_state.compare_exchange_strong(expected, STATE_RESPONDING)) {
+        // timer is started before the handler is run, so cancel
+        // cannot overlap with the async_wait call
+        m_timer.cancel();
+        return true;
+    }
+    return STATE_RESPONDING == expected;
+}
+
+bool handler_deadline::is_expired() const {
+    return STATE_EXPIRED == m_state.load();
+}
+
+std::chrono::steady_clock::time_point handler_deadline::get_expiry() const {
+    return m_expiry;
+}
+
+const std::shared_ptr<cancellation_token>& handler_deadline::get_token() const {
+    return m_token;
+}
+
+void handler_deadline::timer_callback(const asio::error_code&, const expired_handler_type& handler) {
+    // timer may complete just before it is cancelled, state decides the outcome
+    int expected = STATE_PENDING;
+    if (!m_state.compare_exchange_strong(expected, STATE_EXPIRED)) return;
+    m_token->cancel();
+    handler();
+}
+
+} // namespace
+}
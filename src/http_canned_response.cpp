@@ -0,0 +1,203 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   http_canned_response.cpp
+ * Author: agent
+ *
+ * Created on October 18, 2026, 7:27 PM
+ */
+
+#include "staticlib/httpserver/http_canned_response.hpp"
+
+#include <memory>
+
+#include "asio.hpp"
+
+#include "staticlib/httpserver/algorithm.hpp"
+#include "staticlib/httpserver/buffer_pool.hpp"
+#include "staticlib/httpserver/handler_deadline.hpp"
+#include "staticlib/httpserver/http_common_headers.hpp"
+#include "staticlib/httpserver/http_message.hpp"
+#include "staticlib/httpserver/response_pipeline.hpp"
+
+namespace staticlib { 
+namespace httpserver {
+
+const std::string http_canned_response::SLOT_MARKER = "{{}}";
+
+namespace { // anonymous
+
+const std::size_t HEADERS_RESERVE = 192;
+
+std::size_t escaped_length_max(const std::string& str) {
+    // "\u00XX" for every char in the worst case
+    return str.length() * 6;
+}
+
+void append_escaped(std::string& buf, const std::string& str) {
+    static const char* HEX = "0123456789abcdef";
+    for (char ch : str) {
+        unsigned char uch = static_cast<unsigned char>(ch);
+        switch (ch) {
+        case '"': buf.append("\\\""); break;
+        case '\\': buf.append("\\\\"); break;
+        case '\n': buf.append("\\n"); break;
+        case '\r': buf.append("\\r"); break;
+        case '\t': buf.append("\\t"); break;
+        case '<': case '>': case '&': case '\'':
+            buf.append("\\u00");
+            buf.push_back(HEX[uch >> 4]);
+            buf.push_back(HEX[uch & 0xf]);
+            break;
+        default:
+            if (uch < 0x20) {
+                buf.append("\\u00");
+                buf.push_back(HEX[uch >> 4]);
+                buf.push_back(HEX[uch & 0xf]);
+            } else {
+                buf.push_back(ch);
+            }
+        }
+    }
+}
+
+void write_response(const http_request& request, tcp_connection_ptr& conn, const std::string& buf,
+        tcp_connection::io_handler_type handler) {
+    const std::shared_ptr<response_pipeline>& pipeline = request.get_pipeline();
+    if (pipeline) {
+        // written after the responses to the preceding requests
+        std::vector<asio::const_buffer> buffers;
+        buffers.emplace_back(asio::buffer(buf));
+        pipeline->async_write(conn, request.get_pipeline_index(), buffers, true, std::move(handler));
+    } else {
+        conn->async_write(asio::buffer(buf), std::move(handler));
+    }
+}
+
+} // namespace
+
+http_canned_response::http_canned_response(unsigned int status_code, const std::string& status_message,
+        const std::string& content_type, const std::string& body_template, bool escape_slots) :
+m_body_parts_length(0),
+m_escape_slots(escape_slots) {
+    std::string status;
+    algorithm::append_decimal(status, status_code);
+    status.append(" ");
+    status.append(status_message);
+    status.append(http_message::STRING_CRLF);
+    m_head_http11.append(http_message::STRING_HTTP_VERSION);
+    m_head_http11.append("1.1 ");
+    m_head_http11.append(status);
+    m_head_http10.append(http_message::STRING_HTTP_VERSION);
+    m_head_http10.append("1.0 ");
+    m_head_http10.append(status);
+    if (!content_type.empty()) {
+        add_header(http_message::HEADER_CONTENT_TYPE, content_type);
+    }
+    std::size_t start = 0;
+    for (;;) {
+        auto pos = body_template.find(SLOT_MARKER, start);
+        m_body_parts.emplace_back(body_template.substr(start, std::string::npos == pos ? pos : pos - start));
+        m_body_parts_length += m_body_parts.back().length();
+        if (std::string::npos == pos) break;
+        start = pos + SLOT_MARKER.length();
+    }
+}
+
+http_canned_response& http_canned_response::add_header(const std::string& name, const std::string& value) {
+    for (std::string* head : {std::addressof(m_head_http11), std::addressof(m_head_http10)}) {
+        head->append(name);
+        head->append(http_message::HEADER_NAME_VALUE_DELIMITER);
+        head->append(value);
+        head->append(http_message::STRING_CRLF);
+    }
+    return *this;
+}
+
+void http_canned_response::send(const http_request& request, tcp_connection_ptr& conn,
+        slot_values_type slot_values) const {
+    const std::shared_ptr<handler_deadline>& deadline = request.get_deadline();
+    if (deadline && !deadline->start_response()) return;
+    auto buf = render(request, conn, slot_values);
+    tcp_connection_ptr conn_holder = conn;
+    write_response(request, conn, *buf, [buf, conn_holder](const asio::error_code& ec, std::size_t) {
+        buffer_pool::release(std::move(*buf));
+        if (ec) conn_holder->set_lifecycle(tcp_connection::LIFECYCLE_CLOSE);
+        conn_holder->finish();
+    });
+}
+
+void http_canned_response::send(const http_request& request, tcp_connection_ptr& conn,
+        finished_handler_type handler, slot_values_type slot_values) const {
+    auto buf = render(request, conn, slot_values);
+    write_response(request, conn, *buf, [buf, handler](const asio::error_code& ec, std::size_t) {
+        buffer_pool::release(std::move(*buf));
+        handler(ec);
+    });
+}
+
+std::shared_ptr<std::string> http_canned_response::render(const http_request& request, tcp_connection_ptr& conn,
+        slot_values_type slot_values) const {
+    const std::shared_ptr<response_pipeline>& pipeline = request.get_pipeline();
+    bool keep_alive = pipeline ? pipeline->get_keep_alive(request.get_pipeline_index()) : conn->get_keep_alive();
+    bool body_allowed = http_message::REQUEST_METHOD_HEAD != request.get_method();
+    // same version rule as in http_message::check_keep_alive
+    bool http11 = request.get_version_major() > 1 ||
+            (1 == request.get_version_major() && request.get_version_minor() >= 1);
+    const std::string& head = http11 ? m_head_http11 : m_head_http10;
+    std::size_t reserve = head.length() + HEADERS_RESERVE + m_body_parts_length;
+    for (const std::string& val : slot_values) {
+        reserve += m_escape_slots ? escaped_length_max(val) : val.length();
+    }
+    auto buf = std::make_shared<std::string>(buffer_pool::acquire(reserve));
+    buf->append(head);
+    buf->append(keep_alive ? "Connection: Keep-Alive\r\n" : "Connection: close\r\n");
+    const http_common_headers* common = conn->get_common_headers();
+    if (nullptr != common) {
+        common->append_to(*buf);
+    }
+    // body is rendered after the headers, "Content-Length" is inserted
+    // when its length is known, header block is short, so move is cheap
+    buf->append(http_message::HEADER_CONTENT_LENGTH);
+    buf->append(http_message::HEADER_NAME_VALUE_DELIMITER);
+    std::size_t length_pos = buf->length();
+    buf->append(http_message::STRING_CRLF);
+    buf->append(http_message::STRING_CRLF);
+    std::size_t body_pos = buf->length();
+    auto it = slot_values.begin();
+    for (std::size_t i = 0; i < m_body_parts.size(); i++) {
+        if (i > 0 && slot_values.end() != it) {
+            const std::string& val = *it++;
+            if (m_escape_slots) {
+                append_escaped(*buf, val);
+            } else {
+                buf->append(val);
+            }
+        }
+        buf->append(m_body_parts[i]);
+    }
+    std::string len;
+    algorithm::append_decimal(len, buf->length() - body_pos);
+    buf->insert(length_pos, len);
+    if (!body_allowed) {
+        buf->resize(body_pos + len.length());
+    }
+    return buf;
+}
+
+} // namespace
+}
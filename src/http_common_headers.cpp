@@ -0,0 +1,92 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   http_common_headers.cpp
+ * Author: agent
+ *
+ * Created on October 18, 2026, 7:19 PM
+ */
+
+#include "staticlib/httpserver/http_common_headers.hpp"
+
+#include <memory>
+#include <cstring>
+
+#include "staticlib/httpserver/algorithm.hpp"
+
+namespace staticlib { 
+namespace httpserver {
+
+const std::size_t http_common_headers::DATE_LINE_LENGTH;
+const std::size_t http_common_headers::DATE_WORDS_COUNT;
+
+http_common_headers::http_common_headers() :
+m_sequence(0),
+m_current_time(0) {
+    for (auto& word : m_date_words) {
+        word.store(0, std::memory_order_relaxed);
+    }
+    update(std::time(nullptr));
+}
+
+void http_common_headers::add_header(const std::string& name, const std::string& value) {
+    m_fixed_headers.append(name);
+    m_fixed_headers.append(": ");
+    m_fixed_headers.append(value);
+    m_fixed_headers.append("\r\n");
+    // re-render to include new header
+    m_current_time.store(0, std::memory_order_relaxed);
+    update(std::time(nullptr));
+}
+
+void http_common_headers::update(std::time_t now) {
+    if (now == m_current_time.load(std::memory_order_relaxed)) return;
+    // buffer keeps its capacity, so no allocations after the first update
+    m_date_line.clear();
+    m_date_line.append("Date: ");
+    algorithm::append_http_date(m_date_line, now);
+    m_date_line.append("\r\n");
+    m_date_line.resize(DATE_WORDS_COUNT * sizeof(uint64_t));
+    uint32_t seq = m_sequence.load(std::memory_order_relaxed);
+    m_sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (std::size_t i = 0; i < DATE_WORDS_COUNT; i++) {
+        uint64_t word;
+        std::memcpy(std::addressof(word), m_date_line.data() + i * sizeof(uint64_t), sizeof(uint64_t));
+        m_date_words[i].store(word, std::memory_order_relaxed);
+    }
+    m_sequence.store(seq + 2, std::memory_order_release);
+    m_current_time.store(now, std::memory_order_relaxed);
+}
+
+void http_common_headers::append_to(std::string& buf) const {
+    std::array<char, DATE_WORDS_COUNT * sizeof(uint64_t)> date;
+    uint32_t seq;
+    do {
+        seq = m_sequence.load(std::memory_order_acquire);
+        for (std::size_t i = 0; i < DATE_WORDS_COUNT; i++) {
+            uint64_t word = m_date_words[i].load(std::memory_order_relaxed);
+            std::memcpy(date.data() + i * sizeof(uint64_t), std::addressof(word), sizeof(uint64_t));
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while (0 != (seq & 1) || seq != m_sequence.load(std::memory_order_relaxed));
+    buf.append(date.data(), DATE_LINE_LENGTH);
+    buf.append(m_fixed_headers);
+}
+
+} // namespace
+}
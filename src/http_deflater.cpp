@@ -0,0 +1,205 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   http_deflater.cpp
+ * Author: agent
+ *
+ * Created on October 18, 2026, 6:56 PM
+ */
+
+#ifdef STATICLIB_HTTPSERVER_HAVE_ZLIB
+
+#include "staticlib/httpserver/http_deflater.hpp"
+
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "zlib.h"
+
+#include "staticlib/httpserver/algorithm.hpp"
+#include "staticlib/httpserver/httpserver_exception.hpp"
+
+namespace staticlib { 
+namespace httpserver {
+
+const std::size_t http_deflater::POOL_MAX_SIZE = 4;
+
+namespace { // anonymous
+
+const int WINDOW_BITS_GZIP = 15 + 16;
+const int WINDOW_BITS_ZLIB = 15;
+const int MEM_LEVEL = 8;
+// favours speed as nginx does by default, dynamic content is compressed on every request
+const int COMPRESSION_LEVEL = 1;
+
+// compressed formats that won't benefit from the additional compression
+const std::array<const char*, 10> INCOMPRESSIBLE_PREFIXES = {{
+    "image/", "audio/", "video/", "font/woff",
+    "application/zip", "application/gzip", "application/x-gzip",
+    "application/x-7z-compressed", "application/x-bzip2", "application/x-rar-compressed"
+}};
+
+std::string trim(const std::string& str) {
+    auto begin = str.find_first_not_of(" \t");
+    if (std::string::npos == begin) return std::string();
+    auto end = str.find_last_not_of(" \t");
+    return str.substr(begin, end - begin + 1);
+}
+
+bool starts_with_ignore_case(const std::string& str, const char* prefix) {
+    std::size_t len = std::strlen(prefix);
+    return str.size() >= len && algorithm::iequals(str.substr(0, len), prefix);
+}
+
+} // namespace
+
+class http_deflater::impl {
+    z_stream m_zs;
+    bool m_gzip;
+
+public:
+    explicit impl(bool gzip) :
+    m_gzip(gzip) {
+        std::memset(std::addressof(m_zs), '\0', sizeof(m_zs));
+        auto err = deflateInit2(std::addressof(m_zs), COMPRESSION_LEVEL, Z_DEFLATED,
+                gzip ? WINDOW_BITS_GZIP : WINDOW_BITS_ZLIB, MEM_LEVEL, Z_DEFAULT_STRATEGY);
+        if (Z_OK != err) {
+            throw httpserver_exception("Deflater initialization error: [" + std::to_string(err) + "]");
+        }
+    }
+
+    ~impl() {
+        deflateEnd(std::addressof(m_zs));
+    }
+
+    // idle contexts of the current thread
+    static std::vector<std::unique_ptr<impl>>& thread_pool(bool gzip) {
+        thread_local std::array<std::vector<std::unique_ptr<impl>>, 2> pools;
+        return pools[gzip ? 1 : 0];
+    }
+
+    bool is_gzip() const {
+        return m_gzip;
+    }
+
+    void reset() {
+        deflateReset(std::addressof(m_zs));
+    }
+
+    void deflate(const char* data, std::size_t len, int flush, std::string& out) {
+        m_zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+        m_zs.avail_in = static_cast<uInt>(len);
+        for (;;) {
+            std::size_t prev_size = out.size();
+            // enough for the whole input in most cases
+            std::size_t avail = deflateBound(std::addressof(m_zs), m_zs.avail_in) + 16;
+            out.resize(prev_size + avail);
+            m_zs.next_out = reinterpret_cast<Bytef*>(std::addressof(out[prev_size]));
+            m_zs.avail_out = static_cast<uInt>(avail);
+            auto err = ::deflate(std::addressof(m_zs), flush);
+            out.resize(out.size() - m_zs.avail_out);
+            if (Z_STREAM_ERROR == err) {
+                throw httpserver_exception("Response body deflate error: [" + std::to_string(err) + "]");
+            }
+            if (m_zs.avail_out > 0 && 0 == m_zs.avail_in) break;
+        }
+    }
+};
+
+http_deflater::http_deflater(const std::string& content_encoding) {
+    bool gzip = algorithm::iequals(content_encoding, "gzip");
+    if (!gzip && !algorithm::iequals(content_encoding, "deflate")) {
+        throw httpserver_exception("Unsupported content encoding: [" + content_encoding + "]");
+    }
+    auto& pool = impl::thread_pool(gzip);
+    if (!pool.empty()) {
+        m_impl = std::move(pool.back());
+        pool.pop_back();
+    } else {
+        m_impl.reset(new impl(gzip));
+    }
+}
+
+http_deflater::~http_deflater() {
+    auto& pool = impl::thread_pool(m_impl->is_gzip());
+    if (pool.size() < POOL_MAX_SIZE) {
+        m_impl->reset();
+        pool.emplace_back(std::move(m_impl));
+    }
+}
+
+std::string http_deflater::negotiate(const std::string& accept_encoding) {
+    float gzip_q = -1;
+    float deflate_q = -1;
+    float any_q = -1;
+    std::size_t pos = 0;
+    while (pos < accept_encoding.size()) {
+        auto end = accept_encoding.find(',', pos);
+        if (std::string::npos == end) end = accept_encoding.size();
+        std::string token = accept_encoding.substr(pos, end - pos);
+        pos = end + 1;
+        float q = 1;
+        auto semicolon = token.find(';');
+        if (std::string::npos != semicolon) {
+            std::string param = trim(token.substr(semicolon + 1));
+            if (starts_with_ignore_case(param, "q=")) {
+                q = static_cast<float>(std::atof(param.c_str() + 2));
+            }
+            token.resize(semicolon);
+        }
+        token = trim(token);
+        if (algorithm::iequals(token, "gzip") || algorithm::iequals(token, "x-gzip")) {
+            gzip_q = q;
+        } else if (algorithm::iequals(token, "deflate")) {
+            deflate_q = q;
+        } else if ("*" == token) {
+            any_q = q;
+        }
+    }
+    if (gzip_q < 0) gzip_q = any_q;
+    if (deflate_q < 0) deflate_q = any_q;
+    if (gzip_q > 0 && gzip_q >= deflate_q) return "gzip";
+    if (deflate_q > 0) return "deflate";
+    return std::string();
+}
+
+bool http_deflater::is_compressible(const std::string& content_type) {
+    for (const char* prefix : INCOMPRESSIBLE_PREFIXES) {
+        if (starts_with_ignore_case(content_type, prefix)) {
+            // SVG is a text format
+            return starts_with_ignore_case(content_type, "image/svg");
+        }
+    }
+    return true;
+}
+
+void http_deflater::deflate(const char* data, std::size_t len, std::string& out) {
+    if (len > 0) {
+        m_impl->deflate(data, len, Z_NO_FLUSH, out);
+    }
+}
+
+void http_deflater::flush(bool finish, std::string& out) {
+    m_impl->deflate(nullptr, 0, finish ? Z_FINISH : Z_SYNC_FLUSH, out);
+}
+
+} // namespace
+}
+
+#endif // STATICLIB_HTTPSERVER_HAVE_ZLIB
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* 
+ * File:   http_file_sink.cpp
+ * Author: agent
+ *
+ * Created on October 18, 2026, 6:30 PM
+ */
+
+#include "staticlib/httpserver/http_file_sink.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif // _WIN32
+
+#include "staticlib/httpserver/httpserver_exception.hpp"
+
+namespace staticlib { 
+namespace httpserver {
+
+namespace { // anonymous
+
+#ifdef _WIN32
+const int OPEN_FLAGS = _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY;
+
+int open_file(const std::string& path) {
+    return ::_open(path.c_str(), OPEN_FLAGS, _S_IREAD | _S_IWRITE);
+}
+
+int write_file(int fd, const char* data, std::size_t len) {
+    return ::_write(fd, data, static_cast<unsigned int>(len));
+}
+
+void close_file(int fd) {
+    ::_close(fd);
+}
+#else
+const int OPEN_FLAGS = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+
+int open_file(const std::string& path) {
+    return ::open(path.c_str(), OPEN_FLAGS, 0644);
+}
+
+ssize_t write_file(int fd, const char* data, std::size_t len) {
+    return ::write(fd, data, len);
+}
+
+void close_file(int fd) {
+    ::close(fd);
+}
+#endif // _WIN32
+
+void close_holder(int* fd) {
+    if (-1 != *fd) {
+        close_file(*fd);
+    }
+    delete fd;
+}
+
+} // namespace
+
+http_file_sink::http_file_sink(const std::string& path) :
+m_fd(new int(open_file(path)), close_holder) {
+    if (-1 == *m_fd) {
+        throw httpserver_exception("Cannot open file: [" + path + "], error: [" + ::strerror(errno) + "]");
+    }
+}
+
+void http_file_sink::operator()(const char* data, std::size_t len) {
+    while (len > 0) {
+        auto written = write_file(*m_fd, data, len);
+        if (written < 0) {
+            if (EINTR == errno) continue;
+            throw httpserver_exception(std::string("Error writing to file: [") + ::strerror(errno) + "]");
+        }
+        data += written;
+        len -= static_cast<std::size_t>(written);
+    }
+}
+
+int http_file_sink::get_fd() const {
+    return *m_fd;
+}
+
+void http_file_sink::close() {
+    if (-1 != *m_fd) {
+        close_file(*m_fd);
+        *m_fd = -1;
+    }
+}
+
+} // namespace
+}
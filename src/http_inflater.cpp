@@ -0,0 +1,185 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   http_inflater.cpp
+ * Author: agent
+ *
+ * Created on October 18, 2026, 6:47 PM
+ */
+
+#ifdef STATICLIB_HTTPSERVER_HAVE_ZLIB
+
+#include "staticlib/httpserver/http_inflater.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include "zlib.h"
+
+#include "staticlib/httpserver/algorithm.hpp"
+#include "staticlib/httpserver/httpserver_exception.hpp"
+
+namespace staticlib { 
+namespace httpserver {
+
+const uint32_t http_inflater::DEFAULT_RATIO_MAX = 100;
+
+const std::size_t http_inflater::RATIO_CHECK_THRESHOLD = 1024 * 1024;
+
+namespace { // anonymous
+
+// zlib (RFC 1950) or gzip (RFC 1952) header is detected automatically
+const int WINDOW_BITS_AUTO = 15 + 32;
+// "deflate" coding is sometimes sent as raw deflate stream (RFC 1951)
+const int WINDOW_BITS_RAW = -15;
+
+bool is_gzip(const std::string& content_encoding) {
+    return algorithm::iequals(content_encoding, "gzip") || algorithm::iequals(content_encoding, "x-gzip");
+}
+
+bool is_deflate(const std::string& content_encoding) {
+    return algorithm::iequals(content_encoding, "deflate");
+}
+
+} // namespace
+
+class http_inflater::impl {
+    z_stream m_zs;
+    std::array<char, 16384> m_out;
+    uint64_t m_total_in;
+    uint64_t m_total_out;
+    uint32_t m_ratio_max;
+    int m_window_bits;
+    bool m_started;
+    bool m_finished;
+
+public:
+    impl() :
+    m_total_in(0),
+    m_total_out(0),
+    m_ratio_max(DEFAULT_RATIO_MAX),
+    m_window_bits(WINDOW_BITS_AUTO),
+    m_started(false),
+    m_finished(false) {
+        std::memset(std::addressof(m_zs), '\0', sizeof(m_zs));
+        auto err = inflateInit2(std::addressof(m_zs), WINDOW_BITS_AUTO);
+        if (Z_OK != err) {
+            throw httpserver_exception("Inflater initialization error: [" + std::to_string(err) + "]");
+        }
+    }
+
+    ~impl() {
+        inflateEnd(std::addressof(m_zs));
+    }
+
+    void reset(bool deflate, uint32_t ratio_max) {
+        m_total_in = 0;
+        m_total_out = 0;
+        m_ratio_max = ratio_max;
+        m_window_bits = WINDOW_BITS_AUTO;
+        // zlib/raw choice for "deflate" is made on the first byte
+        m_started = !deflate;
+        m_finished = false;
+        reset_stream();
+    }
+
+    void inflate(const char* data, std::size_t len, const output_handler_type& handler) {
+        if (0 == len || m_finished) return;
+        if (!m_started) {
+            m_started = true;
+            // low nibble of CMF byte is 8 (deflate method) for zlib wrapped stream
+            if (8 != (static_cast<unsigned char>(data[0]) & 0x0f)) {
+                m_window_bits = WINDOW_BITS_RAW;
+                reset_stream();
+            }
+        }
+        m_total_in += len;
+        m_zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+        m_zs.avail_in = static_cast<uInt>(len);
+        do {
+            m_zs.next_out = reinterpret_cast<Bytef*>(m_out.data());
+            m_zs.avail_out = static_cast<uInt>(m_out.size());
+            auto err = ::inflate(std::addressof(m_zs), Z_NO_FLUSH);
+            if (Z_OK != err && Z_STREAM_END != err && Z_BUF_ERROR != err) {
+                throw httpserver_exception("Request body inflate error: [" + std::to_string(err) + "]");
+            }
+            std::size_t produced = m_out.size() - m_zs.avail_out;
+            m_total_out += produced;
+            if (m_total_out > (std::max)(static_cast<uint64_t>(RATIO_CHECK_THRESHOLD), m_total_in * m_ratio_max)) {
+                throw httpserver_exception("Request body decompression ratio limit exceeded," +
+                        std::string(" encoded: [") + std::to_string(m_total_in) + "]," +
+                        " decoded: [" + std::to_string(m_total_out) + "]");
+            }
+            if (produced > 0) {
+                handler(m_out.data(), produced);
+            }
+            if (Z_STREAM_END == err) {
+                // trailing bytes after the end of stream are ignored
+                m_finished = true;
+                break;
+            }
+            if (Z_BUF_ERROR == err) break;
+        } while (m_zs.avail_in > 0 || 0 == m_zs.avail_out);
+    }
+
+    bool is_finished() const {
+        return m_finished;
+    }
+
+private:
+    void reset_stream() {
+        auto err = inflateReset2(std::addressof(m_zs), m_window_bits);
+        if (Z_OK != err) {
+            throw httpserver_exception("Inflater reset error: [" + std::to_string(err) + "]");
+        }
+    }
+};
+
+http_inflater::http_inflater() { }
+
+http_inflater::~http_inflater() { }
+
+bool http_inflater::is_supported(const std::string& content_encoding) {
+    return is_gzip(content_encoding) || is_deflate(content_encoding);
+}
+
+void http_inflater::reset(const std::string& content_encoding, uint32_t ratio_max) {
+    if (!is_supported(content_encoding)) {
+        throw httpserver_exception("Unsupported content encoding: [" + content_encoding + "]");
+    }
+    if (!m_impl) {
+        m_impl.reset(new impl());
+    }
+    m_impl->reset(is_deflate(content_encoding), ratio_max);
+}
+
+void http_inflater::inflate(const char* data, std::size_t len, const output_handler_type& handler) {
+    if (!m_impl) {
+        throw httpserver_exception("Inflater is not initialized");
+    }
+    m_impl->inflate(data, len, handler);
+}
+
+bool http_inflater::is_finished() const {
+    return m_impl && m_impl->is_finished();
+}
+
+} // namespace
+}
+
+#endif // STATICLIB_HTTPSERVER_HAVE_ZLIB
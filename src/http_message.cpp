@@ -27,7 +27,6 @@
 
 #include <iostream>
 #include <algorithm>
-#include <mutex>
 #include <cassert>
 #include <cstdlib>
 #include <cstdio>
@@ -36,6 +35,7 @@
 #include "asio.hpp"
 
 #include "staticlib/httpserver/tribool.hpp"
+#include "staticlib/httpserver/http_common_headers.hpp"
 #include "staticlib/httpserver/http_request.hpp"
 #include "staticlib/httpserver/http_parser.hpp"
 #include "staticlib/httpserver/tcp_connection.hpp"
@@ -118,8 +118,11 @@ const std::string http_message::RESPONSE_MESSAGE_NOT_FOUND("Not Found");
 const std::string http_message::RESPONSE_MESSAGE_METHOD_NOT_ALLOWED("Method Not Allowed");
 const std::string http_message::RESPONSE_MESSAGE_NOT_MODIFIED("Not Modified");
 const std::string http_message::RESPONSE_MESSAGE_BAD_REQUEST("Bad Request");
+const std::string http_message::RESPONSE_MESSAGE_TOO_MANY_REQUESTS("Too Many Requests");
 const std::string http_message::RESPONSE_MESSAGE_SERVER_ERROR("Server Error");
 const std::string http_message::RESPONSE_MESSAGE_NOT_IMPLEMENTED("Not Implemented");
+const std::string http_message::RESPONSE_MESSAGE_SERVICE_UNAVAILABLE("Service Unavailable");
+const std::string http_message::RESPONSE_MESSAGE_GATEWAY_TIMEOUT("Gateway Timeout");
 const std::string http_message::RESPONSE_MESSAGE_CONTINUE("Continue");
 
 // common HTTP response codes
@@ -134,8 +137,11 @@ const unsigned int http_message::RESPONSE_CODE_NOT_FOUND = 404;
 const unsigned int http_message::RESPONSE_CODE_METHOD_NOT_ALLOWED = 405;
 const unsigned int http_message::RESPONSE_CODE_NOT_MODIFIED = 304;
 const unsigned int http_message::RESPONSE_CODE_BAD_REQUEST = 400;
+const unsigned int http_message::RESPONSE_CODE_TOO_MANY_REQUESTS = 429;
 const unsigned int http_message::RESPONSE_CODE_SERVER_ERROR = 500;
 const unsigned int http_message::RESPONSE_CODE_NOT_IMPLEMENTED = 501;
+const unsigned int http_message::RESPONSE_CODE_SERVICE_UNAVAILABLE = 503;
+const unsigned int http_message::RESPONSE_CODE_GATEWAY_TIMEOUT = 504;
 const unsigned int http_message::RESPONSE_CODE_CONTINUE = 100;
 
 // response to "Expect: 100-Continue" header
@@ -429,18 +435,9 @@ bool http_message::check_keep_alive() const {
 }
 
 std::string http_message::get_date_string(const time_t t) {
-    // use mutex since time functions are normally not thread-safe
-    static std::mutex time_mutex;
-    static const char *TIME_FORMAT = "%a, %d %b %Y %H:%M:%S GMT";
-    static const unsigned int TIME_BUF_SIZE = 100;
-    char time_buf[TIME_BUF_SIZE + 1];
-
-    std::unique_lock<std::mutex> time_lock(time_mutex);
-    if (strftime(time_buf, TIME_BUF_SIZE, TIME_FORMAT, gmtime(&t)) == 0)
-        time_buf[0] = '\0'; // failed; resulting buffer is indeterminate
-    time_lock.unlock();
-
-    return std::string(time_buf);
+    std::string res;
+    algorithm::append_http_date(res, t);
+    return res;
 }
 
 std::string http_message::make_query_string(const std::unordered_multimap<std::string, std::string,
@@ -491,6 +488,31 @@ void http_message::prepare_buffers_for_send(write_buffers_type& write_buffers, c
 }
 
 
+void http_message::serialize_headers(std::string& buf, const bool keep_alive, const bool using_chunks,
+        const http_common_headers* common_headers) {
+    // update message headers
+    prepare_headers_for_send(keep_alive, using_chunks);
+    append_cookie_headers();
+    // compute the length to allocate (at most) once, first line is short
+    std::size_t len = 64 + STRING_CRLF.length();
+    for (auto& en : m_headers) {
+        len += en.first.length() + HEADER_NAME_VALUE_DELIMITER.length() + en.second.length() + STRING_CRLF.length();
+    }
+    buf.reserve(buf.length() + len);
+    append_first_line(buf);
+    for (auto& en : m_headers) {
+        buf.append(en.first);
+        buf.append(HEADER_NAME_VALUE_DELIMITER);
+        buf.append(en.second);
+        buf.append(STRING_CRLF);
+    }
+    if (nullptr != common_headers) {
+        common_headers->append_to(buf);
+    }
+    // add an extra CRLF to end HTTP headers
+    buf.append(STRING_CRLF);
+}
+
 // message member functions
 
 std::size_t http_message::send(tcp_connection& tcp_conn,
@@ -759,7 +781,9 @@ void http_message::prepare_headers_for_send(const bool keep_alive, const bool us
             change_header(HEADER_TRANSFER_ENCODING, "chunked");
         }
     } else if (!m_do_not_send_content_length) {
-        change_header(HEADER_CONTENT_LENGTH, algorithm::to_string(get_content_length()));
+        std::string len;
+        algorithm::append_decimal(len, get_content_length());
+        change_header(HEADER_CONTENT_LENGTH, len);
     }
 }
 
@@ -778,6 +802,11 @@ void http_message::append_headers(write_buffers_type& write_buffers) {
 
 void http_message::append_cookie_headers() { }
 
+void http_message::append_first_line(std::string& buf) const {
+    buf.append(get_first_line());
+    buf.append(STRING_CRLF);
+}
+
 void http_message::clear_first_line() const {
     if (!m_first_line.empty()) {
         m_first_line.clear();
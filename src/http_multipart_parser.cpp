@@ -0,0 +1,318 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   http_multipart_parser.cpp
+ * Author: agent
+ *
+ * Created on October 18, 2026, 6:41 PM
+ */
+
+#include "staticlib/httpserver/http_multipart_parser.hpp"
+
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <cstring>
+
+#include "staticlib/httpserver/httpserver_exception.hpp"
+
+namespace staticlib {
+namespace httpserver {
+
+const std::size_t http_multipart_parser::HEADERS_MAX = 16384;
+
+namespace { // anonymous
+
+const std::string CRLF = "\r\n";
+const std::string HEADERS_END = "\r\n\r\n";
+
+std::string trim(const std::string& str) {
+    auto begin = str.find_first_not_of(" \t");
+    if (std::string::npos == begin) return std::string();
+    auto end = str.find_last_not_of(" \t");
+    return str.substr(begin, end - begin + 1);
+}
+
+std::string unquote(const std::string& str) {
+    if (str.size() >= 2 && '"' == str.front() && '"' == str.back()) {
+        return str.substr(1, str.size() - 2);
+    }
+    return str;
+}
+
+// returns the value of the parameter from the header value like
+// 'type; name1=value1; name2="value2"', empty string if not found
+std::string find_param(const std::string& value, const std::string& param) {
+    // split by semicolons outside of quotes
+    std::vector<std::string> tokens;
+    std::string token;
+    bool quoted = false;
+    for (char ch : value) {
+        if ('"' == ch) {
+            quoted = !quoted;
+        } else if (';' == ch && !quoted) {
+            tokens.emplace_back(std::move(token));
+            token.clear();
+            continue;
+        }
+        token.push_back(ch);
+    }
+    tokens.emplace_back(std::move(token));
+    // first token is a media or disposition type
+    for (std::size_t i = 1; i < tokens.size(); i++) {
+        auto eq = tokens[i].find('=');
+        if (std::string::npos != eq && algorithm::iequals(trim(tokens[i].substr(0, eq)), param)) {
+            return unquote(trim(tokens[i].substr(eq + 1)));
+        }
+    }
+    return std::string();
+}
+
+std::string extract_boundary(const std::string& content_type) {
+    auto res = find_param(content_type, "boundary");
+    if (res.empty()) {
+        throw httpserver_exception("Boundary not found in content type: [" + content_type + "]");
+    }
+    return res;
+}
+
+} // namespace
+
+class http_multipart_parser::state {
+    enum parse_state_type {
+        PARSE_PREAMBLE,
+        PARSE_HEADERS,
+        PARSE_DATA,
+        PARSE_AFTER_BOUNDARY,
+        PARSE_AFTER_BOUNDARY_DASH,
+        PARSE_AFTER_BOUNDARY_CR,
+        PARSE_EPILOGUE
+    };
+
+    part_begin_handler_type m_part_begin;
+    part_data_handler_type m_part_data;
+    part_end_handler_type m_part_end;
+    // "\r\n--boundary"
+    std::string m_delimiter;
+    std::array<std::size_t, 256> m_skip;
+    // bytes that may be a beginning of the delimiter
+    std::string m_tail;
+    std::string m_headers_buf;
+    parse_state_type m_parse_state;
+
+public:
+    state(const std::string& boundary, part_begin_handler_type part_begin, part_data_handler_type part_data,
+            part_end_handler_type part_end) :
+    m_part_begin(std::move(part_begin)),
+    m_part_data(std::move(part_data)),
+    m_part_end(std::move(part_end)),
+    m_delimiter(CRLF + "--" + boundary),
+    // first boundary may be placed at the start of content without preceding CRLF
+    m_tail(CRLF),
+    m_parse_state(PARSE_PREAMBLE) {
+        std::size_t len = m_delimiter.size();
+        m_skip.fill(len);
+        for (std::size_t i = 0; i < len - 1; i++) {
+            m_skip[static_cast<unsigned char>(m_delimiter[i])] = len - 1 - i;
+        }
+    }
+
+    void parse(const char* ptr, const char* end) {
+        while (ptr < end) {
+            switch (m_parse_state) {
+            case PARSE_PREAMBLE:
+            case PARSE_DATA:
+                ptr = parse_data(ptr, end);
+                break;
+            case PARSE_HEADERS:
+                ptr = parse_headers(ptr, end);
+                break;
+            case PARSE_AFTER_BOUNDARY:
+                switch (*ptr) {
+                case '-': m_parse_state = PARSE_AFTER_BOUNDARY_DASH; break;
+                case '\r': m_parse_state = PARSE_AFTER_BOUNDARY_CR; break;
+                case '\n': start_headers(); break;
+                case ' ': case '\t': break; // transport padding
+                default: throw httpserver_exception("Invalid multipart content after boundary");
+                }
+                ++ptr;
+                break;
+            case PARSE_AFTER_BOUNDARY_DASH:
+                if ('-' != *ptr) throw httpserver_exception("Invalid multipart close boundary");
+                m_parse_state = PARSE_EPILOGUE;
+                ++ptr;
+                break;
+            case PARSE_AFTER_BOUNDARY_CR:
+                if ('\n' != *ptr) throw httpserver_exception("Invalid multipart content after boundary");
+                start_headers();
+                ++ptr;
+                break;
+            case PARSE_EPILOGUE:
+                // ignored
+                ptr = end;
+                break;
+            }
+        }
+    }
+
+    bool is_finished() const {
+        return PARSE_EPILOGUE == m_parse_state;
+    }
+
+private:
+    void start_headers() {
+        // preceding CRLF allows to detect empty headers block
+        m_headers_buf.assign(CRLF);
+        m_parse_state = PARSE_HEADERS;
+    }
+
+    const char* parse_headers(const char* ptr, const char* end) {
+        std::size_t prev_size = m_headers_buf.size();
+        std::size_t len = (std::min)(static_cast<std::size_t>(end - ptr), HEADERS_MAX + HEADERS_END.size() - prev_size);
+        m_headers_buf.append(ptr, len);
+        auto pos = m_headers_buf.find(HEADERS_END, prev_size < 3 ? 0 : prev_size - 3);
+        if (std::string::npos == pos) {
+            if (m_headers_buf.size() >= HEADERS_MAX + HEADERS_END.size()) {
+                throw httpserver_exception("Multipart headers max length exceeded: [" + std::to_string(HEADERS_MAX) + "]");
+            }
+            return ptr + len;
+        }
+        headers_type headers;
+        std::string last_name;
+        std::size_t line_start = CRLF.size();
+        while (line_start < pos) {
+            std::size_t line_end = m_headers_buf.find(CRLF, line_start);
+            std::string line = m_headers_buf.substr(line_start, line_end - line_start);
+            line_start = line_end + CRLF.size();
+            if (line.empty()) continue;
+            if ((' ' == line[0] || '\t' == line[0]) && !last_name.empty()) {
+                // folded header value
+                auto it = headers.find(last_name);
+                if (headers.end() != it) it->second += " " + trim(line);
+                continue;
+            }
+            auto colon = line.find(':');
+            if (std::string::npos == colon) {
+                throw httpserver_exception("Invalid multipart header: [" + line + "]");
+            }
+            last_name = trim(line.substr(0, colon));
+            headers.insert(std::make_pair(last_name, trim(line.substr(colon + 1))));
+        }
+        m_headers_buf.clear();
+        m_parse_state = PARSE_DATA;
+        if (m_part_begin) m_part_begin(headers);
+        return ptr + (pos + HEADERS_END.size() - prev_size);
+    }
+
+    const char* parse_data(const char* ptr, const char* end) {
+        // resolve bytes carried from the previous call first
+        while (!m_tail.empty()) {
+            std::size_t need = m_delimiter.size() - m_tail.size();
+            std::size_t avail = static_cast<std::size_t>(end - ptr);
+            std::size_t cmp = (std::min)(need, avail);
+            if (0 == std::memcmp(m_delimiter.data() + m_tail.size(), ptr, cmp)) {
+                if (cmp == need) {
+                    m_tail.clear();
+                    return delimiter_found(ptr + need);
+                }
+                m_tail.append(ptr, avail);
+                return end;
+            }
+            // tail is not a delimiter, but its suffix still may be
+            emit(m_tail.data(), 1);
+            std::size_t keep = partial_delimiter_length(m_tail.data() + 1, m_tail.data() + m_tail.size());
+            emit(m_tail.data() + 1, m_tail.size() - 1 - keep);
+            m_tail.erase(0, m_tail.size() - keep);
+        }
+        const char* found = find_delimiter(ptr, end);
+        if (end != found) {
+            emit(ptr, static_cast<std::size_t>(found - ptr));
+            return delimiter_found(found + m_delimiter.size());
+        }
+        // keep possible beginning of the delimiter until the next call
+        std::size_t keep = partial_delimiter_length(ptr, end);
+        emit(ptr, static_cast<std::size_t>(end - ptr) - keep);
+        m_tail.assign(end - keep, keep);
+        return end;
+    }
+
+    const char* delimiter_found(const char* next) {
+        if (PARSE_DATA == m_parse_state && m_part_end) {
+            m_part_end();
+        }
+        m_parse_state = PARSE_AFTER_BOUNDARY;
+        return next;
+    }
+
+    void emit(const char* ptr, std::size_t len) {
+        if (PARSE_DATA == m_parse_state && len > 0 && m_part_data) {
+            m_part_data(ptr, len);
+        }
+    }
+
+    // Boyer-Moore-Horspool
+    const char* find_delimiter(const char* ptr, const char* end) const {
+        std::size_t len = m_delimiter.size();
+        if (static_cast<std::size_t>(end - ptr) < len) return end;
+        const char* last = end - len;
+        const char last_char = m_delimiter[len - 1];
+        while (ptr <= last) {
+            char ch = ptr[len - 1];
+            if (last_char == ch && 0 == std::memcmp(ptr, m_delimiter.data(), len - 1)) {
+                return ptr;
+            }
+            ptr += m_skip[static_cast<unsigned char>(ch)];
+        }
+        return end;
+    }
+
+    // length of the longest suffix that is a beginning of the delimiter
+    std::size_t partial_delimiter_length(const char* ptr, const char* end) const {
+        std::size_t max = (std::min)(static_cast<std::size_t>(end - ptr), m_delimiter.size() - 1);
+        for (const char* start = end - max; start < end; ++start) {
+            start = static_cast<const char*>(std::memchr(start, m_delimiter[0], static_cast<std::size_t>(end - start)));
+            if (nullptr == start) break;
+            std::size_t len = static_cast<std::size_t>(end - start);
+            if (0 == std::memcmp(start, m_delimiter.data(), len)) {
+                return len;
+            }
+        }
+        return 0;
+    }
+};
+
+http_multipart_parser::http_multipart_parser(const std::string& content_type, part_begin_handler_type part_begin,
+        part_data_handler_type part_data, part_end_handler_type part_end) :
+m_state(std::make_shared<state>(extract_boundary(content_type), std::move(part_begin),
+        std::move(part_data), std::move(part_end))) { }
+
+void http_multipart_parser::operator()(const char* data, std::size_t len) {
+    m_state->parse(data, data + len);
+}
+
+bool http_multipart_parser::is_finished() const {
+    return m_state->is_finished();
+}
+
+std::string http_multipart_parser::get_disposition_param(const headers_type& headers, const std::string& param) {
+    auto it = headers.find("Content-Disposition");
+    if (headers.end() == it) return std::string();
+    return find_param(it->second, param);
+}
+
+} // namespace
+}
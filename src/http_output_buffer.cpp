@@ -0,0 +1,165 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   http_output_buffer.cpp
+ * Author: agent
+ *
+ * Created on October 18, 2026, 7:37 PM
+ */
+
+#include "staticlib/httpserver/http_output_buffer.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+#include "asio.hpp"
+
+#include "staticlib/httpserver/buffer_pool.hpp"
+
+namespace staticlib { 
+namespace httpserver {
+
+const std::size_t http_output_buffer::SLAB_SIZE = 4096;
+
+// well above the small string optimization size, so
+// moving referenced strings does not move their data
+const std::size_t http_output_buffer::INLINE_MAX = 512;
+
+http_output_buffer::http_output_buffer() :
+m_length(0),
+m_extend_allowed(false) { }
+
+http_output_buffer::~http_output_buffer() {
+    for (auto& slab : m_slabs) {
+        buffer_pool::release(std::move(slab));
+    }
+}
+
+void http_output_buffer::append(const char* data, std::size_t len) {
+    if (0 == len) return;
+    std::string& slab = slab_for(len);
+    const char* dest = slab.data() + slab.length();
+    // within capacity, does not reallocate
+    slab.append(data, len);
+    if (m_extend_allowed && !m_buffers.empty()) {
+        asio::const_buffer& last = m_buffers.back();
+        const char* last_ptr = asio::buffer_cast<const char*>(last);
+        std::size_t last_len = asio::buffer_size(last);
+        if (last_ptr + last_len == dest) {
+            last = asio::const_buffer(last_ptr, last_len + len);
+            m_length += len;
+            return;
+        }
+    }
+    m_buffers.emplace_back(dest, len);
+    m_length += len;
+    m_extend_allowed = true;
+}
+
+void http_output_buffer::append_no_copy(const char* data, std::size_t len) {
+    if (0 == len) return;
+    m_buffers.emplace_back(data, len);
+    m_length += len;
+    m_extend_allowed = false;
+}
+
+void http_output_buffer::append_move(std::string&& data) {
+    if (data.length() < INLINE_MAX) {
+        append(data.data(), data.length());
+    } else {
+        m_moved.emplace_back(std::move(data));
+        append_no_copy(m_moved.back().data(), m_moved.back().length());
+    }
+}
+
+void http_output_buffer::append_shared(std::shared_ptr<const std::string> data) {
+    if (!data || data->empty()) return;
+    const char* ptr = data->data();
+    std::size_t len = data->length();
+    m_shared.emplace_back(std::move(data));
+    append_no_copy(ptr, len);
+}
+
+void http_output_buffer::split() {
+    m_extend_allowed = false;
+}
+
+http_message::write_buffers_type& http_output_buffer::get_buffers() {
+    return m_buffers;
+}
+
+std::size_t http_output_buffer::get_length() const {
+    return m_length;
+}
+
+void http_output_buffer::clear() {
+    for (std::size_t i = 1; i < m_slabs.size(); i++) {
+        buffer_pool::release(std::move(m_slabs[i]));
+    }
+    if (m_slabs.size() > 1) {
+        m_slabs.resize(1);
+    }
+    if (!m_slabs.empty()) {
+        m_slabs.front().clear();
+    }
+    m_moved.clear();
+    m_shared.clear();
+    m_buffers.clear();
+    m_length = 0;
+    m_extend_allowed = false;
+}
+
+void http_output_buffer::swap(http_output_buffer& other) {
+    // vectors are swapped without moving the elements, moved strings
+    // are never short enough to keep their data inline
+    m_slabs.swap(other.m_slabs);
+    m_moved.swap(other.m_moved);
+    m_shared.swap(other.m_shared);
+    m_buffers.swap(other.m_buffers);
+    std::swap(m_length, other.m_length);
+    std::swap(m_extend_allowed, other.m_extend_allowed);
+}
+
+void http_output_buffer::splice(http_output_buffer& other) {
+    // strings are moved without moving their data, see swap()
+    m_slabs.insert(m_slabs.end(), std::make_move_iterator(other.m_slabs.begin()),
+            std::make_move_iterator(other.m_slabs.end()));
+    m_moved.insert(m_moved.end(), std::make_move_iterator(other.m_moved.begin()),
+            std::make_move_iterator(other.m_moved.end()));
+    m_shared.insert(m_shared.end(), std::make_move_iterator(other.m_shared.begin()),
+            std::make_move_iterator(other.m_shared.end()));
+    m_buffers.insert(m_buffers.end(), other.m_buffers.begin(), other.m_buffers.end());
+    m_length += other.m_length;
+    m_extend_allowed = false;
+    other.m_slabs.clear();
+    other.m_moved.clear();
+    other.m_shared.clear();
+    other.m_buffers.clear();
+    other.m_length = 0;
+    other.m_extend_allowed = false;
+}
+
+std::string& http_output_buffer::slab_for(std::size_t len) {
+    if (m_slabs.empty() || m_slabs.back().capacity() - m_slabs.back().length() < len) {
+        m_slabs.emplace_back(buffer_pool::acquire((std::max)(SLAB_SIZE, len)));
+    }
+    return m_slabs.back();
+}
+
+} // namespace
+}
@@ -165,6 +165,50 @@ void http_parser::set_payload_handler(payload_handler_type& h) {
     m_payload_handler = &h;
 }
 
+std::size_t http_parser::get_content_bytes_remaining() const {
+    return PARSE_CONTENT == m_message_parse_state ? m_bytes_content_remaining : 0;
+}
+
+tribool http_parser::skip_content(http_message& http_msg, std::size_t len) {
+    assert(PARSE_CONTENT == m_message_parse_state && len <= m_bytes_content_remaining);
+    m_bytes_content_remaining -= len;
+    m_bytes_content_read += len;
+    m_bytes_total_read += len;
+    m_bytes_last_read = len;
+    if (0 == m_bytes_content_remaining) {
+        m_message_parse_state = PARSE_END;
+        finish(http_msg);
+        return true;
+    }
+    return indeterminate;
+}
+
+void http_parser::set_payload_buffers_provider(payload_buffers_provider_type& bp) {
+    m_payload_buffers_provider = &bp;
+}
+
+std::size_t http_parser::fill_payload_buffers(std::vector<asio::mutable_buffer>& buffers) {
+    buffers.clear();
+    if (nullptr == m_payload_handler || nullptr == m_payload_buffers_provider || !*m_payload_buffers_provider ||
+            PARSE_CONTENT != m_message_parse_state || 0 == m_bytes_content_remaining) {
+        return 0;
+    }
+    (*m_payload_buffers_provider)(m_bytes_content_remaining, buffers);
+    // trim buffers to the remaining content
+    std::size_t total = 0;
+    std::size_t count = 0;
+    for (; count < buffers.size() && total < m_bytes_content_remaining; ++count) {
+        std::size_t len = asio::buffer_size(buffers[count]);
+        if (total + len > m_bytes_content_remaining) {
+            len = m_bytes_content_remaining - total;
+            buffers[count] = asio::buffer(buffers[count], len);
+        }
+        total += len;
+    }
+    buffers.resize(count);
+    return total;
+}
+
 void http_parser::set_max_content_length(std::size_t n) {
     m_max_content_length = n;
 }
@@ -1722,6 +1766,8 @@ std::string http_parser::error_category_t::message(int ev) const {
         return "missing chunk data";
     case ERROR_MISSING_TOO_MUCH_CONTENT:
         return "missing too much content";
+    case ERROR_CONTENT_ENCODING:
+        return "truncated encoded content";
     }
     return "parser error";
 }
@@ -16,15 +16,27 @@
 
 #include "staticlib/httpserver/http_request.hpp"
 
+#include <limits>
+
+#include "staticlib/httpserver/handler_deadline.hpp"
+#include "staticlib/httpserver/overload_controller.hpp"
+#include "staticlib/httpserver/response_pipeline.hpp"
+
 namespace staticlib { 
 namespace httpserver {
 
+const uint32_t http_request::PRIORITY_LANE_UNSET = std::numeric_limits<uint32_t>::max();
+
 http_request::http_request(const std::string& resource) : 
 m_method(REQUEST_METHOD_GET), 
-m_resource(resource) { }
+m_resource(resource),
+m_priority_lane(PRIORITY_LANE_UNSET),
+m_pipeline_index(0) { }
 
 http_request::http_request() : 
-m_method(REQUEST_METHOD_GET) { }
+m_method(REQUEST_METHOD_GET),
+m_priority_lane(PRIORITY_LANE_UNSET),
+m_pipeline_index(0) { }
 
 http_request::~http_request() { }
 
@@ -35,6 +47,11 @@ void http_request::clear() {
     m_original_resource.erase();
     m_query_string.erase();
     m_query_params.clear();
+    m_priority_lane = PRIORITY_LANE_UNSET;
+    m_admission.reset();
+    m_deadline.reset();
+    m_pipeline.reset();
+    m_pipeline_index = 0;
 }
 
 bool http_request::is_content_length_implied() const {
@@ -138,10 +155,20 @@ void http_request::set_payload_handler(http_parser::payload_handler_type ph) {
     if (m_request_reader) {
         // request will always outlive reader
         m_request_reader->set_payload_handler(m_payload_handler);
+        if (m_payload_buffers_provider) {
+            m_request_reader->set_payload_buffers_provider(m_payload_buffers_provider);
+        }
         m_request_reader = NULL;
     }
 }
 
+void http_request::set_payload_buffers_provider(http_parser::payload_buffers_provider_type bp) {
+    m_payload_buffers_provider = std::move(bp);
+    if (m_request_reader) {
+        m_request_reader->set_payload_buffers_provider(m_payload_buffers_provider);
+    }
+}
+
 http_parser::payload_handler_type& http_request::get_payload_handler_wrapper() {
     return m_payload_handler;
 }
@@ -150,6 +177,51 @@ void http_request::set_request_reader(http_parser* rr) {
     m_request_reader = rr;
 }
 
+void http_request::set_priority_lane(uint32_t lane_idx) {
+    m_priority_lane = lane_idx;
+}
+
+uint32_t http_request::get_priority_lane() const {
+    return m_priority_lane;
+}
+
+void http_request::set_admission(std::shared_ptr<overload_admission> admission) {
+    m_admission = std::move(admission);
+}
+
+overload_admission* http_request::get_admission() const {
+    return m_admission.get();
+}
+
+void http_request::set_deadline(std::shared_ptr<handler_deadline> deadline) {
+    m_deadline = std::move(deadline);
+}
+
+const std::shared_ptr<handler_deadline>& http_request::get_deadline() const {
+    return m_deadline;
+}
+
+std::shared_ptr<cancellation_token> http_request::get_cancellation_token() const {
+    return m_deadline ? m_deadline->get_token() : std::shared_ptr<cancellation_token>();
+}
+
+bool http_request::is_cancelled() const {
+    return m_deadline && m_deadline->get_token()->is_cancelled();
+}
+
+void http_request::set_pipeline(std::shared_ptr<response_pipeline> pipeline, std::size_t index) {
+    m_pipeline = std::move(pipeline);
+    m_pipeline_index = index;
+}
+
+const std::shared_ptr<response_pipeline>& http_request::get_pipeline() const {
+    return m_pipeline;
+}
+
+std::size_t http_request::get_pipeline_index() const {
+    return m_pipeline_index;
+}
+
 void http_request::update_first_line() const {
     // start out with the request method
     m_first_line = m_method;
@@ -16,8 +16,12 @@
 
 #include "staticlib/httpserver/http_request_reader.hpp"
 
+#include <algorithm>
+
 #include "asio.hpp"
 
+#include "staticlib/httpserver/http_file_sink.hpp"
+
 namespace staticlib { 
 namespace httpserver {
 
@@ -40,6 +44,7 @@ void http_request_reader::receive() {
         // there are pipelined messages available in the connection's read buffer
         m_tcp_conn->set_lifecycle(tcp_connection::LIFECYCLE_CLOSE); // default to close the connection
         m_tcp_conn->load_read_pos(m_read_ptr, m_read_end_ptr);
+        m_tcp_conn->start_header_deadline();
         consume_bytes();
     } else {
         // no pipelined messages available in the read buffer -> read bytes from the socket
@@ -64,6 +69,12 @@ void http_request_reader::consume_bytes(const asio::error_code& read_error, std:
     STATICLIB_HTTPSERVER_LOG_DEBUG(m_logger, "Read " << bytes_read << " bytes from HTTP "
             << (is_parsing_request() ? "request" : "response"));
 
+    // headers time limit of keep-alive requests is counted from the first byte, idle
+    // keep-alive connections are covered by the read timeout
+    if (0 == get_total_bytes_read()) {
+        m_tcp_conn->start_header_deadline();
+    }
+
     // set pointers for new HTTP header data to be consumed
     set_read_buffer(m_tcp_conn->get_read_buffer().data(), bytes_read);
 
@@ -87,6 +98,78 @@ void http_request_reader::consume_bytes() {
         STATICLIB_HTTPSERVER_LOG_DEBUG(m_logger, "Parsed " << gcount() << " HTTP bytes");
     }
 
+    handle_parse_result(result, ec);
+}
+
+void http_request_reader::consume_payload_buffers(const asio::error_code& read_error, std::size_t bytes_read) {
+    // cancel read timer if operation didn't time-out
+    if (m_timer_ptr) {
+        m_timer_ptr->cancel();
+        m_timer_ptr.reset();
+    }
+
+    if (read_error) {
+        // a read error occured
+        handle_read_error(read_error);
+        return;
+    }
+
+    STATICLIB_HTTPSERVER_LOG_DEBUG(m_logger, "Read " << bytes_read << " payload bytes directly into "
+            << m_payload_buffers.size() << " buffers");
+
+    // pass filled buffers to parser one by one, buffers were trimmed to
+    // the remaining content, so only the last one can finish the message
+    asio::error_code ec;
+    tribool result = indeterminate;
+    std::size_t bytes_left = bytes_read;
+    for (auto& buf : m_payload_buffers) {
+        if (0 == bytes_left) break;
+        std::size_t len = (std::min)(asio::buffer_size(buf), bytes_left);
+        if (0 == len) continue;
+        bytes_left -= len;
+        set_read_buffer(asio::buffer_cast<const char*>(buf), len);
+        result = parse(get_message(), ec);
+        if (!indeterminate(result)) break;
+    }
+    handle_parse_result(result, ec);
+}
+
+void http_request_reader::consume_spliced_bytes(const asio::error_code& read_error, std::size_t bytes_read) {
+    // cancel read timer if operation didn't time-out
+    if (m_timer_ptr) {
+        m_timer_ptr->cancel();
+        m_timer_ptr.reset();
+    }
+
+    if (read_error) {
+        // a read error occured
+        handle_read_error(read_error);
+        return;
+    }
+
+    STATICLIB_HTTPSERVER_LOG_DEBUG(m_logger, "Spliced " << bytes_read << " payload bytes into file");
+
+    asio::error_code ec;
+    tribool result = skip_content(get_message(), bytes_read);
+    handle_parse_result(result, ec);
+}
+
+void http_request_reader::handle_parse_result(tribool result, const asio::error_code& parse_ec) {
+    if (m_buffered_stop) {
+        finished_reading(asio::error::would_block);
+        return;
+    }
+    asio::error_code ec = parse_ec;
+#ifdef STATICLIB_HTTPSERVER_HAVE_ZLIB
+    // body ended before the end of the compressed stream
+    if (is_decoding() && get_content_bytes_read() > 0 && !m_inflater->is_finished()) {
+        // tribool operators do not short-circuit
+        if (result == true) {
+            set_error(ec, ERROR_CONTENT_ENCODING);
+            result = false;
+        }
+    }
+#endif // STATICLIB_HTTPSERVER_HAVE_ZLIB
     if (result == true) {
         // finished reading HTTP message and it is valid
 
@@ -122,11 +205,25 @@ void http_request_reader::consume_bytes() {
         finished_reading(ec);
     } else {
         // not yet finished parsing the message -> read more data
-        read_bytes_with_timeout();
+        if (m_buffered_only) {
+            finished_reading(asio::error::would_block);
+        } else {
+            read_bytes_with_timeout();
+        }
     }
 }
 
 void http_request_reader::read_bytes_with_timeout() {
+    // next request on a keep-alive connection is often received already,
+    // it is read without waiting for the reactor
+    if (0 == get_total_bytes_read()) {
+        asio::error_code ec;
+        std::size_t bytes_read = m_tcp_conn->try_read_some(ec);
+        if (asio::error::would_block != ec) {
+            consume_bytes(ec, bytes_read);
+            return;
+        }
+    }
     if (m_read_timeout > 0) {
         m_timer_ptr.reset(new tcp_timer(m_tcp_conn));
         m_timer_ptr->start(m_read_timeout);
@@ -172,12 +269,32 @@ void http_request_reader::set_headers_parsed_callback(headers_parsing_finished_h
     m_parsed_headers = h;
 }
 
+void http_request_reader::set_buffered_only(bool buffered_only) {
+    m_buffered_only = buffered_only;
+}
+
+void http_request_reader::set_inflate_ratio_max(uint32_t ratio_max) {
+#ifdef STATICLIB_HTTPSERVER_HAVE_ZLIB
+    m_inflate_ratio_max = ratio_max;
+#else
+    (void) ratio_max;
+#endif // STATICLIB_HTTPSERVER_HAVE_ZLIB
+}
+
 http_request_reader::http_request_reader(tcp_connection_ptr& tcp_conn, finished_handler_type handler) :
 http_parser(true),
 m_tcp_conn(tcp_conn),
 m_read_timeout(DEFAULT_READ_TIMEOUT),
 m_http_msg(new http_request),
-m_finished(handler) {
+m_finished(handler),
+m_buffered_only(false),
+#ifdef STATICLIB_HTTPSERVER_HAVE_ZLIB
+m_buffered_stop(false),
+m_inflater(nullptr),
+m_inflate_ratio_max(http_inflater::DEFAULT_RATIO_MAX) {
+#else
+m_buffered_stop(false) {
+#endif // STATICLIB_HTTPSERVER_HAVE_ZLIB
     m_http_msg->set_remote_ip(tcp_conn->get_remote_ip());
     m_http_msg->set_request_reader(this);
     set_logger(STATICLIB_HTTPSERVER_GET_LOGGER("staticlib.httpserver.http_request_reader"));
@@ -185,6 +302,26 @@ m_finished(handler) {
 
 void http_request_reader::read_bytes(void) {
     auto reader = shared_from_this();
+    std::size_t content_remaining = eof() ? get_content_bytes_remaining() : 0;
+    if (content_remaining > 0 && !is_decoding()) {
+        // read buffer is drained and content length is known,
+        // move the rest of the payload directly to its destination
+        http_file_sink* sink = m_http_msg->get_payload_handler<http_file_sink>();
+        if (nullptr != sink && -1 != sink->get_fd() && m_tcp_conn->is_splice_supported()) {
+            m_tcp_conn->async_splice_some(sink->get_fd(), content_remaining, [reader](
+                    const asio::error_code& read_error, std::size_t bytes_read) {
+                reader->consume_spliced_bytes(read_error, bytes_read);
+            });
+            return;
+        }
+        if (fill_payload_buffers(m_payload_buffers) > 0) {
+            get_connection()->async_read_some(m_payload_buffers, [reader](const asio::error_code& read_error,
+                    std::size_t bytes_read) {
+                reader->consume_payload_buffers(read_error, bytes_read);
+            });
+            return;
+        }
+    }
     get_connection()->async_read_some([reader](const asio::error_code& read_error, 
             std::size_t bytes_read) {
         reader->consume_bytes(read_error, bytes_read);
@@ -192,11 +329,44 @@ void http_request_reader::read_bytes(void) {
 }
 
 void http_request_reader::finished_parsing_headers(const asio::error_code& ec, tribool& rc) {
+    m_tcp_conn->stop_header_deadline();
+    // request body may not be buffered completely, such requests are read separately
+    if (m_buffered_only && (m_http_msg->is_chunked() || m_http_msg->get_content_length() > 0)) {
+        m_buffered_stop = true;
+        rc = false;
+        return;
+    }
     // call the finished headers handler with the HTTP message
     if (m_parsed_headers) m_parsed_headers(m_http_msg, get_connection(), ec, rc);
+    start_decoding();
+}
+
+void http_request_reader::start_decoding() {
+#ifdef STATICLIB_HTTPSERVER_HAVE_ZLIB
+    if (!m_http_msg->get_payload_handler_wrapper()) return;
+    const std::string& encoding = m_http_msg->get_header(http_message::HEADER_CONTENT_ENCODING);
+    if (!http_inflater::is_supported(encoding)) return;
+    m_inflater = std::addressof(m_tcp_conn->get_inflater());
+    m_inflater->reset(encoding, m_inflate_ratio_max);
+    // request keeps the handler created for the route,
+    // parser passes the body to it through the inflater
+    m_decoding_handler = [this](const char* data, std::size_t len) {
+        m_inflater->inflate(data, len, m_http_msg->get_payload_handler_wrapper());
+    };
+    set_payload_handler(m_decoding_handler);
+#endif // STATICLIB_HTTPSERVER_HAVE_ZLIB
+}
+
+bool http_request_reader::is_decoding() const {
+#ifdef STATICLIB_HTTPSERVER_HAVE_ZLIB
+    return nullptr != m_inflater;
+#else
+    return false;
+#endif // STATICLIB_HTTPSERVER_HAVE_ZLIB
 }
 
 void http_request_reader::finished_reading(const asio::error_code& ec) {
+    m_tcp_conn->stop_header_deadline();
     // call the finished handler with the finished HTTP message
     if (m_finished) m_finished(m_http_msg, get_connection(), ec);
 }
@@ -16,11 +16,47 @@
 
 #include "staticlib/httpserver/http_response.hpp"
 
+#include <array>
+
 #include "staticlib/httpserver/algorithm.hpp"
 
 namespace staticlib {
 namespace httpserver {
 
+namespace { // anonymous
+
+struct status_line {
+    unsigned int code;
+    const char* message;
+    const char* line;
+    std::size_t line_length;
+};
+
+#define STATICLIB_HTTPSERVER_STATUS_LINE(code, message) \
+        {code, message, "HTTP/1.1 " #code " " message "\r\n", sizeof("HTTP/1.1 " #code " " message "\r\n") - 1}
+
+// precomputed HTTP/1.1 status lines for the standard messages
+const std::array<status_line, 14> STATUS_LINES = {{
+    STATICLIB_HTTPSERVER_STATUS_LINE(100, "Continue"),
+    STATICLIB_HTTPSERVER_STATUS_LINE(200, "OK"),
+    STATICLIB_HTTPSERVER_STATUS_LINE(201, "Created"),
+    STATICLIB_HTTPSERVER_STATUS_LINE(202, "Accepted"),
+    STATICLIB_HTTPSERVER_STATUS_LINE(204, "No Content"),
+    STATICLIB_HTTPSERVER_STATUS_LINE(302, "Found"),
+    STATICLIB_HTTPSERVER_STATUS_LINE(304, "Not Modified"),
+    STATICLIB_HTTPSERVER_STATUS_LINE(400, "Bad Request"),
+    STATICLIB_HTTPSERVER_STATUS_LINE(401, "Unauthorized"),
+    STATICLIB_HTTPSERVER_STATUS_LINE(403, "Forbidden"),
+    STATICLIB_HTTPSERVER_STATUS_LINE(404, "Not Found"),
+    STATICLIB_HTTPSERVER_STATUS_LINE(405, "Method Not Allowed"),
+    STATICLIB_HTTPSERVER_STATUS_LINE(500, "Server Error"),
+    STATICLIB_HTTPSERVER_STATUS_LINE(501, "Not Implemented")
+}};
+
+#undef STATICLIB_HTTPSERVER_STATUS_LINE
+
+} // namespace
+
 http_response::http_response(const http_request& http_request_ptr) : 
 m_status_code(RESPONSE_CODE_OK),
 m_status_message(RESPONSE_MESSAGE_OK) {
@@ -141,6 +177,18 @@ void http_response::update_first_line() const {
     m_first_line += m_status_message;
 }
 
+void http_response::append_first_line(std::string& buf) const {
+    if (1 == get_version_major() && 1 == get_version_minor()) {
+        for (auto& sl : STATUS_LINES) {
+            if (sl.code == m_status_code && 0 == m_status_message.compare(sl.message)) {
+                buf.append(sl.line, sl.line_length);
+                return;
+            }
+        }
+    }
+    http_message::append_first_line(buf);
+}
+
 void http_response::append_cookie_headers() {
     for (std::unordered_multimap<std::string, std::string, algorithm::ihash, algorithm::iequal_to>
             ::const_iterator i = get_cookies().begin(); i != get_cookies().end(); ++i) {
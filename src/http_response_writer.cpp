@@ -25,9 +25,49 @@
 
 #include "staticlib/httpserver/http_response_writer.hpp"
 
+#include <algorithm>
+#include <clocale>
+#include <cstdio>
+#include <cstring>
+
+#include "staticlib/httpserver/buffer_pool.hpp"
+#include "staticlib/httpserver/httpserver_exception.hpp"
+
 namespace staticlib { 
 namespace httpserver {
 
+const std::size_t http_response_writer::DEFAULT_COMPRESSION_MIN_LENGTH = 1024;
+
+const std::size_t http_response_writer::WRITE_BUFFERS_MAX = 64;
+
+const std::size_t http_response_writer::COALESCE_THRESHOLD = 4096;
+
+const std::size_t http_response_writer::DEFAULT_HIGH_WATERMARK = 64 * 1024;
+
+const std::size_t http_response_writer::DEFAULT_LOW_WATERMARK = 16 * 1024;
+
+namespace { // anonymous
+
+const std::size_t HEAD_BUFFER_CAPACITY = 512;
+
+const std::string FINAL_CHUNK = "0\r\n\r\n";
+
+const std::string CHUNK_END_FINAL = "\r\n0\r\n\r\n";
+
+void append_hex(std::string& str, std::size_t num) {
+    static const char* digits = "0123456789abcdef";
+    char buf[sizeof(std::size_t) * 2];
+    char* end = buf + sizeof(buf);
+    char* ptr = end;
+    do {
+        *--ptr = digits[num & 0xf];
+        num >>= 4;
+    } while (num > 0);
+    str.append(ptr, static_cast<std::size_t>(end - ptr));
+}
+
+} // namespace
+
 http_response_writer::http_response_writer(tcp_connection_ptr& tcp_conn, const http_request& http_request,
         finished_handler_type handler) :
 m_logger(STATICLIB_HTTPSERVER_GET_LOGGER("staticlib.httpserver.http_response_writer")),
@@ -38,7 +78,24 @@ m_client_supports_chunks(true),
 m_sending_chunks(false),
 m_sent_headers(false),
 m_finished(handler),
-m_http_response(new http_response(http_request)) {
+m_http_response(new http_response(http_request)),
+m_write_in_flight(false),
+m_file_fd(-1),
+m_file_offset(0),
+m_file_length(0),
+m_file_buffers_pos(0),
+m_file_split(0),
+m_compression_enabled(false),
+m_compression_min_length(DEFAULT_COMPRESSION_MIN_LENGTH),
+m_accept_encoding(http_request.get_header("Accept-Encoding")),
+m_body_high_watermark(DEFAULT_HIGH_WATERMARK),
+m_body_low_watermark(DEFAULT_LOW_WATERMARK),
+m_body_inflight_length(0),
+m_body_pending_length(0),
+m_body_source_finished(false),
+m_deadline(http_request.get_deadline()),
+m_pipeline(http_request.get_pipeline()),
+m_pipeline_index(http_request.get_pipeline_index()) {
     set_logger(STATICLIB_HTTPSERVER_GET_LOGGER("staticlib.httpserver.http_response_writer"));
     // set whether or not the client supports chunks
     supports_chunked_messages(m_http_response->get_chunks_supported());
@@ -59,57 +116,193 @@ std::shared_ptr<http_response_writer> http_response_writer::create(tcp_connectio
     return std::shared_ptr<http_response_writer>(new http_response_writer(tcp_conn, *http_request, handler));
 }
 
+http_response_writer::~http_response_writer() {
+    if (m_head_buffer.capacity() > 0) {
+        buffer_pool::release(std::move(m_head_buffer));
+    }
+    if (m_coalesced_buffer.capacity() > 0) {
+        buffer_pool::release(std::move(m_coalesced_buffer));
+    }
+    if (m_body_inflight.capacity() > 0) {
+        buffer_pool::release(std::move(m_body_inflight));
+    }
+    if (m_body_pending.capacity() > 0) {
+        buffer_pool::release(std::move(m_body_pending));
+    }
+}
+
 void http_response_writer::prepare_write_buffers(http_message::write_buffers_type& write_buffers,
         const bool send_final_chunk) {
+    // headers and chunk framing are rendered into a single contiguous
+    // buffer that is followed by content buffers, so everything
+    // can be sent together using a short list of write buffers
+    m_head_buffer.clear();
+    if (m_head_buffer.capacity() < HEAD_BUFFER_CAPACITY) {
+        m_head_buffer = buffer_pool::acquire(HEAD_BUFFER_CAPACITY);
+    }
+
     // check if the HTTP headers have been sent yet
     if (! m_sent_headers) {
-        // initialize write buffers for send operation
-        prepare_buffers_for_send(write_buffers);
+        prepare_buffers_for_send();
 
         // only send the headers once
         m_sent_headers = true;
     }
 
-    // combine I/O write buffers (headers and content) so that everything
-    // can be sent together; otherwise, we would have to send headers
-    // and content separately, which would not be as efficient
-    
+    if (m_content_length > 0) {
+        coalesce_content_buffers();
+    }
+    const std::string* tail = prepare_chunk_head(m_head_buffer, send_final_chunk);
+
+    if (!m_head_buffer.empty()) {
+        write_buffers.push_back(asio::buffer(m_head_buffer));
+    }
+    if (m_content_length > 0) {
+        // append response content buffers
+        m_file_split = write_buffers.size() + m_file_buffers_pos;
+        auto& content_buffers = m_content.get_buffers();
+        write_buffers.insert(write_buffers.end(), content_buffers.begin(), content_buffers.end());
+    }
+    if (nullptr != tail) {
+        write_buffers.push_back(asio::buffer(*tail));
+    }
+}
+
+const std::string* http_response_writer::prepare_chunk_head(std::string& head, const bool send_final_chunk) {
+    if (!(supports_chunked_messages() && sending_chunked_message())) return nullptr;
     // don't send anything if there is no data in content buffers
     if (m_content_length > 0) {
-        if (supports_chunked_messages() && sending_chunked_message()) {
-            // prepare the next chunk of data to send
-            // write chunk length in hex
-            char cast_buf[35];
-            sprintf(cast_buf, "%lx", static_cast<long>(m_content_length));
-            
-            // add chunk length as a string at the back of the text cache
-            m_text_cache.push_back(cast_buf);
-            // append length of chunk to write_buffers
-            write_buffers.push_back(asio::buffer(m_text_cache.back()));
-            // append an extra CRLF for chunk formatting
-            write_buffers.push_back(asio::buffer(http_message::STRING_CRLF));
-            
-            // append response content buffers
-            write_buffers.insert(write_buffers.end(), m_content_buffers.begin(),
-                                 m_content_buffers.end());
-            // append an extra CRLF for chunk formatting
-            write_buffers.push_back(asio::buffer(http_message::STRING_CRLF));
+        // chunk length in hex
+        append_hex(head, m_content_length);
+        head.append(http_message::STRING_CRLF);
+        // CRLF after the chunk, optionally followed by a zero-byte (final) chunk
+        return send_final_chunk ? std::addressof(CHUNK_END_FINAL) : std::addressof(http_message::STRING_CRLF);
+    }
+    if (send_final_chunk) {
+        // zero-byte (final) chunk
+        head.append(FINAL_CHUNK);
+    }
+    return nullptr;
+}
+
+bool http_response_writer::start_write_in_flight() {
+    std::lock_guard<std::mutex> guard{m_write_mutex};
+    if (m_write_in_flight) return false;
+    m_write_in_flight = true;
+    return true;
+}
+
+void http_response_writer::start_write(int fd, uint64_t file_offset, std::size_t file_length,
+        std::size_t file_split, bool last, write_handler_type handler) {
+    if (-1 != fd) {
+        if (m_pipeline) {
+            auto self = shared_from_this();
+            m_pipeline->run(m_tcp_conn, m_pipeline_index, last,
+                    [self, fd, file_offset, file_length, file_split](tcp_connection::io_handler_type done) {
+                self->send_with_file(self->m_write_buffers, fd, file_offset, file_length, file_split, std::move(done));
+            }, std::move(handler));
         } else {
-            // append response content buffers
-            write_buffers.insert(write_buffers.end(), m_content_buffers.begin(),
-                                 m_content_buffers.end());
+            send_with_file(m_write_buffers, fd, file_offset, file_length, file_split, std::move(handler));
         }
+    } else if (m_pipeline) {
+        // written after the responses to the preceding requests
+        m_pipeline->async_write(m_tcp_conn, m_pipeline_index, m_write_buffers, last, std::move(handler));
+    } else {
+        m_tcp_conn->async_write(write_buffers_ref(m_write_buffers), std::move(handler));
     }
-    
-    // prepare a zero-byte (final) chunk
-    if (send_final_chunk && supports_chunked_messages() && sending_chunked_message()) {
-        // add chunk length as a string at the back of the text cache
-        m_text_cache.push_back("0");
-        // append length of chunk to write_buffers
-        write_buffers.push_back(asio::buffer(m_text_cache.back()));
-        // append an extra CRLF for chunk formatting
-        write_buffers.push_back(asio::buffer(http_message::STRING_CRLF));
-        write_buffers.push_back(asio::buffer(http_message::STRING_CRLF));
+}
+
+void http_response_writer::queue_more_data(const bool send_final_chunk, write_handler_type send_handler) {
+    compress_content(send_final_chunk, true);
+    std::unique_ptr<queued_send> qs{new queued_send()};
+    // only the chunk framing is copied, content buffers are moved by reference
+    m_queued_head.clear();
+    const std::string* tail = prepare_chunk_head(m_queued_head, send_final_chunk);
+    qs->content.append(m_queued_head.data(), m_queued_head.length());
+    if (-1 != m_file_fd) {
+        qs->file_fd = m_file_fd;
+        qs->file_offset = m_file_offset;
+        qs->file_length = m_file_length;
+        qs->file_split = qs->content.get_buffers().size() + m_file_buffers_pos;
+        m_file_fd = -1;
+    }
+    qs->content.splice(m_content);
+    if (nullptr != tail) {
+        qs->content.append_no_copy(tail->data(), tail->length());
+    }
+    qs->length = qs->content.get_length() + (-1 != qs->file_fd ? qs->file_length : 0);
+    qs->last = send_final_chunk || !m_sending_chunks;
+    qs->handler = std::move(send_handler);
+    m_content_length = 0;
+    {
+        std::lock_guard<std::mutex> guard{m_write_mutex};
+        m_queued_sends.emplace_back(std::move(qs));
+        if (m_write_in_flight) return;
+        // previous write has completed while the data was being queued
+        m_write_in_flight = true;
+    }
+    send_queued_data();
+}
+
+void http_response_writer::send_queued_data() {
+    {
+        std::lock_guard<std::mutex> guard{m_write_mutex};
+        // sends without file regions are written together
+        do {
+            m_flushed_sends.emplace_back(std::move(m_queued_sends.front()));
+            m_queued_sends.pop_front();
+        } while (!m_queued_sends.empty() && -1 == m_flushed_sends.front()->file_fd &&
+                -1 == m_queued_sends.front()->file_fd);
+    }
+    m_write_buffers.clear();
+    for (auto& qs : m_flushed_sends) {
+        auto& buffers = qs->content.get_buffers();
+        m_write_buffers.insert(m_write_buffers.end(), buffers.begin(), buffers.end());
+    }
+    auto self = shared_from_this();
+    auto handler = [self](const asio::error_code& ec, std::size_t bytes_written) {
+        self->m_tcp_conn->dispatch([self, ec, bytes_written] {
+            self->handle_queued_write(ec, bytes_written);
+        });
+    };
+    const queued_send& first = *m_flushed_sends.front();
+    start_write(first.file_fd, first.file_offset, first.file_length, first.file_split,
+            m_flushed_sends.back()->last, std::move(handler));
+}
+
+void http_response_writer::finish_write(const asio::error_code& ec) {
+    m_inflight_content.clear();
+    std::deque<std::unique_ptr<queued_send>> failed;
+    {
+        std::lock_guard<std::mutex> guard{m_write_mutex};
+        if (m_queued_sends.empty()) {
+            m_write_in_flight = false;
+            return;
+        }
+        if (ec) {
+            // queued data cannot be sent after a write error
+            failed.swap(m_queued_sends);
+            m_write_in_flight = false;
+        }
+    }
+    if (!ec) {
+        // write in progress flag is kept for the queued write
+        send_queued_data();
+        return;
+    }
+    for (auto& qs : failed) {
+        qs->handler(ec, 0);
+    }
+}
+
+void http_response_writer::handle_queued_write(const asio::error_code& ec, std::size_t bytes_written) {
+    STATICLIB_HTTPSERVER_LOG_DEBUG(m_logger, "Sent " << bytes_written << " bytes of queued HTTP data");
+    std::vector<std::unique_ptr<queued_send>> flushed;
+    flushed.swap(m_flushed_sends);
+    // handlers are called after the next queued write is started
+    finish_write(ec);
+    for (auto& qs : flushed) {
+        qs->handler(ec, ec ? 0 : qs->length);
     }
 }
 
@@ -120,17 +313,185 @@ void http_response_writer::finished_writing(const asio::error_code& ec) {
 }
 
 void http_response_writer::clear() {
-    m_content_buffers.clear();
-    m_binary_cache.clear();
-    m_text_cache.clear();
-    m_content_stream.str("");
+    m_content.clear();
+    if (m_content_stream) {
+        m_content_stream->str("");
+    }
     m_stream_is_empty = true;
     m_content_length = 0;
+    m_file_fd = -1;
+}
+
+void http_response_writer::write(const std::string& data) {
+    write(data.data(), data.length());
+}
+
+void http_response_writer::write(const char* data) {
+    write(data, std::strlen(data));
+}
+
+template<typename T>
+void http_response_writer::write_signed(T data) {
+    if (!is_default_formatting()) {
+        write_to_stream(data);
+        return;
+    }
+    bool negative = data < 0;
+    // negate in unsigned arithmetic, so the minimum value does not overflow
+    unsigned long long magnitude = static_cast<unsigned long long>(data);
+    write_integer(negative ? 0ULL - magnitude : magnitude, negative);
+}
+
+template<typename T>
+void http_response_writer::write_unsigned(T data) {
+    if (!is_default_formatting()) {
+        write_to_stream(data);
+        return;
+    }
+    write_integer(static_cast<unsigned long long>(data), false);
+}
+
+void http_response_writer::write_text(bool data) {
+    // "boolalpha" flag is checked here
+    write_unsigned(data);
+}
+
+void http_response_writer::write_text(char data) {
+    if (!is_default_formatting()) {
+        write_to_stream(data);
+        return;
+    }
+    flush_content_stream();
+    m_content.append(std::addressof(data), 1);
+    m_content_length += 1;
+}
+
+void http_response_writer::write_text(signed char data) {
+    write_text(static_cast<char>(data));
+}
+
+void http_response_writer::write_text(unsigned char data) {
+    write_text(static_cast<char>(data));
+}
+
+void http_response_writer::write_text(short data) {
+    write_signed(data);
+}
+
+void http_response_writer::write_text(unsigned short data) {
+    write_unsigned(data);
+}
+
+void http_response_writer::write_text(int data) {
+    write_signed(data);
+}
+
+void http_response_writer::write_text(unsigned int data) {
+    write_unsigned(data);
+}
+
+void http_response_writer::write_text(long data) {
+    write_signed(data);
+}
+
+void http_response_writer::write_text(unsigned long data) {
+    write_unsigned(data);
+}
+
+void http_response_writer::write_text(long long data) {
+    write_signed(data);
+}
+
+void http_response_writer::write_text(unsigned long long data) {
+    write_unsigned(data);
+}
+
+void http_response_writer::write_text(float data) {
+    if (!is_default_formatting()) {
+        write_to_stream(data);
+        return;
+    }
+    write_floating(data);
+}
+
+void http_response_writer::write_text(double data) {
+    if (!is_default_formatting()) {
+        write_to_stream(data);
+        return;
+    }
+    write_floating(data);
+}
+
+void http_response_writer::write_integer(unsigned long long magnitude, bool negative) {
+    static const char* digit_pairs =
+            "00010203040506070809"
+            "10111213141516171819"
+            "20212223242526272829"
+            "30313233343536373839"
+            "40414243444546474849"
+            "50515253545556575859"
+            "60616263646566676869"
+            "70717273747576777879"
+            "80818283848586878889"
+            "90919293949596979899";
+    char buf[24];
+    char* end = buf + sizeof(buf);
+    char* ptr = end;
+    while (magnitude >= 100) {
+        std::size_t idx = static_cast<std::size_t>(magnitude % 100) * 2;
+        magnitude /= 100;
+        *--ptr = digit_pairs[idx + 1];
+        *--ptr = digit_pairs[idx];
+    }
+    if (magnitude >= 10) {
+        std::size_t idx = static_cast<std::size_t>(magnitude) * 2;
+        *--ptr = digit_pairs[idx + 1];
+        *--ptr = digit_pairs[idx];
+    } else {
+        *--ptr = static_cast<char>('0' + magnitude);
+    }
+    if (negative) {
+        *--ptr = '-';
+    }
+    std::size_t len = static_cast<std::size_t>(end - ptr);
+    flush_content_stream();
+    m_content.append(ptr, len);
+    m_content_length += len;
+}
+
+void http_response_writer::write_floating(double data) {
+    // same as 'std::ostream' with default flags: "%g" with precision 6,
+    // formatted number is at most 13 chars long ("-1.23457e+308")
+    char buf[32];
+    int res = std::snprintf(buf, sizeof(buf), "%.6g", data);
+    if (res <= 0) return;
+    std::size_t len = static_cast<std::size_t>(res);
+    // streams use "C" locale by default, while printf uses the global one
+    char point = *std::localeconv()->decimal_point;
+    if ('.' != point) {
+        std::replace(buf, buf + len, point, '.');
+    }
+    flush_content_stream();
+    m_content.append(buf, len);
+    m_content_length += len;
+}
+
+bool http_response_writer::is_default_formatting() const {
+    if (!m_content_stream) return true;
+    return (std::ios_base::skipws | std::ios_base::dec) == m_content_stream->flags() &&
+            6 == m_content_stream->precision() && 0 == m_content_stream->width();
+}
+
+std::ostringstream& http_response_writer::get_content_stream() {
+    if (!m_content_stream) {
+        m_content_stream.reset(new std::ostringstream());
+    }
+    return *m_content_stream;
 }
 
 void http_response_writer::write(std::ostream& (*iomanip)(std::ostream&)) {
     if (m_http_response->is_body_allowed()) {
-        m_content_stream << iomanip;
+        get_content_stream() << iomanip;
         if (m_stream_is_empty) m_stream_is_empty = false;
     }
 }
@@ -138,7 +499,7 @@ void http_response_writer::write(std::ostream& (*iomanip)(std::ostream&)) {
 void http_response_writer::write(const void *data, size_t length) {
     if (m_http_response->is_body_allowed() && length != 0) {
         flush_content_stream();
-        m_content_buffers.push_back(m_binary_cache.add(data, length));
+        m_content.append(static_cast<const char*>(data), length);
         m_content_length += length;
     }
 }
@@ -146,7 +507,7 @@ void http_response_writer::write(const void *data, size_t length) {
 void http_response_writer::write_no_copy(const std::string& data) {
     if (m_http_response->is_body_allowed() && !data.empty()) {
         flush_content_stream();
-        m_content_buffers.push_back(asio::buffer(data));
+        m_content.append_no_copy(data.data(), data.length());
         m_content_length += data.size();
     }
 }
@@ -154,21 +515,87 @@ void http_response_writer::write_no_copy(const std::string& data) {
 void http_response_writer::write_no_copy(void *data, size_t length) {
     if (m_http_response->is_body_allowed() && length > 0) {
         flush_content_stream();
-        m_content_buffers.push_back(asio::buffer(data, length));
+        m_content.append_no_copy(static_cast<const char*>(data), length);
         m_content_length += length;
     }
 }
 
 void http_response_writer::write_move(std::string&& data) {
     if (m_http_response->is_body_allowed() && !data.empty()) {
-        m_moved_cache.emplace_back(std::move(data));
-        std::string& dataref = m_moved_cache.back();
         flush_content_stream();
-        m_content_buffers.emplace_back(dataref.c_str(), dataref.length());
-        m_content_length += dataref.length();
+        m_content_length += data.length();
+        m_content.append_move(std::move(data));
     }
 }
 
+void http_response_writer::write_shared(std::shared_ptr<const std::string> data) {
+    if (m_http_response->is_body_allowed() && data && !data->empty()) {
+        flush_content_stream();
+        m_content_length += data->length();
+        m_content.append_shared(std::move(data));
+    }
+}
+
+void http_response_writer::write_file(int fd, uint64_t offset, std::size_t length) {
+    if (m_http_response->is_body_allowed() && length > 0) {
+        if (-1 != m_file_fd) {
+            throw httpserver_exception("Only one file region can be written per send call");
+        }
+#ifdef STATICLIB_HTTPSERVER_HAVE_ZLIB
+        if (m_deflater) {
+            throw httpserver_exception("File region cannot be written into compressed content");
+        }
+#endif // STATICLIB_HTTPSERVER_HAVE_ZLIB
+        flush_content_stream();
+        m_file_fd = fd;
+        m_file_offset = offset;
+        m_file_length = length;
+        m_file_buffers_pos = m_content.get_buffers().size();
+        // data written after the file region must not be merged with data before it
+        m_content.split();
+        m_content_length += length;
+    }
+}
+
+void http_response_writer::enable_compression(std::size_t min_length) {
+    m_compression_enabled = true;
+    m_compression_min_length = min_length;
+}
+
+void http_response_writer::send_with_file(const http_message::write_buffers_type& write_buffers, int fd,
+        uint64_t offset, std::size_t length, std::size_t file_split, write_handler_type send_handler) {
+    auto split = write_buffers.begin() + static_cast<std::ptrdiff_t>(file_split);
+    http_message::write_buffers_type head(write_buffers.begin(), split);
+    http_message::write_buffers_type tail(split, write_buffers.end());
+    auto self = shared_from_this();
+    auto conn = m_tcp_conn;
+    // headers, file and tail are sent with separate operations,
+    // cork keeps headers from being sent in a separate small segment
+    conn->set_cork(true);
+    m_tcp_conn->async_write(head, [self, conn, fd, offset, length, tail, send_handler](
+            const asio::error_code& ec, std::size_t head_written) {
+        if (ec) {
+            conn->set_cork(false);
+            send_handler(ec, head_written);
+            return;
+        }
+        conn->async_write_file(fd, offset, length, [self, conn, tail, send_handler, head_written](
+                const asio::error_code& ec, std::size_t file_written) {
+            std::size_t written = head_written + file_written;
+            if (ec || tail.empty()) {
+                conn->set_cork(false);
+                send_handler(ec, written);
+                return;
+            }
+            conn->async_write(tail, [self, conn, send_handler, written](
+                    const asio::error_code& ec, std::size_t tail_written) {
+                conn->set_cork(false);
+                send_handler(ec, written + tail_written);
+            });
+        });
+    });
+}
+
 void http_response_writer::send() {
     send_more_data(false, bind_to_write_handler());
 }
@@ -178,6 +605,86 @@ void http_response_writer::send_final_chunk() {
     send_more_data(true, bind_to_write_handler());
 }
 
+void http_response_writer::send_body(body_source_type source, std::size_t high_watermark,
+        std::size_t low_watermark) {
+    if (!m_http_response->is_body_allowed()) {
+        send();
+        return;
+    }
+    m_body_source = std::move(source);
+    m_body_high_watermark = (std::max)(high_watermark, static_cast<std::size_t>(2));
+    m_body_low_watermark = (std::min)((std::max)(low_watermark, static_cast<std::size_t>(1)),
+            m_body_high_watermark / 2);
+    m_body_inflight = buffer_pool::acquire(m_body_high_watermark);
+    m_body_inflight.resize(m_body_high_watermark);
+    m_body_pending = buffer_pool::acquire(m_body_high_watermark);
+    m_body_pending.resize(m_body_high_watermark);
+    // errors on the first pull are reported to the caller
+    pull_body(m_body_low_watermark);
+    send_body_chunk();
+}
+
+void http_response_writer::pull_body(std::size_t limit) {
+    while (!m_body_source_finished && m_body_pending_length < limit) {
+        std::size_t len = m_body_source(std::addressof(m_body_pending[m_body_pending_length]),
+                limit - m_body_pending_length);
+        if (0 == len) {
+            m_body_source_finished = true;
+        }
+        m_body_pending_length += (std::min)(len, limit - m_body_pending_length);
+    }
+}
+
+void http_response_writer::send_body_chunk() {
+    std::swap(m_body_inflight, m_body_pending);
+    m_body_inflight_length = m_body_pending_length;
+    m_body_pending_length = 0;
+    // prefetch the next chunk up to the high watermark, it is done before
+    // starting the write, so the write handler cannot race with the source
+    try {
+        pull_body(m_body_high_watermark - m_body_inflight_length);
+    } catch (const std::exception& e) {
+        abort_body(e);
+        return;
+    }
+    clear();
+    write_no_copy(std::addressof(m_body_inflight.front()), m_body_inflight_length);
+    auto self = shared_from_this();
+    auto handler = [self](const asio::error_code& ec, std::size_t bytes_written) {
+        self->handle_body_write(ec, bytes_written);
+    };
+    if (m_body_source_finished && 0 == m_body_pending_length) {
+        m_body_source = nullptr;
+        send_final_chunk(handler);
+    } else {
+        send_chunk(handler);
+    }
+}
+
+void http_response_writer::handle_body_write(const asio::error_code& ec, std::size_t bytes_written) {
+    if (ec || !m_body_source) {
+        m_body_source = nullptr;
+        handle_write(ec, bytes_written);
+        return;
+    }
+    // socket has accepted previous chunk, top up the pending one
+    try {
+        pull_body(m_body_low_watermark);
+    } catch (const std::exception& e) {
+        abort_body(e);
+        return;
+    }
+    send_body_chunk();
+}
+
+void http_response_writer::abort_body(const std::exception& e) {
+    STATICLIB_HTTPSERVER_LOG_ERROR(m_logger, "HTTP body source error: " << e.what());
+    // partially sent body cannot be completed, client must see a broken connection
+    m_tcp_conn->set_lifecycle(tcp_connection::LIFECYCLE_CLOSE);
+    m_body_source = nullptr;
+    finished_writing(asio::error::operation_aborted);
+}
+
 tcp_connection_ptr& http_response_writer::get_connection() {
     return m_tcp_conn;
 }
@@ -208,40 +715,105 @@ logger http_response_writer::get_logger() {
 
 void http_response_writer::flush_content_stream() {
     if (!m_stream_is_empty) {
-        std::string string_to_add(m_content_stream.str());
+        std::string string_to_add(m_content_stream->str());
         if (!string_to_add.empty()) {
-            m_content_stream.str("");
+            m_content_stream->str("");
             m_content_length += string_to_add.size();
-            m_text_cache.push_back(string_to_add);
-            m_content_buffers.push_back(asio::buffer(m_text_cache.back()));
+            m_content.append_move(std::move(string_to_add));
         }
         m_stream_is_empty = true;
     }
 }
 
-http_response_writer::binary_cache_t::~binary_cache_t() {
-    for (iterator i = begin(); i != end(); ++i) {
-        delete[] i->first;
+void http_response_writer::compress_content(const bool send_final_chunk, const bool queued) {
+#ifdef STATICLIB_HTTPSERVER_HAVE_ZLIB
+    if (!m_sent_headers && m_compression_enabled && -1 == m_file_fd && m_http_response->is_body_allowed() &&
+            !m_http_response->has_header(http_message::HEADER_CONTENT_ENCODING) &&
+            http_deflater::is_compressible(m_http_response->get_header(http_message::HEADER_CONTENT_TYPE))) {
+        // response depends on the request headers
+        m_http_response->add_header("Vary", "Accept-Encoding");
+        std::string encoding = http_deflater::negotiate(m_accept_encoding);
+        if (!encoding.empty() && (sending_chunked_message() || m_content_length >= m_compression_min_length)) {
+            m_deflater.reset(new http_deflater(encoding));
+            m_http_response->change_header(http_message::HEADER_CONTENT_ENCODING, encoding);
+        }
     }
-}
-
-asio::const_buffer http_response_writer::binary_cache_t::add(const void *ptr, const size_t size) {
-    char *data_ptr = new char[size];
-    memcpy(data_ptr, ptr, size);
-    push_back(std::make_pair(data_ptr, size));
-    return asio::buffer(data_ptr, size);
+    if (!m_deflater) return;
+    bool finish = send_final_chunk || !sending_chunked_message();
+    if (0 == m_content_length && !finish) return;
+    // data compressed for the write in progress must stay intact,
+    // queued content owns its compressed data
+    std::string queued_compressed;
+    std::string& compressed = queued ? queued_compressed : m_compressed;
+    compressed.clear();
+    for (auto& buf : m_content.get_buffers()) {
+        m_deflater->deflate(asio::buffer_cast<const char*>(buf), asio::buffer_size(buf), compressed);
+    }
+    // each chunk is flushed to be decodable by client as soon as it is received
+    m_deflater->flush(finish, compressed);
+    if (finish) {
+        // return zlib context to the pool
+        m_deflater.reset();
+    }
+    m_content.clear();
+    m_content_length = compressed.size();
+    if (queued) {
+        m_content.append_move(std::move(queued_compressed));
+    } else {
+        m_content.append_no_copy(compressed.data(), compressed.size());
+    }
+#else
+    (void) send_final_chunk;
+    (void) queued;
+#endif // STATICLIB_HTTPSERVER_HAVE_ZLIB
 }
 
 http_response& http_response_writer::get_response() {
     return *m_http_response;
 }
 
-void http_response_writer::prepare_buffers_for_send(http_message::write_buffers_type& write_buffers) {
+void http_response_writer::prepare_buffers_for_send() {
     if (get_content_length() > 0) {
         m_http_response->set_content_length(get_content_length());
     }
-    m_http_response->prepare_buffers_for_send(write_buffers, get_connection()->get_keep_alive(),
-            sending_chunked_message());
+    bool keep_alive = m_pipeline ? m_pipeline->get_keep_alive(m_pipeline_index) : get_connection()->get_keep_alive();
+    m_http_response->serialize_headers(m_head_buffer, keep_alive,
+            sending_chunked_message(), get_connection()->get_common_headers());
+}
+
+void http_response_writer::coalesce_content_buffers() {
+    // file region position is an index in content buffers
+    auto& content_buffers = m_content.get_buffers();
+    if (content_buffers.size() + 2 <= WRITE_BUFFERS_MAX || -1 != m_file_fd) return;
+    // reserve exact length so pointers into the buffer stay valid
+    std::size_t small_length = 0;
+    for (auto& buf : content_buffers) {
+        std::size_t len = asio::buffer_size(buf);
+        if (len < COALESCE_THRESHOLD) small_length += len;
+    }
+    if (m_coalesced_buffer.capacity() > 0) {
+        buffer_pool::release(std::move(m_coalesced_buffer));
+    }
+    m_coalesced_buffer = buffer_pool::acquire(small_length);
+    http_message::write_buffers_type coalesced;
+    std::size_t run_start = std::string::npos;
+    for (auto& buf : content_buffers) {
+        std::size_t len = asio::buffer_size(buf);
+        if (len < COALESCE_THRESHOLD) {
+            if (std::string::npos == run_start) run_start = m_coalesced_buffer.length();
+            m_coalesced_buffer.append(asio::buffer_cast<const char*>(buf), len);
+        } else {
+            if (std::string::npos != run_start) {
+                coalesced.emplace_back(m_coalesced_buffer.data() + run_start, m_coalesced_buffer.length() - run_start);
+                run_start = std::string::npos;
+            }
+            coalesced.push_back(buf);
+        }
+    }
+    if (std::string::npos != run_start) {
+        coalesced.emplace_back(m_coalesced_buffer.data() + run_start, m_coalesced_buffer.length() - run_start);
+    }
+    content_buffers.swap(coalesced);
 }
 
 http_response_writer::write_handler_type http_response_writer::bind_to_write_handler() {
@@ -262,6 +834,9 @@ void http_response_writer::handle_write(const asio::error_code& write_error, std
             STATICLIB_HTTPSERVER_LOG_DEBUG(log_ptr, "Sent HTTP response of " << bytes_written << " bytes ("
                     << (get_connection()->get_keep_alive() ? "keeping alive)" : "closing)"));
         }
+    } else {
+        // response is truncated, connection cannot be reused
+        get_connection()->set_lifecycle(tcp_connection::LIFECYCLE_CLOSE);
     }
     finished_writing(write_error);
 }
@@ -26,11 +26,16 @@
 #include <functional>
 #include <stdexcept>
 #include <algorithm>
+#include <chrono>
+#include <thread>
 
+#include "staticlib/httpserver/handler_deadline.hpp"
+#include "staticlib/httpserver/http_canned_response.hpp"
 #include "staticlib/httpserver/http_request_reader.hpp"
 #include "staticlib/httpserver/httpserver_exception.hpp"
 #include "staticlib/httpserver/http_filter_chain.hpp"
 #include "staticlib/httpserver/http_response_writer.hpp"
+#include "staticlib/httpserver/response_pipeline.hpp"
 
 #ifdef STATICLIB_HTTPSERVER_USE_SSL
 #include "openssl/ssl.h"
@@ -67,60 +72,90 @@ T& choose_map_by_method(const std::string& method, T& get_map, T& post_map, T& p
     } 
 }
 
+const std::string CONTENT_TYPE_JSON = "application/json";
+
 void handle_bad_request(http_request_ptr& request, tcp_connection_ptr& conn) {
-    static const std::string BAD_REQUEST_MSG = R"({
+    static const http_canned_response BAD_REQUEST{http_message::RESPONSE_CODE_BAD_REQUEST,
+            http_message::RESPONSE_MESSAGE_BAD_REQUEST, CONTENT_TYPE_JSON, R"({
     "code": 400,
     "message": "Bad Request",
     "description": "Your browser sent a request that this server could not understand."
-})";
-    http_response_writer_ptr writer{http_response_writer::create(conn, request)};
-    writer->get_response().set_status_code(http_message::RESPONSE_CODE_BAD_REQUEST);
-    writer->get_response().set_status_message(http_message::RESPONSE_MESSAGE_BAD_REQUEST);
-    writer->write_no_copy(BAD_REQUEST_MSG);
-    writer->send();
+})"};
+    BAD_REQUEST.send(*request, conn);
 }
 
 void handle_not_found_request(http_request_ptr& request, tcp_connection_ptr& conn) {
-    static const std::string NOT_FOUND_MSG_START = R"({
+    static const http_canned_response NOT_FOUND{http_message::RESPONSE_CODE_NOT_FOUND,
+            http_message::RESPONSE_MESSAGE_NOT_FOUND, CONTENT_TYPE_JSON, R"({
     "code": 404,
     "message": "Not Found",
-    "description": "The requested URL: [)";
-    static const std::string NOT_FOUND_MSG_FINISH = R"(] was not found on this server."
-})";
-    http_response_writer_ptr writer{http_response_writer::create(conn, request)};
-    writer->get_response().set_status_code(http_message::RESPONSE_CODE_NOT_FOUND);
-    writer->get_response().set_status_message(http_message::RESPONSE_MESSAGE_NOT_FOUND);
-    writer->write_no_copy(NOT_FOUND_MSG_START);
-    auto res = algorithm::xml_encode(request->get_resource());
-    std::replace(res.begin(), res.end(), '"', '\'');
-    writer->write_move(std::move(res));
-    writer->write_no_copy(NOT_FOUND_MSG_FINISH);
-    writer->send();
+    "description": "The requested URL: [{{}}] was not found on this server."
+})"};
+    NOT_FOUND.send(*request, conn, {request->get_resource()});
 }
 
 void handle_server_error(http_request_ptr& request, tcp_connection_ptr& tcp_conn,
         const std::string& error_msg) {
-    static const std::string SERVER_ERROR_MSG_START = R"({
-    "code": 404,
-    "message": "Not Found",
-    "description": ")";
-    static const std::string SERVER_ERROR_MSG_FINISH = R"("
-})";
-    http_response_writer_ptr writer(http_response_writer::create(tcp_conn, request));
-    writer->get_response().set_status_code(http_message::RESPONSE_CODE_SERVER_ERROR);
-    writer->get_response().set_status_message(http_message::RESPONSE_MESSAGE_SERVER_ERROR);
-    writer->write_no_copy(SERVER_ERROR_MSG_START);
-    auto res = algorithm::xml_encode(error_msg);
-    std::replace(res.begin(), res.end(), '"', '\'');
-    writer->write_move(std::move(res));
-    writer->write_no_copy(SERVER_ERROR_MSG_FINISH);
-    writer->send();
+    static const http_canned_response SERVER_ERROR{http_message::RESPONSE_CODE_SERVER_ERROR,
+            http_message::RESPONSE_MESSAGE_SERVER_ERROR, CONTENT_TYPE_JSON, R"({
+    "code": 500,
+    "message": "Server Error",
+    "description": "{{}}"
+})"};
+    SERVER_ERROR.send(*request, tcp_conn, {error_msg});
+}
+
+void handle_overload(http_request_ptr& request, tcp_connection_ptr& conn) {
+    static const http_canned_response SERVICE_UNAVAILABLE = http_canned_response(
+            http_message::RESPONSE_CODE_SERVICE_UNAVAILABLE, http_message::RESPONSE_MESSAGE_SERVICE_UNAVAILABLE,
+            CONTENT_TYPE_JSON, R"({
+    "code": 503,
+    "message": "Service Unavailable",
+    "description": "Server is overloaded, please retry the request later."
+})").add_header("Retry-After", "1");
+    SERVICE_UNAVAILABLE.send(*request, conn);
+}
+
+void handle_too_many_requests(http_request_ptr& request, tcp_connection_ptr& conn) {
+    static const http_canned_response TOO_MANY_REQUESTS = http_canned_response(
+            http_message::RESPONSE_CODE_TOO_MANY_REQUESTS, http_message::RESPONSE_MESSAGE_TOO_MANY_REQUESTS,
+            CONTENT_TYPE_JSON, R"({
+    "code": 429,
+    "message": "Too Many Requests",
+    "description": "Request rate limit exceeded, please retry the request later."
+})").add_header("Retry-After", "1");
+    TOO_MANY_REQUESTS.send(*request, conn);
+}
+
+void handle_gateway_timeout(http_request_ptr& request, tcp_connection_ptr& conn) {
+    static const http_canned_response GATEWAY_TIMEOUT = http_canned_response(
+            http_message::RESPONSE_CODE_GATEWAY_TIMEOUT, http_message::RESPONSE_MESSAGE_GATEWAY_TIMEOUT,
+            CONTENT_TYPE_JSON, R"({
+    "code": 504,
+    "message": "Gateway Timeout",
+    "description": "Request handler did not respond in time."
+})");
+    conn->set_lifecycle(tcp_connection::LIFECYCLE_CLOSE);
+    tcp_connection_ptr conn_holder = conn;
+    GATEWAY_TIMEOUT.send(*request, conn, [conn_holder](const asio::error_code&) {
+        conn_holder->finish();
+        // stuck handler may still use the connection from a worker thread, so the socket
+        // is only shut down here and is closed when the last reference to it is released
+        conn_holder->abort();
+    });
+}
+
+std::string route_key(const std::string& method, const std::string& resource) {
+    // HEAD requests are served by GET handlers
+    const std::string& me = http_message::REQUEST_METHOD_HEAD == method ? 
+            http_message::REQUEST_METHOD_GET : method;
+    return me + " " + resource;
 }
 
 void handle_root_options(http_request_ptr& request, tcp_connection_ptr& conn) {
-    auto writer = http_response_writer::create(conn, request);
-    writer->get_response().change_header("Allow", "HEAD, GET, POST, PUT, DELETE, OPTIONS");
-    writer->send();
+    static const http_canned_response ROOT_OPTIONS = http_canned_response(http_message::RESPONSE_CODE_OK,
+            http_message::RESPONSE_MESSAGE_OK, "", "").add_header("Allow", "HEAD, GET, POST, PUT, DELETE, OPTIONS");
+    ROOT_OPTIONS.send(*request, conn);
 }
 
 template<typename T>
@@ -159,7 +194,74 @@ std::vector<std::reference_wrapper<T>> find_submatch_filters(
 
 } // namespace
 
-http_server::~http_server() STATICLIB_HTTPSERVER_NOEXCEPT { }
+/**
+ * Owns common headers block and updates its "Date" header every second,
+ * pending handlers hold weak references, so timer is cancelled
+ * by destructor while the IO service is still alive
+ */
+class http_server::common_headers_updater : public std::enable_shared_from_this<common_headers_updater> {
+    http_common_headers m_headers;
+    asio::io_service::strand m_strand;
+    asio::steady_timer m_timer;
+    bool m_running;
+
+public:
+    common_headers_updater(asio::io_service& io_service) :
+    m_strand(io_service),
+    m_timer(io_service),
+    m_running(false) { }
+
+    http_common_headers& get_headers() {
+        return m_headers;
+    }
+
+    void start() {
+        std::weak_ptr<common_headers_updater> weak = shared_from_this();
+        m_strand.post([weak] {
+            auto self = weak.lock();
+            if (!self || self->m_running) return;
+            self->m_running = true;
+            self->schedule();
+        });
+    }
+
+    void stop() {
+        std::weak_ptr<common_headers_updater> weak = shared_from_this();
+        m_strand.post([weak] {
+            auto self = weak.lock();
+            if (!self) return;
+            self->m_running = false;
+            self->m_timer.cancel();
+        });
+    }
+
+private:
+    void schedule() {
+        // same clock is used for the header and for the wake up time, "time()"
+        // may use coarse clock that lags behind the start of the second
+        auto now = std::chrono::system_clock::now();
+        m_headers.update(std::chrono::system_clock::to_time_t(now));
+        // wake up shortly after the start of the next second
+        auto since_epoch = now.time_since_epoch();
+        auto since_second = since_epoch - std::chrono::duration_cast<std::chrono::seconds>(since_epoch);
+        m_timer.expires_from_now(std::chrono::seconds(1) - since_second + std::chrono::milliseconds(1));
+        std::weak_ptr<common_headers_updater> weak = shared_from_this();
+        m_timer.async_wait(m_strand.wrap([weak](const asio::error_code& ec) {
+            auto self = weak.lock();
+            if (ec || !self || !self->m_running) return;
+            self->schedule();
+        }));
+    }
+};
+
+http_server::~http_server() STATICLIB_HTTPSERVER_NOEXCEPT {
+    // handler may still run after handler deadline has finished its connection
+    try {
+        finish_default_scheduler();
+    } catch (const std::exception& e) {
+        (void) e;
+    }
+}
 
 http_server::http_server(uint32_t number_of_threads, uint16_t port,
         asio::ip::address_v4 ip_address
@@ -174,8 +276,21 @@ http_server::http_server(uint32_t number_of_threads, uint16_t port,
 tcp_server(asio::ip::tcp::endpoint(ip_address, port)),
 bad_request_handler(handle_bad_request),
 not_found_handler(handle_not_found_request),
-server_error_handler(handle_server_error) {
+server_error_handler(handle_server_error),
+#ifdef STATICLIB_HTTPSERVER_HAVE_ZLIB
+inflate_ratio_max(http_inflater::DEFAULT_RATIO_MAX),
+#else
+inflate_ratio_max(0),
+#endif // STATICLIB_HTTPSERVER_HAVE_ZLIB
+common_headers(std::make_shared<common_headers_updater>(get_io_service())),
+handler_lanes(new priority_lanes([this](std::function<void()> work_func) {
+    this->worker_pool->post(std::move(work_func));
+}, 0)),
+worker_pool(new work_stealing_pool()),
+route_limit_max(0),
+pipeline_depth(1) {
     get_active_scheduler().set_num_threads(number_of_threads);
+    set_worker_threads((std::max)(std::thread::hardware_concurrency(), 1u));
 #ifdef STATICLIB_HTTPSERVER_HAVE_SSL
     if (!ssl_key_file.empty()) {
         set_ssl_flag(true);
@@ -208,6 +323,86 @@ void http_server::add_handler(const std::string& method,
     if (!it.second) throw httpserver_exception("Invalid duplicate handler path: [" + clean_resource + "], method: [" + method + "]");
 }
 
+void http_server::add_offloaded_handler(const std::string& method,
+        const std::string& resource, request_handler_type request_handler, uint32_t lane_idx) {
+    if (lane_idx >= handler_lanes->get_lanes_count()) {
+        throw httpserver_exception("Invalid priority lane: [" + std::to_string(lane_idx) + "],"
+                " resource: [" + resource + "], method: [" + method + "]");
+    }
+    auto limit = overload ? std::make_shared<adaptive_limit>(1, route_limit_max, overload->get_interval()) :
+            std::shared_ptr<adaptive_limit>();
+    route_limits.emplace(route_key(method, strip_trailing_slash(resource)), std::move(limit));
+    add_handler(method, resource, [this, request_handler, lane_idx](http_request_ptr& request, tcp_connection_ptr& conn) {
+        http_request_ptr req = request;
+        tcp_connection_ptr co = conn;
+        uint32_t lane = http_request::PRIORITY_LANE_UNSET != req->get_priority_lane() ? req->get_priority_lane() : lane_idx;
+        this->handler_lanes->post(lane, [this, request_handler, req, co]() mutable {
+            if (req->is_cancelled()) {
+                // timeout response was sent while the request was queued
+                return;
+            }
+            overload_admission* admission = req->get_admission();
+            if (nullptr != admission) {
+                this->overload->handler_started(*admission);
+            }
+            try {
+                request_handler(req, co);
+            } catch (std::bad_alloc&) {
+                throw;
+            } catch (std::exception& e) {
+                STATICLIB_HTTPSERVER_LOG_ERROR(m_logger, "HTTP offloaded request handler: " << e.what());
+                this->server_error_handler(req, co, e.what());
+            }
+        });
+    });
+}
+
+uint32_t http_server::add_priority_lane(const std::string& name, uint32_t weight, uint32_t max_running) {
+    uint32_t idx = handler_lanes->add_lane(name, weight, max_running);
+    STATICLIB_HTTPSERVER_LOG_DEBUG(m_logger, "Added priority lane: [" << name << "], weight: [" << weight << "]");
+    return idx;
+}
+
+priority_lanes& http_server::get_priority_lanes() {
+    return *handler_lanes;
+}
+
+work_stealing_pool& http_server::get_worker_pool() {
+    return *worker_pool;
+}
+
+void http_server::set_worker_threads(uint32_t number_of_threads) {
+    worker_pool->set_num_threads(number_of_threads);
+    handler_lanes->set_max_running(number_of_threads);
+}
+
+void http_server::enable_overload_control(uint32_t limit_max, std::chrono::milliseconds target_delay,
+        std::chrono::milliseconds interval) {
+    overload.reset(new overload_controller(target_delay, interval));
+    route_limit_max = limit_max;
+    for (auto& en : route_limits) {
+        en.second = std::make_shared<adaptive_limit>(1, route_limit_max, interval);
+    }
+}
+
+overload_controller& http_server::get_overload_controller() {
+    if (!overload) throw httpserver_exception("Overload control is not enabled");
+    return *overload;
+}
+
+const adaptive_limit& http_server::get_route_limit(const std::string& method, const std::string& resource) {
+    auto it = route_limits.find(route_key(method, strip_trailing_slash(resource)));
+    if (route_limits.end() == it || !it->second) {
+        throw httpserver_exception("Concurrency limit not found, resource: [" + resource + "], method: [" + method + "]");
+    }
+    return *it->second;
+}
+
+void http_server::set_handler_deadline(const std::string& method, const std::string& resource,
+        std::chrono::milliseconds timeout) {
+    handler_deadlines[route_key(method, strip_trailing_slash(resource))] = timeout;
+}
+
 void http_server::set_bad_request_handler(request_handler_type handler) {
     bad_request_handler = std::move(handler);
 }
@@ -220,6 +415,18 @@ void http_server::set_error_handler(error_handler_type handler) {
     server_error_handler = std::move(handler);
 }
 
+void http_server::set_inflate_ratio_max(uint32_t ratio_max) {
+    inflate_ratio_max = ratio_max;
+}
+
+void http_server::set_pipeline_depth(uint32_t depth) {
+    this->pipeline_depth = (std::max)(depth, 1u);
+}
+
+void http_server::add_common_header(const std::string& name, const std::string& value) {
+    common_headers->get_headers().add_header(name, value);
+}
+
 void http_server::add_payload_handler(const std::string& method, const std::string& resource,
         payload_handler_creator_type payload_handler) {
     payloads_map_type& map = choose_map_by_method(method, get_payloads, post_payloads, put_payloads, 
@@ -239,12 +446,29 @@ void http_server::add_filter(const std::string& method, const std::string& resou
     map.emplace(std::move(clean_resource), std::move(filter));
 }
 
+std::shared_ptr<rate_limiter> http_server::add_rate_limit(const std::string& method, const std::string& resource,
+        double rate, double burst, rate_limit_key_type key) {
+    auto limiter = std::make_shared<rate_limiter>(rate, burst);
+    add_filter(method, resource, [limiter, key](http_request_ptr& request, tcp_connection_ptr& conn,
+            http_filter_chain& chain) {
+        std::string client = key ? key(*request) : request->get_remote_ip().to_string();
+        if (!limiter->try_acquire(client)) {
+            handle_too_many_requests(request, conn);
+            return;
+        }
+        chain.do_filter(request, conn);
+    });
+    return limiter;
+}
+
 void http_server::handle_connection(tcp_connection_ptr& conn) {
+    conn->set_common_headers(std::addressof(common_headers->get_headers()));
     http_request_reader::finished_handler_type fh = [this] (http_request_ptr request, 
             tcp_connection_ptr& conn, const asio::error_code& ec) {
         this->handle_request(request, conn, ec);
     };
     reader_ptr my_reader_ptr = http_request_reader::create(conn, std::move(fh));
+    my_reader_ptr->set_inflate_ratio_max(inflate_ratio_max);
     http_request_reader::headers_parsing_finished_handler_type hpfh = [this](http_request_ptr request,
             tcp_connection_ptr& conn, const asio::error_code& ec, tribool & rc) {
         this->handle_request_after_headers_parsed(request, conn, ec, rc);
@@ -253,9 +477,41 @@ void http_server::handle_connection(tcp_connection_ptr& conn) {
     my_reader_ptr->receive();
 }
 
+void http_server::before_starting() {
+    common_headers->start();
+    // pool stopped with the previous run, first run starts it on the first post
+    if (worker_pool->is_shut_down()) {
+        worker_pool->startup();
+    }
+}
+
+void http_server::after_stopping() {
+    common_headers->stop();
+    // connections are finished already, remaining work is drained
+    worker_pool->shutdown();
+}
+
 void http_server::handle_request_after_headers_parsed(http_request_ptr request,
         tcp_connection_ptr& conn, const asio::error_code& ec, tribool& rc) {
     if (ec || !rc) return;
+    auto& method = request->get_method();
+    std::string path{strip_trailing_slash(request->get_resource())};
+    if (overload) {
+        handlers_map_type& handlers = choose_map_by_method(method, get_handlers, post_handlers, put_handlers, 
+                delete_handlers, options_handlers);
+        auto handlers_it = find_submatch(handlers, path);
+        if (handlers.end() != handlers_it) {
+            auto limits_it = route_limits.find(route_key(method, handlers_it->first));
+            if (route_limits.end() != limits_it) {
+                request->set_admission(overload->admit(limits_it->second));
+                if (request->get_admission()->is_rejected()) {
+                    // skip the body, response is sent when parsing is finished
+                    rc = true;
+                    return;
+                }
+            }
+        }
+    }
     // http://stackoverflow.com/a/17390776/314015
     if ("100-continue" == request->get_header("Expect")) {
         http_message::write_buffers_type buf;
@@ -269,14 +525,12 @@ void http_server::handle_request_after_headers_parsed(http_request_ptr request,
             return;
         }
     }
-    auto& method = request->get_method();
     payloads_map_type& map = choose_map_by_method(method, get_payloads, post_payloads, put_payloads, 
             delete_payloads, options_payloads);
-    std::string path{strip_trailing_slash(request->get_resource())};
     auto it = find_submatch(map, path);
     if (map.end() != it) {
-        auto ha = it->second(request);
-        request->set_payload_handler(std::move(ha));
+        // encoded body is decoded by the request reader
+        request->set_payload_handler(it->second(request));
     } else {
         // let's not spam client about GET and DELETE unlikely payloads
         if (http_message::REQUEST_METHOD_GET != method && 
@@ -292,6 +546,12 @@ void http_server::handle_request_after_headers_parsed(http_request_ptr request,
 
 void http_server::handle_request(http_request_ptr request, tcp_connection_ptr& conn,
         const asio::error_code& ec) {
+    // handle following requests together with this one
+    if (!ec && request->is_valid() && pipeline_depth > 1 && conn->get_pipelined() && !request->get_pipeline() &&
+            !(request->get_admission() && request->get_admission()->is_rejected())) {
+        handle_pipelined_requests(request, conn);
+        return;
+    }
     // handle error
     if (ec || !request->is_valid()) {
         conn->set_lifecycle(tcp_connection::LIFECYCLE_CLOSE); // make sure it will get closed
@@ -313,6 +573,17 @@ void http_server::handle_request(http_request_ptr request, tcp_connection_ptr& c
         }
         return;
     }
+    overload_admission* admission = request->get_admission();
+    if (nullptr != admission) {
+        if (admission->is_rejected()) {
+            STATICLIB_HTTPSERVER_LOG_DEBUG(m_logger, "Request rejected by overload control: " << request->get_resource());
+            conn->set_lifecycle(tcp_connection::LIFECYCLE_CLOSE); // request body was not read
+            handle_overload(request, conn);
+            return;
+        }
+        // time spent reading the body is not a queue delay
+        admission->set_queued_since(std::chrono::steady_clock::now());
+    }
     // handle request
     STATICLIB_HTTPSERVER_LOG_DEBUG(m_logger, "Received a valid HTTP request");
     std::string path{strip_trailing_slash(request->get_resource())};
@@ -326,13 +597,25 @@ void http_server::handle_request(http_request_ptr request, tcp_connection_ptr& c
     auto handlers_it = find_submatch(map, path);
     if (map.end() != handlers_it) {
         request_handler_type& handler = handlers_it->second;
+        // deadline is armed before the filters, they are counted against it
+        if (!handler_deadlines.empty()) {
+            auto deadline_it = handler_deadlines.find(route_key(method, handlers_it->first));
+            if (handler_deadlines.end() != deadline_it) {
+                start_deadline(request, conn, deadline_it->second);
+            }
+        }
         try {
             STATICLIB_HTTPSERVER_LOG_DEBUG(m_logger, "Found request handler for HTTP resource: " << path);
             filter_map_type& filter_map = choose_map_by_method(method, get_filters, post_filters, 
                     put_filters, delete_filters, options_filters);
             std::vector<std::reference_wrapper<request_filter_type>> filters = find_submatch_filters(filter_map, path);
-            http_filter_chain fc{std::move(filters), handler};
-            fc.do_filter(request, conn);
+            // offloaded routes have a concurrency limit entry, their handlers already run in the worker pool
+            if (request->get_pipeline() && route_limits.end() == route_limits.find(route_key(method, handlers_it->first))) {
+                dispatch_pipelined(request, conn, std::make_shared<http_filter_chain>(std::move(filters), handler));
+            } else {
+                http_filter_chain fc{std::move(filters), handler};
+                fc.do_filter(request, conn);
+            }
         } catch (std::bad_alloc&) {
             // propagate memory errors (FATAL)
             throw;
@@ -347,5 +630,91 @@ void http_server::handle_request(http_request_ptr request, tcp_connection_ptr& c
     }    
 }
 
+void http_server::handle_pipelined_requests(http_request_ptr request, tcp_connection_ptr& conn) {
+    auto pipeline = std::make_shared<response_pipeline>();
+    request->set_pipeline(pipeline, pipeline->add_response(conn->get_keep_alive()));
+    std::vector<std::pair<http_request_ptr, asio::error_code>> batch;
+    batch.emplace_back(request, asio::error_code());
+    // only the requests that are already in the read buffer are parsed,
+    // the rest is read after the batch is finished
+    while (batch.size() < pipeline_depth && conn->get_pipelined()) {
+        const char* read_ptr = nullptr;
+        const char* read_end_ptr = nullptr;
+        conn->load_read_pos(read_ptr, read_end_ptr);
+        http_request_ptr next;
+        asio::error_code next_ec;
+        http_request_reader::finished_handler_type fh = [&next, &next_ec](http_request_ptr req,
+                tcp_connection_ptr&, const asio::error_code& ec) {
+            next = req;
+            next_ec = ec;
+        };
+        reader_ptr reader = http_request_reader::create(conn, std::move(fh));
+        reader->set_headers_parsed_callback([this](http_request_ptr req, tcp_connection_ptr& conn,
+                const asio::error_code& ec, tribool& rc) {
+            this->handle_request_after_headers_parsed(req, conn, ec, rc);
+        });
+        reader->set_buffered_only(true);
+        reader->set_inflate_ratio_max(inflate_ratio_max);
+        reader->receive();
+        if (asio::error::would_block == next_ec) {
+            // request is incomplete or has a body, it is read normally later
+            conn->save_read_pos(read_ptr, read_end_ptr);
+            conn->set_lifecycle(tcp_connection::LIFECYCLE_PIPELINED);
+            break;
+        }
+        next->set_pipeline(pipeline, pipeline->add_response(conn->get_keep_alive()));
+        batch.emplace_back(next, next_ec);
+        if (next_ec || !next->is_valid()) break;
+    }
+    if (1 == batch.size()) {
+        request->set_pipeline(nullptr, 0);
+        handle_request(request, conn, asio::error_code());
+        return;
+    }
+    STATICLIB_HTTPSERVER_LOG_DEBUG(m_logger, "Handling " << batch.size() << " pipelined requests");
+    // 'TCP_NODELAY' is enabled until the batch is finished
+    conn->set_response_pipeline(pipeline);
+    for (auto& en : batch) {
+        handle_request(en.first, conn, en.second);
+    }
+    // responses written by the handlers so far are sent together
+    pipeline->start(conn);
+}
+
+void http_server::dispatch_pipelined(http_request_ptr& request, tcp_connection_ptr& conn,
+        std::shared_ptr<http_filter_chain> chain) {
+    http_request_ptr req = request;
+    tcp_connection_ptr co = conn;
+    uint32_t lane = http_request::PRIORITY_LANE_UNSET != req->get_priority_lane() ?
+            req->get_priority_lane() : priority_lanes::DEFAULT_LANE;
+    this->handler_lanes->post(lane, [this, chain, req, co]() mutable {
+        if (req->is_cancelled()) {
+            // timeout response was sent while the request was queued
+            return;
+        }
+        try {
+            chain->do_filter(req, co);
+        } catch (std::bad_alloc&) {
+            throw;
+        } catch (std::exception& e) {
+            STATICLIB_HTTPSERVER_LOG_ERROR(m_logger, "HTTP pipelined request handler: " << e.what());
+            this->server_error_handler(req, co, e.what());
+        }
+    });
+}
+
+void http_server::start_deadline(http_request_ptr& request, tcp_connection_ptr& conn,
+        std::chrono::milliseconds timeout) {
+    auto deadline = std::make_shared<handler_deadline>(conn->get_io_service());
+    request->set_deadline(deadline);
+    http_request_ptr req = request;
+    tcp_connection_ptr co = conn;
+    // timer holds request and connection only until it expires or the response is started
+    deadline->start(timeout, [this, req, co]() mutable {
+        STATICLIB_HTTPSERVER_LOG_WARN(m_logger, "Handler deadline expired for resource: " << req->get_resource());
+        handle_gateway_timeout(req, co);
+    });
+}
+
 } // namespace
 }
@@ -0,0 +1,176 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   overload_controller.cpp
+ * Author: agent
+ *
+ * Created on October 18, 2026, 9:39 PM
+ */
+
+#include "staticlib/httpserver/overload_controller.hpp"
+
+#include <algorithm>
+
+namespace staticlib {
+namespace httpserver {
+
+// adaptive_limit
+
+const double adaptive_limit::DECREASE_FACTOR = 0.5;
+
+adaptive_limit::adaptive_limit(uint32_t min_limit, uint32_t max_limit, std::chrono::steady_clock::duration backoff) :
+m_limit(max_limit),
+m_min_limit((std::max)(min_limit, 1u)),
+m_max_limit((std::max)(max_limit, m_min_limit)),
+m_in_flight(0),
+m_backoff(backoff) { }
+
+bool adaptive_limit::try_acquire() {
+    std::lock_guard<std::mutex> guard{m_mutex};
+    if (m_in_flight >= static_cast<uint32_t>(m_limit)) return false;
+    m_in_flight += 1;
+    return true;
+}
+
+void adaptive_limit::release() {
+    std::lock_guard<std::mutex> guard{m_mutex};
+    m_in_flight -= 1;
+}
+
+void adaptive_limit::add_sample(bool congested) {
+    std::lock_guard<std::mutex> guard{m_mutex};
+    if (congested) {
+        // requests admitted before the decrease report congestion too,
+        // they should not shrink the limit again
+        auto now = std::chrono::steady_clock::now();
+        if (now - m_last_decrease >= m_backoff) {
+            // limit may be far above the actual load, decrease from the load instead
+            double base = (std::min)(m_limit, static_cast<double>(m_in_flight));
+            m_limit = (std::max)(base * DECREASE_FACTOR, static_cast<double>(m_min_limit));
+            m_last_decrease = now;
+        }
+    } else if (2 * m_in_flight >= static_cast<uint32_t>(m_limit)) {
+        // limit is not increased while most of it is unused
+        m_limit = (std::min)(m_limit + 1.0 / m_limit, static_cast<double>(m_max_limit));
+    }
+}
+
+uint32_t adaptive_limit::get_limit() const {
+    std::lock_guard<std::mutex> guard{m_mutex};
+    return static_cast<uint32_t>(m_limit);
+}
+
+uint32_t adaptive_limit::get_in_flight() const {
+    std::lock_guard<std::mutex> guard{m_mutex};
+    return m_in_flight;
+}
+
+// overload_admission
+
+overload_admission::overload_admission(std::shared_ptr<adaptive_limit> limit) :
+m_limit(std::move(limit)),
+m_queued_since(std::chrono::steady_clock::now()) { }
+
+overload_admission::~overload_admission() STATICLIB_HTTPSERVER_NOEXCEPT {
+    if (m_limit) {
+        m_limit->release();
+    }
+}
+
+bool overload_admission::is_rejected() const {
+    return !m_limit;
+}
+
+void overload_admission::set_queued_since(std::chrono::steady_clock::time_point time) {
+    m_queued_since = time;
+}
+
+std::chrono::steady_clock::time_point overload_admission::get_queued_since() const {
+    return m_queued_since;
+}
+
+adaptive_limit* overload_admission::get_limit() const {
+    return m_limit.get();
+}
+
+// overload_controller
+
+const std::chrono::milliseconds overload_controller::DEFAULT_TARGET_DELAY = std::chrono::milliseconds(5);
+const std::chrono::milliseconds overload_controller::DEFAULT_INTERVAL = std::chrono::milliseconds(100);
+
+overload_controller::overload_controller(std::chrono::steady_clock::duration target_delay,
+        std::chrono::steady_clock::duration interval) :
+m_target(target_delay),
+m_interval(interval),
+m_interval_end(std::chrono::steady_clock::now() + interval),
+m_interval_min(std::chrono::steady_clock::duration::max()),
+m_has_samples(false),
+m_overloaded(false),
+m_rejected_count(0) { }
+
+std::shared_ptr<overload_admission> overload_controller::admit(const std::shared_ptr<adaptive_limit>& limit) {
+    if (is_overloaded() || !limit->try_acquire()) {
+        m_rejected_count.fetch_add(1, std::memory_order_relaxed);
+        return std::make_shared<overload_admission>(nullptr);
+    }
+    return std::make_shared<overload_admission>(limit);
+}
+
+void overload_controller::handler_started(const overload_admission& admission) {
+    auto now = std::chrono::steady_clock::now();
+    auto delay = now - admission.get_queued_since();
+    {
+        std::lock_guard<std::mutex> guard{m_mutex};
+        roll_interval(now);
+        m_interval_min = (std::min)(m_interval_min, delay);
+        m_has_samples = true;
+    }
+    adaptive_limit* limit = admission.get_limit();
+    if (nullptr != limit) {
+        limit->add_sample(delay > m_target);
+    }
+}
+
+bool overload_controller::is_overloaded() {
+    std::lock_guard<std::mutex> guard{m_mutex};
+    roll_interval(std::chrono::steady_clock::now());
+    return m_overloaded;
+}
+
+std::chrono::steady_clock::duration overload_controller::get_target_delay() const {
+    return m_target;
+}
+
+std::chrono::steady_clock::duration overload_controller::get_interval() const {
+    return m_interval;
+}
+
+uint64_t overload_controller::get_rejected_count() const {
+    return m_rejected_count.load(std::memory_order_relaxed);
+}
+
+void overload_controller::roll_interval(std::chrono::steady_clock::time_point now) {
+    if (now < m_interval_end) return;
+    // interval without samples means that nothing waits in the queue
+    m_overloaded = m_has_samples && m_interval_min > m_target;
+    m_has_samples = false;
+    m_interval_min = std::chrono::steady_clock::duration::max();
+    m_interval_end = now + m_interval;
+}
+
+} // namespace
+}
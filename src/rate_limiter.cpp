@@ -0,0 +1,159 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   rate_limiter.cpp
+ * Author: agent
+ *
+ * Created on October 18, 2026, 9:50 PM
+ */
+
+#include "staticlib/httpserver/rate_limiter.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+namespace staticlib {
+namespace httpserver {
+
+const std::size_t rate_limiter::STRIPES_COUNT = 64;
+
+namespace { // anonymous
+
+// buckets are not swept until the shard grows to this size
+const std::size_t SWEEP_SIZE_MIN = 1024;
+
+struct bucket {
+    double tokens;
+    std::chrono::steady_clock::time_point updated;
+};
+
+} // namespace
+
+class rate_limiter::stripe {
+public:
+    std::mutex mutex;
+    std::unordered_map<std::string, bucket> buckets;
+    std::size_t sweep_size = SWEEP_SIZE_MIN;
+};
+
+rate_limiter::rate_limiter(double rate, double burst) :
+m_rate(rate),
+m_burst(burst) {
+    for (std::size_t i = 0; i < STRIPES_COUNT; i++) {
+        m_stripes.emplace_back(new stripe());
+    }
+}
+
+rate_limiter::~rate_limiter() STATICLIB_HTTPSERVER_NOEXCEPT { }
+
+bool rate_limiter::try_acquire(const std::string& key, double tokens) {
+    stripe& st = choose_stripe(key);
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> guard{st.mutex};
+    auto it = st.buckets.find(key);
+    if (st.buckets.end() == it) {
+        if (st.buckets.size() >= st.sweep_size) {
+            // full buckets are equal to the missing ones, sweep cost
+            // is amortized by the doubling of the sweep threshold
+            for (auto bit = st.buckets.begin(); bit != st.buckets.end();) {
+                double secs = std::chrono::duration<double>(now - bit->second.updated).count();
+                if (bit->second.tokens + secs * m_rate >= m_burst) {
+                    bit = st.buckets.erase(bit);
+                } else {
+                    ++bit;
+                }
+            }
+            st.sweep_size = (std::max)(SWEEP_SIZE_MIN, st.buckets.size() * 2);
+        }
+        it = st.buckets.emplace(key, bucket{m_burst, now}).first;
+    } else {
+        double secs = std::chrono::duration<double>(now - it->second.updated).count();
+        it->second.tokens = (std::min)(it->second.tokens + secs * m_rate, m_burst);
+        it->second.updated = now;
+    }
+    if (it->second.tokens < tokens) return false;
+    it->second.tokens -= tokens;
+    return true;
+}
+
+std::size_t rate_limiter::get_keys_count() const {
+    std::size_t res = 0;
+    for (auto& st : m_stripes) {
+        std::lock_guard<std::mutex> guard{st->mutex};
+        res += st->buckets.size();
+    }
+    return res;
+}
+
+rate_limiter::stripe& rate_limiter::choose_stripe(const std::string& key) const {
+    return *m_stripes[std::hash<std::string>()(key) % m_stripes.size()];
+}
+
+class connection_limiter::stripe {
+public:
+    std::mutex mutex;
+    std::unordered_map<std::string, uint32_t> counts;
+};
+
+connection_limiter::connection_limiter(uint32_t max_per_key) :
+m_max_per_key(max_per_key) {
+    for (std::size_t i = 0; i < rate_limiter::STRIPES_COUNT; i++) {
+        m_stripes.emplace_back(new stripe());
+    }
+}
+
+connection_limiter::~connection_limiter() STATICLIB_HTTPSERVER_NOEXCEPT { }
+
+bool connection_limiter::try_acquire(const std::string& key) {
+    stripe& st = choose_stripe(key);
+    std::lock_guard<std::mutex> guard{st.mutex};
+    uint32_t& count = st.counts[key];
+    if (count >= m_max_per_key) {
+        if (0 == count) st.counts.erase(key);
+        return false;
+    }
+    count += 1;
+    return true;
+}
+
+void connection_limiter::release(const std::string& key) {
+    stripe& st = choose_stripe(key);
+    std::lock_guard<std::mutex> guard{st.mutex};
+    auto it = st.counts.find(key);
+    if (st.counts.end() == it) return;
+    it->second -= 1;
+    if (0 == it->second) {
+        st.counts.erase(it);
+    }
+}
+
+uint32_t connection_limiter::get_count(const std::string& key) const {
+    stripe& st = choose_stripe(key);
+    std::lock_guard<std::mutex> guard{st.mutex};
+    auto it = st.counts.find(key);
+    return st.counts.end() != it ? it->second : 0;
+}
+
+connection_limiter::stripe& connection_limiter::choose_stripe(const std::string& key) const {
+    return *m_stripes[std::hash<std::string>()(key) % m_stripes.size()];
+}
+
+} // namespace
+}
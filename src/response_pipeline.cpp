@@ -0,0 +1,180 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   response_pipeline.cpp
+ * Author: agent
+ *
+ * Created on October 18, 2026, 11:31 PM
+ */
+
+#include "staticlib/httpserver/response_pipeline.hpp"
+
+#include <deque>
+
+namespace staticlib {
+namespace httpserver {
+
+class response_pipeline::entry {
+public:
+    std::vector<asio::const_buffer> buffers;
+    std::size_t length = 0;
+    tcp_connection::io_handler_type handler;
+    operation_type operation;
+    bool last = false;
+};
+
+class response_pipeline::slot {
+public:
+    std::deque<entry> entries;
+    bool keep_alive = true;
+    // no more writes are expected
+    bool closed = false;
+};
+
+response_pipeline::response_pipeline() :
+m_write_head(0),
+m_finished_count(0),
+m_started(false),
+m_writing(false) { }
+
+response_pipeline::~response_pipeline() STATICLIB_HTTPSERVER_NOEXCEPT { }
+
+std::size_t response_pipeline::add_response(bool keep_alive) {
+    std::lock_guard<std::mutex> guard{m_mutex};
+    m_slots.emplace_back(new slot());
+    m_slots.back()->keep_alive = keep_alive;
+    return m_slots.size() - 1;
+}
+
+std::size_t response_pipeline::get_size() {
+    std::lock_guard<std::mutex> guard{m_mutex};
+    return m_slots.size();
+}
+
+bool response_pipeline::get_keep_alive(std::size_t idx) {
+    std::lock_guard<std::mutex> guard{m_mutex};
+    return m_slots[idx]->keep_alive;
+}
+
+void response_pipeline::start(tcp_connection_ptr& conn) {
+    {
+        std::lock_guard<std::mutex> guard{m_mutex};
+        m_started = true;
+    }
+    flush(conn);
+}
+
+void response_pipeline::async_write(tcp_connection_ptr& conn, std::size_t idx,
+        const std::vector<asio::const_buffer>& buffers, bool last, tcp_connection::io_handler_type handler) {
+    entry en;
+    en.buffers = buffers;
+    en.length = asio::buffer_size(buffers);
+    en.handler = std::move(handler);
+    en.last = last;
+    enqueue(conn, idx, std::move(en));
+}
+
+void response_pipeline::run(tcp_connection_ptr& conn, std::size_t idx, bool last, operation_type operation,
+        tcp_connection::io_handler_type handler) {
+    entry en;
+    en.operation = std::move(operation);
+    en.handler = std::move(handler);
+    en.last = last;
+    enqueue(conn, idx, std::move(en));
+}
+
+bool response_pipeline::finish_response(tcp_connection_ptr& conn) {
+    {
+        std::lock_guard<std::mutex> guard{m_mutex};
+        if (m_finished_count < m_slots.size()) {
+            m_slots[m_finished_count]->closed = true;
+        }
+        m_finished_count += 1;
+        if (m_finished_count >= m_slots.size()) return true;
+    }
+    // writes of the next response may be unblocked
+    flush(conn);
+    return false;
+}
+
+void response_pipeline::enqueue(tcp_connection_ptr& conn, std::size_t idx, entry en) {
+    {
+        std::lock_guard<std::mutex> guard{m_mutex};
+        m_slots[idx]->entries.emplace_back(std::move(en));
+        if (idx != m_write_head || !m_started || m_writing) return;
+    }
+    flush(conn);
+}
+
+void response_pipeline::flush(tcp_connection_ptr& conn) {
+    auto batch = std::make_shared<std::vector<entry>>();
+    {
+        std::lock_guard<std::mutex> guard{m_mutex};
+        if (!m_started || m_writing) return;
+        // takes writes in order until the response that is not written completely,
+        // operations are run alone
+        while (m_write_head < m_slots.size()) {
+            slot& sl = *m_slots[m_write_head];
+            while (!sl.entries.empty()) {
+                entry& en = sl.entries.front();
+                if (en.operation && !batch->empty()) break;
+                if (en.last) sl.closed = true;
+                batch->emplace_back(std::move(en));
+                sl.entries.pop_front();
+                if (batch->back().operation) break;
+            }
+            if (!sl.closed || !sl.entries.empty()) break;
+            m_write_head += 1;
+            if (!batch->empty() && batch->back().operation) break;
+        }
+        if (batch->empty()) return;
+        m_writing = true;
+    }
+    auto self = shared_from_this();
+    tcp_connection_ptr conn_holder = conn;
+    auto complete = [self, conn_holder, batch](const asio::error_code& ec, std::size_t bytes_written) mutable {
+        if (1 == batch->size()) {
+            batch->front().handler(ec, bytes_written);
+        } else {
+            for (entry& en : *batch) {
+                en.handler(ec, ec ? 0 : en.length);
+            }
+        }
+        {
+            std::lock_guard<std::mutex> guard{self->m_mutex};
+            self->m_writing = false;
+        }
+        self->flush(conn_holder);
+    };
+    if (batch->front().operation) {
+        operation_type op = std::move(batch->front().operation);
+        op(std::move(complete));
+        return;
+    }
+    std::vector<asio::const_buffer> gathered;
+    if (1 == batch->size()) {
+        gathered.swap(batch->front().buffers);
+    } else {
+        for (entry& en : *batch) {
+            gathered.insert(gathered.end(), en.buffers.begin(), en.buffers.end());
+        }
+    }
+    conn->async_write(gathered, std::move(complete));
+}
+
+} // namespace
+}
@@ -9,9 +9,18 @@
 
 #include "staticlib/httpserver/scheduler.hpp"
 
+#include <algorithm>
 #include <chrono>
+#include <deque>
 #include <cstdint>
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif // __linux__
+
+#include "staticlib/httpserver/httpserver_exception.hpp"
+
 namespace staticlib { 
 namespace httpserver {
 
@@ -26,7 +35,11 @@ scheduler::scheduler() :
 m_logger(STATICLIB_HTTPSERVER_GET_LOGGER("staticlib.httpserver.scheduler")),
 m_num_threads(DEFAULT_NUM_THREADS),
 m_active_users(0),
-m_is_running(false) { }
+m_is_running(false),
+m_busy_poll_interval(0),
+m_spin_nanos(0),
+m_block_nanos(0),
+m_blocks_count(0) { }
 
 scheduler::~scheduler() { }
 
@@ -100,6 +113,22 @@ logger scheduler::get_logger(void) {
     return m_logger;
 }
 
+void scheduler::set_busy_poll(std::chrono::microseconds spin_interval) {
+    m_busy_poll_interval = spin_interval;
+}
+
+void scheduler::set_cpu_affinity(std::vector<uint32_t> cpus) {
+    m_cpu_affinity = std::move(cpus);
+}
+
+scheduler::busy_poll_stats scheduler::get_busy_poll_stats() const {
+    busy_poll_stats stats = busy_poll_stats();
+    stats.spin_micros = m_spin_nanos.load(std::memory_order_relaxed) / 1000;
+    stats.block_micros = m_block_nanos.load(std::memory_order_relaxed) / 1000;
+    stats.blocks_count = m_blocks_count.load(std::memory_order_relaxed);
+    return stats;
+}
+
 void scheduler::post(std::function<void()> work_func) {
     get_io_service().post(work_func);
 }
@@ -135,7 +164,11 @@ void scheduler::sleep(uint32_t sleep_sec, uint32_t sleep_nsec) {
 void scheduler::process_service_work(asio::io_service& service) {
     while (m_is_running) {
         try {
-            service.run();
+            if (m_busy_poll_interval.count() > 0) {
+                busy_poll(service);
+            } else {
+                service.run();
+            }
         } catch (std::exception& e) {
             (void) e;
             STATICLIB_HTTPSERVER_LOG_ERROR(m_logger, e.what());
@@ -145,6 +178,51 @@ void scheduler::process_service_work(asio::io_service& service) {
     }   
 }
 
+void scheduler::pin_current_thread(uint32_t thread_idx) {
+    if (m_cpu_affinity.empty()) return;
+    uint32_t cpu = m_cpu_affinity[thread_idx % m_cpu_affinity.size()];
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(std::addressof(set));
+    CPU_SET(cpu, std::addressof(set));
+    int err = ::pthread_setaffinity_np(::pthread_self(), sizeof(set), std::addressof(set));
+    if (0 != err) {
+        STATICLIB_HTTPSERVER_LOG_WARN(m_logger, "Cannot pin IO thread to CPU: [" << cpu << "], error: [" << err << "]");
+    }
+#else
+    STATICLIB_HTTPSERVER_LOG_WARN(m_logger, "Pinning IO threads is not supported, CPU: [" << cpu << "]");
+#endif // __linux__
+}
+
+void scheduler::busy_poll(asio::io_service& service) {
+    auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(m_busy_poll_interval);
+    // counters are published when the thread blocks, not on every poll
+    std::chrono::steady_clock::duration spin{0};
+    auto idle_since = std::chrono::steady_clock::now();
+    while (!service.stopped()) {
+        auto poll_start = std::chrono::steady_clock::now();
+        if (service.poll() > 0) {
+            spin += poll_start - idle_since;
+            idle_since = std::chrono::steady_clock::now();
+            continue;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (now - idle_since < interval) continue;
+        spin += now - idle_since;
+        m_spin_nanos.fetch_add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                spin).count()), std::memory_order_relaxed);
+        spin = std::chrono::steady_clock::duration(0);
+        // nothing to do for the whole interval, wait for the next handler
+        service.run_one();
+        idle_since = std::chrono::steady_clock::now();
+        m_block_nanos.fetch_add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                idle_since - now).count()), std::memory_order_relaxed);
+        m_blocks_count.fetch_add(1, std::memory_order_relaxed);
+    }
+    m_spin_nanos.fetch_add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            spin).count()), std::memory_order_relaxed);
+}
+
 void scheduler::stop_services() { }
 
 void scheduler::stop_threads() { }
@@ -208,7 +286,8 @@ void single_service_scheduler::startup() {
         
         // start multiple threads to handle async tasks
         for (uint32_t n = 0; n < m_num_threads; ++n) {
-            std::unique_ptr<std::thread> new_thread(new std::thread([this]() {
+            std::unique_ptr<std::thread> new_thread(new std::thread([this, n]() {
+                this->pin_current_thread(n);
                 this->process_service_work(this->m_service);
             }));
             m_thread_pool.emplace_back(std::move(new_thread));
@@ -224,5 +303,342 @@ void single_service_scheduler::finish_services() {
     m_service.reset();
 }
 
+// work_stealing_pool member functions
+
+namespace { // anonymous
+
+// pool and worker index of the current thread, used to push
+// tasks posted from the worker thread into its own deque
+thread_local work_stealing_pool* current_pool = nullptr;
+thread_local std::size_t current_worker = 0;
+
+} // namespace
+
+class work_stealing_pool::worker {
+    std::mutex m_mutex;
+    // tasks posted by the owner
+    std::deque<std::function<void()>> m_local;
+    // tasks posted from other threads
+    std::deque<std::function<void()>> m_external;
+
+public:
+    void push_local(std::function<void()>&& task) {
+        std::lock_guard<std::mutex> guard{m_mutex};
+        m_local.emplace_back(std::move(task));
+    }
+
+    void push_external(std::function<void()>&& task) {
+        std::lock_guard<std::mutex> guard{m_mutex};
+        m_external.emplace_back(std::move(task));
+    }
+
+    // owner takes the newest of its own tasks, its data is most likely
+    // still in cache, tasks posted from outside are taken in FIFO order,
+    // so the oldest request is not starved
+    bool pop(std::function<void()>& task) {
+        std::lock_guard<std::mutex> guard{m_mutex};
+        if (!m_local.empty()) {
+            task = std::move(m_local.back());
+            m_local.pop_back();
+            return true;
+        }
+        return take_front(m_external, task);
+    }
+
+    // thieves take the oldest task
+    bool steal(std::function<void()>& task) {
+        std::lock_guard<std::mutex> guard{m_mutex};
+        return take_front(m_external, task) || take_front(m_local, task);
+    }
+
+private:
+    static bool take_front(std::deque<std::function<void()>>& tasks, std::function<void()>& task) {
+        if (tasks.empty()) return false;
+        task = std::move(tasks.front());
+        tasks.pop_front();
+        return true;
+    }
+};
+
+work_stealing_pool::work_stealing_pool(uint32_t num_threads) :
+m_logger(STATICLIB_HTTPSERVER_GET_LOGGER("staticlib.httpserver.work_stealing_pool")),
+m_num_threads(num_threads),
+m_pending(0),
+m_sleeping(0),
+m_next_worker(0),
+m_is_running(false),
+m_is_shut_down(false) { }
+
+work_stealing_pool::~work_stealing_pool() {
+    shutdown();
+}
+
+void work_stealing_pool::startup() {
+    std::lock_guard<std::mutex> guard{m_mutex};
+    if (m_is_running) return;
+    // workers are created once, tasks posted from outside read
+    // the vector without locking, deques are kept between restarts
+    if (m_workers.empty()) {
+        uint32_t count = m_num_threads;
+        if (0 == count) {
+            count = (std::max)(std::thread::hardware_concurrency(), 1u);
+        }
+        for (uint32_t i = 0; i < count; ++i) {
+            m_workers.emplace_back(new worker());
+        }
+    }
+    std::size_t count = m_workers.size();
+    STATICLIB_HTTPSERVER_LOG_INFO(m_logger, "Starting worker pool with " << count << " threads");
+    m_is_shut_down = false;
+    m_is_running = true;
+    for (std::size_t i = 0; i < count; ++i) {
+        m_threads.emplace_back([this, i] {
+            this->run(i);
+        });
+    }
+}
+
+void work_stealing_pool::shutdown() {
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard<std::mutex> guard{m_mutex};
+        if (!m_is_running) return;
+        STATICLIB_HTTPSERVER_LOG_INFO(m_logger, "Shutting down worker pool");
+        m_is_running = false;
+        m_is_shut_down = true;
+        threads = std::move(m_threads);
+        m_threads.clear();
+    }
+    m_work_available.notify_all();
+    auto current_id = std::this_thread::get_id();
+    for (auto& th : threads) {
+        if (th.get_id() != current_id) {
+            th.join();
+        } else {
+            // shutdown is called from the task itself
+            th.detach();
+        }
+    }
+    STATICLIB_HTTPSERVER_LOG_INFO(m_logger, "Worker pool has shutdown");
+}
+
+bool work_stealing_pool::is_running() const {
+    return m_is_running;
+}
+
+bool work_stealing_pool::is_shut_down() const {
+    return m_is_shut_down;
+}
+
+void work_stealing_pool::set_num_threads(const uint32_t n) {
+    m_num_threads = n;
+}
+
+uint32_t work_stealing_pool::get_num_threads() const {
+    return m_num_threads;
+}
+
+void work_stealing_pool::post(std::function<void()> work_func) {
+    if (this == current_pool) {
+        // pool may be draining, task will be run before the worker exits
+        m_workers[current_worker]->push_local(std::move(work_func));
+    } else {
+        if (!m_is_running) {
+            if (m_is_shut_down) {
+                throw httpserver_exception("Worker pool is shut down");
+            }
+            startup();
+        }
+        std::size_t idx = m_next_worker.fetch_add(1, std::memory_order_relaxed) % m_workers.size();
+        m_workers[idx]->push_external(std::move(work_func));
+    }
+    m_pending.fetch_add(1);
+    // paired with the increment of sleeping counter done by the worker
+    // before checking pending counter, one of them sees the other
+    if (m_sleeping.load() > 0) {
+        std::lock_guard<std::mutex> guard{m_mutex};
+        m_work_available.notify_one();
+    }
+}
+
+void work_stealing_pool::run(std::size_t idx) {
+    current_pool = this;
+    current_worker = idx;
+    std::function<void()> task;
+    for (;;) {
+        if (take_task(idx, task)) {
+            m_pending.fetch_sub(1);
+            try {
+                task();
+            } catch (std::exception& e) {
+                STATICLIB_HTTPSERVER_LOG_ERROR(m_logger, e.what());
+            } catch (...) {
+                STATICLIB_HTTPSERVER_LOG_ERROR(m_logger, "caught unrecognized exception");
+            }
+            task = nullptr;
+            continue;
+        }
+        std::unique_lock<std::mutex> guard{m_mutex};
+        m_sleeping.fetch_add(1);
+        // remaining tasks are finished before the worker exits
+        m_work_available.wait(guard, [this] {
+            return !m_is_running || m_pending.load() > 0;
+        });
+        m_sleeping.fetch_sub(1);
+        if (!m_is_running && 0 == m_pending.load()) break;
+    }
+    current_pool = nullptr;
+}
+
+bool work_stealing_pool::take_task(std::size_t idx, std::function<void()>& task) {
+    if (m_workers[idx]->pop(task)) return true;
+    std::size_t count = m_workers.size();
+    for (std::size_t i = 1; i < count; ++i) {
+        if (m_workers[(idx + i) % count]->steal(task)) return true;
+    }
+    return false;
+}
+
+// priority_lanes member functions
+
+const uint32_t priority_lanes::DEFAULT_LANE = 0;
+
+namespace { // anonymous
+
+// virtual time added to the lane tag when the task with weight 1 is dispatched
+const uint64_t VIRTUAL_TIME_UNIT = 1 << 20;
+
+} // namespace
+
+class priority_lanes::lane {
+public:
+    std::string name;
+    uint32_t weight;
+    uint32_t max_running;
+    std::deque<std::pair<std::function<void()>, std::chrono::steady_clock::time_point>> queue;
+    uint32_t running = 0;
+    uint64_t dispatched = 0;
+    uint64_t queue_time_total_micros = 0;
+    uint64_t queue_time_max_micros = 0;
+    // virtual time at which the next task of this lane is due
+    uint64_t tag = 0;
+
+    lane(const std::string& name, uint32_t weight, uint32_t max_running) :
+    name(name),
+    weight(weight),
+    max_running(max_running) { }
+
+    bool is_ready() const {
+        return !queue.empty() && (0 == max_running || running < max_running);
+    }
+};
+
+priority_lanes::priority_lanes(executor_type executor, uint32_t max_running) :
+m_executor(std::move(executor)),
+m_max_running(max_running),
+m_running(0),
+m_virtual_time(0) {
+    m_lanes.emplace_back(new lane("default", 1, 0));
+}
+
+priority_lanes::~priority_lanes() { }
+
+uint32_t priority_lanes::add_lane(const std::string& name, uint32_t weight, uint32_t max_running) {
+    if (0 == weight) throw httpserver_exception("Invalid zero weight for priority lane: [" + name + "]");
+    std::lock_guard<std::mutex> guard{m_mutex};
+    m_lanes.emplace_back(new lane(name, weight, max_running));
+    return static_cast<uint32_t>(m_lanes.size() - 1);
+}
+
+void priority_lanes::set_max_running(uint32_t max_running) {
+    std::unique_lock<std::mutex> lock{m_mutex};
+    m_max_running = max_running;
+    dispatch(lock);
+}
+
+std::size_t priority_lanes::get_lanes_count() const {
+    std::lock_guard<std::mutex> guard{m_mutex};
+    return m_lanes.size();
+}
+
+priority_lanes::lane_stats priority_lanes::get_stats(uint32_t lane_idx) const {
+    std::lock_guard<std::mutex> guard{m_mutex};
+    if (lane_idx >= m_lanes.size()) throw httpserver_exception("Invalid priority lane: [" + std::to_string(lane_idx) + "]");
+    const lane& la = *m_lanes[lane_idx];
+    lane_stats res;
+    res.name = la.name;
+    res.weight = la.weight;
+    res.max_running = la.max_running;
+    res.queued = la.queue.size();
+    res.running = la.running;
+    res.dispatched = la.dispatched;
+    res.queue_time_total_micros = la.queue_time_total_micros;
+    res.queue_time_max_micros = la.queue_time_max_micros;
+    return res;
+}
+
+void priority_lanes::post(uint32_t lane_idx, std::function<void()> work_func) {
+    std::unique_lock<std::mutex> lock{m_mutex};
+    if (lane_idx >= m_lanes.size()) throw httpserver_exception("Invalid priority lane: [" + std::to_string(lane_idx) + "]");
+    lane& la = *m_lanes[lane_idx];
+    // idle lane does not accumulate credit
+    if (la.queue.empty()) {
+        la.tag = (std::max)(la.tag, m_virtual_time);
+    }
+    la.queue.emplace_back(std::move(work_func), std::chrono::steady_clock::now());
+    dispatch(lock);
+}
+
+void priority_lanes::dispatch(std::unique_lock<std::mutex>& lock) {
+    while (0 == m_max_running || m_running < m_max_running) {
+        // ready lane with the earliest tag, earlier lanes win ties
+        std::size_t idx = m_lanes.size();
+        for (std::size_t i = 0; i < m_lanes.size(); ++i) {
+            if (m_lanes[i]->is_ready() && (m_lanes.size() == idx || m_lanes[i]->tag < m_lanes[idx]->tag)) {
+                idx = i;
+            }
+        }
+        if (m_lanes.size() == idx) break;
+        lane& la = *m_lanes[idx];
+        std::function<void()> task = std::move(la.queue.front().first);
+        auto waited = std::chrono::steady_clock::now() - la.queue.front().second;
+        la.queue.pop_front();
+        uint64_t micros = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(waited).count());
+        la.queue_time_total_micros += micros;
+        la.queue_time_max_micros = (std::max)(la.queue_time_max_micros, micros);
+        la.dispatched += 1;
+        la.running += 1;
+        m_running += 1;
+        m_virtual_time = la.tag;
+        la.tag += VIRTUAL_TIME_UNIT / la.weight;
+        lock.unlock();
+        try {
+            m_executor([this, idx, task] {
+                try {
+                    task();
+                } catch (...) {
+                    this->finished(idx);
+                    throw;
+                }
+                this->finished(idx);
+            });
+        } catch (...) {
+            // work rejected by the executor is dropped, its slot is released
+            lock.lock();
+            la.running -= 1;
+            m_running -= 1;
+            throw;
+        }
+        lock.lock();
+    }
+}
+
+void priority_lanes::finished(std::size_t lane_idx) {
+    std::unique_lock<std::mutex> lock{m_mutex};
+    m_lanes[lane_idx]->running -= 1;
+    m_running -= 1;
+    dispatch(lock);
+}
+
 } // namespace
 }
@@ -16,6 +16,26 @@
 
 #include "staticlib/httpserver/tcp_connection.hpp"
 
+#include <algorithm>
+
+#include <vector>
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif // _WIN32
+#ifdef __linux__
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#endif // __linux__
+
 #include "asio.hpp"
 #ifdef STATICLIB_HTTPSERVER_HAVE_SSL
 #ifdef STATICLIB_HTTPSERVER_XCODE
@@ -25,9 +45,142 @@
 #include "asio/ssl.hpp"
 #endif
 
+#include "staticlib/httpserver/response_pipeline.hpp"
+#include "staticlib/httpserver/uring_transport.hpp"
+
 namespace staticlib {
 namespace httpserver {
 
+tcp_connection::task tcp_connection::TASKS_RUNNING;
+
+namespace { // anonymous
+
+const std::size_t FILE_READ_BLOCK_SIZE = 65536;
+
+const std::size_t TASK_BLOCK_SIZE = 128;
+
+/**
+ * State of the file region write operation
+ */
+class file_write_op : public std::enable_shared_from_this<file_write_op> {
+    tcp_connection_ptr m_conn;
+    int m_fd;
+    uint64_t m_offset;
+    std::size_t m_remaining;
+    std::size_t m_written;
+    tcp_connection::io_handler_type m_handler;
+    std::vector<char> m_block;
+
+public:
+    file_write_op(tcp_connection_ptr conn, int fd, uint64_t offset, std::size_t length,
+            tcp_connection::io_handler_type handler) :
+    m_conn(std::move(conn)),
+    m_fd(fd),
+    m_offset(offset),
+    m_remaining(length),
+    m_written(0),
+    m_handler(std::move(handler)) { }
+
+    void start() {
+        if (m_conn->is_splice_supported()) {
+            // asio switches the socket to non-blocking mode only when it starts a reactor
+            // operation, speculative reads and writes may skip it and sendfile must not block
+            asio::error_code ec;
+            m_conn->get_socket().native_non_blocking(true, ec);
+            if (ec) {
+                complete(ec);
+                return;
+            }
+            send_file();
+        } else {
+            m_block.resize((std::min)(m_remaining, FILE_READ_BLOCK_SIZE));
+            read_block();
+        }
+    }
+
+private:
+    void complete(const asio::error_code& ec) {
+        // never call handler from inside the initiating function
+        auto self = shared_from_this();
+        m_conn->get_io_service().post([self, ec] {
+            self->m_handler(ec, self->m_written);
+        });
+    }
+
+    asio::error_code last_error() {
+        return asio::error_code(errno, asio::error::get_system_category());
+    }
+
+    void send_file() {
+#ifdef __linux__
+        int sock = m_conn->get_socket().native_handle();
+        while (m_remaining > 0) {
+            off_t off = static_cast<off_t>(m_offset);
+            ssize_t sent = ::sendfile(sock, m_fd, &off, m_remaining);
+            if (sent > 0) {
+                m_offset += static_cast<uint64_t>(sent);
+                m_remaining -= static_cast<std::size_t>(sent);
+                m_written += static_cast<std::size_t>(sent);
+            } else if (0 == sent) {
+                // file is shorter than expected
+                complete(asio::error::eof);
+                return;
+            } else if (EAGAIN == errno) {
+                // wait until socket becomes writable
+                auto self = shared_from_this();
+                m_conn->get_socket().async_write_some(asio::null_buffers(), [self](
+                        const asio::error_code& ec, std::size_t) {
+                    if (ec) {
+                        self->complete(ec);
+                    } else {
+                        self->send_file();
+                    }
+                });
+                return;
+            } else if (EINTR != errno) {
+                complete(last_error());
+                return;
+            }
+        }
+#endif // __linux__
+        complete(asio::error_code());
+    }
+
+    void read_block() {
+        if (0 == m_remaining) {
+            complete(asio::error_code());
+            return;
+        }
+        std::size_t len = (std::min)(m_remaining, m_block.size());
+#ifdef _WIN32
+        int read = -1;
+        if (-1 != ::_lseeki64(m_fd, static_cast<__int64>(m_offset), SEEK_SET)) {
+            read = ::_read(m_fd, m_block.data(), static_cast<unsigned int>(len));
+        }
+#else
+        ssize_t read = ::pread(m_fd, m_block.data(), len, static_cast<off_t>(m_offset));
+#endif // _WIN32
+        if (read <= 0) {
+            complete(0 == read ? asio::error_code(asio::error::eof) : last_error());
+            return;
+        }
+        m_offset += static_cast<uint64_t>(read);
+        m_remaining -= static_cast<std::size_t>(read);
+        auto self = shared_from_this();
+        m_conn->async_write(asio::buffer(m_block.data(), static_cast<std::size_t>(read)), [self](
+                const asio::error_code& ec, std::size_t bytes_written) {
+            self->m_written += bytes_written;
+            if (ec) {
+                self->complete(ec);
+            } else {
+                self->read_block();
+            }
+        });
+    }
+};
+
+} // namespace
+
 std::shared_ptr<tcp_connection> tcp_connection::create(asio::io_service& io_service,
         ssl_context_type& ssl_context,
         const bool ssl_flag,
@@ -46,7 +199,19 @@ m_ssl_socket(io_service),
 m_ssl_flag(false),
 #endif
 m_lifecycle(LIFECYCLE_CLOSE),
-m_finished_handler(finished_handler) {
+m_finished_handler(finished_handler),
+m_splice_pipe({{-1, -1}}),
+m_splice_pipe_size(0),
+m_common_headers(nullptr),
+m_tasks_head(nullptr),
+m_tasks_list(nullptr),
+m_spare_task(nullptr),
+m_header_timeout(0),
+m_write_timeout(0),
+m_min_write_rate(0),
+m_header_deadline(0),
+m_write_deadline(0),
+m_no_delay(false) {
 #ifndef STATICLIB_HTTPSERVER_HAVE_SSL
     (void) ssl_context;
     (void) ssl_flag;
@@ -56,6 +221,28 @@ m_finished_handler(finished_handler) {
 
 tcp_connection::~tcp_connection() {
     close();
+    // tasks that were not run
+    task* head = m_tasks_head.load();
+    while (nullptr != head && std::addressof(TASKS_RUNNING) != head) {
+        task* next = head->next;
+        destroy_task(head);
+        head = next;
+    }
+    while (nullptr != m_tasks_list) {
+        task* next = m_tasks_list->next;
+        destroy_task(m_tasks_list);
+        m_tasks_list = next;
+    }
+    ::operator delete(m_spare_task.load());
+    if (m_connection_limiter) {
+        m_connection_limiter->release(m_connection_limiter_key);
+    }
+#ifdef __linux__
+    if (-1 != m_splice_pipe[0]) {
+        ::close(m_splice_pipe[0]);
+        ::close(m_splice_pipe[1]);
+    }
+#endif // __linux__
 }
 
 bool tcp_connection::is_open() const {
@@ -90,6 +277,9 @@ void tcp_connection::cancel() {
     asio::error_code ec;
     m_ssl_socket.next_layer().cancel(ec);
 #endif
+    if (m_uring && is_open()) {
+        m_uring->cancel(this);
+    }
 }
 
 std::size_t tcp_connection::read_some(asio::error_code& ec) {
@@ -101,8 +291,431 @@ std::size_t tcp_connection::read_some(asio::error_code& ec) {
         return m_ssl_socket.next_layer().read_some(asio::buffer(m_read_buffer), ec);
 }
 
+std::size_t tcp_connection::try_read_some(asio::error_code& ec) {
+#ifdef __linux__
+    if (!m_speculative_io || get_ssl_flag()) {
+        ec = asio::error::would_block;
+        return 0;
+    }
+    int sock = m_ssl_socket.next_layer().native_handle();
+    for (;;) {
+        ssize_t len = ::recv(sock, m_read_buffer.data(), m_read_buffer.size(), MSG_DONTWAIT);
+        if (len > 0) {
+            m_speculative_io->reads_completed.fetch_add(1, std::memory_order_relaxed);
+            return static_cast<std::size_t>(len);
+        }
+        if (0 == len) {
+            m_speculative_io->reads_completed.fetch_add(1, std::memory_order_relaxed);
+            ec = asio::error::eof;
+            return 0;
+        }
+        if (EINTR == errno) continue;
+        if (EAGAIN == errno || EWOULDBLOCK == errno) {
+            m_speculative_io->reads_would_block.fetch_add(1, std::memory_order_relaxed);
+            ec = asio::error::would_block;
+        } else {
+            m_speculative_io->reads_completed.fetch_add(1, std::memory_order_relaxed);
+            ec = asio::error_code(errno, asio::error::get_system_category());
+        }
+        return 0;
+    }
+#else
+    ec = asio::error::would_block;
+    return 0;
+#endif // __linux__
+}
+
+std::size_t tcp_connection::try_write_some(const asio::const_buffer* buffers, std::size_t count,
+        asio::error_code& ec) {
+#ifdef __linux__
+    std::array<struct iovec, SPECULATIVE_WRITE_BUFFERS_MAX> iov;
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < count; i++) {
+        iov[i].iov_base = const_cast<void*>(asio::buffer_cast<const void*>(buffers[i]));
+        iov[i].iov_len = asio::buffer_size(buffers[i]);
+        total += iov[i].iov_len;
+    }
+    struct msghdr msg;
+    std::memset(std::addressof(msg), 0, sizeof(msg));
+    msg.msg_iov = iov.data();
+    msg.msg_iovlen = count;
+    int sock = m_ssl_socket.next_layer().native_handle();
+    ssize_t len = 0;
+    do {
+        len = ::sendmsg(sock, std::addressof(msg), MSG_DONTWAIT | MSG_NOSIGNAL);
+    } while (len < 0 && EINTR == errno);
+    if (len < 0) {
+        if (EAGAIN == errno || EWOULDBLOCK == errno) {
+            m_speculative_io->writes_would_block.fetch_add(1, std::memory_order_relaxed);
+            ec = asio::error::would_block;
+        } else {
+            m_speculative_io->writes_completed.fetch_add(1, std::memory_order_relaxed);
+            ec = asio::error_code(errno, asio::error::get_system_category());
+        }
+        return 0;
+    }
+    std::size_t written = static_cast<std::size_t>(len);
+    if (written < total) {
+        m_speculative_io->writes_would_block.fetch_add(1, std::memory_order_relaxed);
+        ec = asio::error::would_block;
+    } else {
+        m_speculative_io->writes_completed.fetch_add(1, std::memory_order_relaxed);
+    }
+    return written;
+#else
+    (void) buffers;
+    (void) count;
+    ec = asio::error::would_block;
+    return 0;
+#endif // __linux__
+}
+
+std::size_t tcp_connection::copy_buffers(const asio::const_buffer& buffer, asio::const_buffer* dest,
+        std::size_t max_count) {
+    if (0 == max_count) return 0;
+    dest[0] = buffer;
+    return 1;
+}
+
+std::size_t tcp_connection::copy_buffers(const asio::mutable_buffer& buffer, asio::mutable_buffer* dest,
+        std::size_t max_count) {
+    if (0 == max_count) return 0;
+    dest[0] = buffer;
+    return 1;
+}
+
+void tcp_connection::set_speculative_io(std::shared_ptr<speculative_io_counters> counters) {
+    m_speculative_io = std::move(counters);
+}
+
+void tcp_connection::set_uring_transport(std::shared_ptr<uring_transport> transport) {
+    // socket is left in blocking mode, so the ring waits for readiness internally
+    // instead of failing with 'EAGAIN' and requiring a separate poll request
+    m_uring = std::move(transport);
+}
+
+void tcp_connection::uring_read_some(const asio::mutable_buffer* buffers, std::size_t count,
+        io_handler_type handler) {
+    m_uring->async_read_some(get_io_service(), this, m_ssl_socket.next_layer().native_handle(),
+            buffers, count, std::move(handler));
+}
+
+void tcp_connection::uring_write(const asio::const_buffer* buffers, std::size_t count,
+        io_handler_type handler) {
+    m_uring->async_write(get_io_service(), this, m_ssl_socket.next_layer().native_handle(),
+            buffers, count, std::move(handler));
+}
+
+bool tcp_connection::is_splice_supported() const {
+#ifdef __linux__
+    return !get_ssl_flag();
+#else
+    return false;
+#endif // __linux__
+}
+
+void tcp_connection::async_splice_some(int fd, std::size_t max_len, io_handler_type handler) {
+    asio::error_code ec;
+    std::size_t len = splice_some(fd, max_len, ec);
+    if (asio::error::would_block != ec) {
+        get_io_service().post([handler, ec, len] {
+            handler(ec, len);
+        });
+        return;
+    }
+    // wait until socket becomes readable
+    auto self = shared_from_this();
+    m_ssl_socket.next_layer().async_read_some(asio::null_buffers(), [self, fd, max_len, handler](
+            const asio::error_code& ec, std::size_t) {
+        if (ec) {
+            handler(ec, 0);
+            return;
+        }
+        asio::error_code sec;
+        std::size_t len = self->splice_some(fd, max_len, sec);
+        if (asio::error::would_block == sec) {
+            // spurious wakeup
+            self->async_splice_some(fd, max_len, handler);
+        } else {
+            handler(sec, len);
+        }
+    });
+}
+
+std::size_t tcp_connection::splice_some(int fd, std::size_t max_len, asio::error_code& ec) {
+#ifdef __linux__
+    if (!is_splice_supported()) {
+        ec = asio::error::operation_not_supported;
+        return 0;
+    }
+    if (-1 == m_splice_pipe[0]) {
+        // 'SPLICE_F_NONBLOCK' applies only to the pipe, speculative reads may leave
+        // the socket in blocking mode, and splice must not wait for a slow uploader
+        m_ssl_socket.next_layer().native_non_blocking(true, ec);
+        if (ec) return 0;
+        if (-1 == ::pipe2(m_splice_pipe.data(), O_CLOEXEC | O_NONBLOCK)) {
+            ec = asio::error_code(errno, asio::error::get_system_category());
+            return 0;
+        }
+        // larger pipe means fewer syscalls per megabyte, ignore failures
+        ::fcntl(m_splice_pipe[1], F_SETPIPE_SZ, 1 << 20);
+        int size = ::fcntl(m_splice_pipe[1], F_GETPIPE_SZ);
+        m_splice_pipe_size = size > 0 ? static_cast<std::size_t>(size) : 65536;
+    }
+    int sock = m_ssl_socket.next_layer().native_handle();
+    std::size_t total = 0;
+    while (total < max_len) {
+        std::size_t chunk = (std::min)(max_len - total, m_splice_pipe_size);
+        ssize_t in = ::splice(sock, nullptr, m_splice_pipe[1], nullptr, chunk, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (0 == in) {
+            if (0 == total) ec = asio::error::eof;
+            break;
+        }
+        if (in < 0) {
+            if (EINTR == errno) continue;
+            if (EAGAIN == errno) {
+                if (0 == total) ec = asio::error::would_block;
+            } else {
+                ec = asio::error_code(errno, asio::error::get_system_category());
+            }
+            break;
+        }
+        // drain the pipe into file
+        std::size_t in_pipe = static_cast<std::size_t>(in);
+        while (in_pipe > 0) {
+            ssize_t out = ::splice(m_splice_pipe[0], nullptr, fd, nullptr, in_pipe, SPLICE_F_MOVE);
+            if (out <= 0) {
+                if (out < 0 && EINTR == errno) continue;
+                ec = out < 0 ? asio::error_code(errno, asio::error::get_system_category()) :
+                        asio::error_code(asio::error::broken_pipe);
+                // pipe still holds body bytes that must not get into the next file
+                ::close(m_splice_pipe[0]);
+                ::close(m_splice_pipe[1]);
+                m_splice_pipe[0] = -1;
+                m_splice_pipe[1] = -1;
+                return total;
+            }
+            in_pipe -= static_cast<std::size_t>(out);
+        }
+        total += static_cast<std::size_t>(in);
+    }
+    return total;
+#else
+    (void) fd;
+    (void) max_len;
+    ec = asio::error::operation_not_supported;
+    return 0;
+#endif // __linux__
+}
+
+void tcp_connection::async_write_file(int fd, uint64_t offset, std::size_t length, io_handler_type handler) {
+    if (m_write_timeout.count() > 0 && start_write_deadline(length)) {
+        auto self = shared_from_this();
+        io_handler_type inner = std::move(handler);
+        handler = [self, inner](const asio::error_code& ec, std::size_t bytes_written) {
+            self->stop_write_deadline();
+            inner(ec, bytes_written);
+        };
+    }
+    auto op = std::make_shared<file_write_op>(shared_from_this(), fd, offset, length, std::move(handler));
+    op->start();
+}
+
+void tcp_connection::set_cork(bool enabled) {
+#ifdef __linux__
+    int val = enabled ? 1 : 0;
+    // failure only affects packet sizes
+    ::setsockopt(m_ssl_socket.lowest_layer().native_handle(), IPPROTO_TCP, TCP_CORK, &val, sizeof(val));
+#else
+    (void) enabled;
+#endif // __linux__
+}
+
+bool tcp_connection::set_busy_poll(std::chrono::microseconds interval) {
+#if defined(__linux__) && defined(SO_BUSY_POLL)
+    int val = static_cast<int>(interval.count());
+    return 0 == ::setsockopt(m_ssl_socket.lowest_layer().native_handle(), SOL_SOCKET, SO_BUSY_POLL, &val, sizeof(val));
+#else
+    (void) interval;
+    return false;
+#endif // __linux__
+}
+
+void tcp_connection::set_no_delay(bool enabled) {
+    m_no_delay = enabled;
+    apply_no_delay(enabled);
+}
+
+void tcp_connection::apply_no_delay(bool enabled) {
+    asio::error_code ec;
+    // failure only affects latency
+    m_ssl_socket.lowest_layer().set_option(asio::ip::tcp::no_delay(enabled), ec);
+}
+
+void* tcp_connection::allocate_task(std::size_t size) {
+    if (size <= TASK_BLOCK_SIZE) {
+        void* spare = m_spare_task.exchange(nullptr);
+        return nullptr != spare ? spare : ::operator new(TASK_BLOCK_SIZE);
+    }
+    return ::operator new(size);
+}
+
+void tcp_connection::deallocate_task(void* ptr, std::size_t size) {
+    void* empty = nullptr;
+    if (size > TASK_BLOCK_SIZE || !m_spare_task.compare_exchange_strong(empty, ptr)) {
+        ::operator delete(ptr);
+    }
+}
+
+void tcp_connection::destroy_task(task* t) {
+    std::size_t size = t->size;
+    t->~task();
+    deallocate_task(t, size);
+}
+
+void tcp_connection::push_task(task* t) {
+    task* head = m_tasks_head.load(std::memory_order_relaxed);
+    do {
+        t->next = std::addressof(TASKS_RUNNING) != head ? head : nullptr;
+    } while (!m_tasks_head.compare_exchange_weak(head, t, std::memory_order_release,
+            std::memory_order_relaxed));
+    if (nullptr == head) {
+        // no tasks were running
+        schedule_tasks();
+    }
+}
+
+void tcp_connection::schedule_tasks() {
+    auto self = shared_from_this();
+    get_io_service().post([self] {
+        self->run_tasks();
+    });
+}
+
+void tcp_connection::run_tasks() {
+    task* running = std::addressof(TASKS_RUNNING);
+    for (;;) {
+        while (nullptr != m_tasks_list) {
+            task* t = m_tasks_list;
+            m_tasks_list = t->next;
+            try {
+                t->run();
+            } catch (...) {
+                destroy_task(t);
+                // remaining tasks are run after the error is reported
+                schedule_tasks();
+                throw;
+            }
+            destroy_task(t);
+        }
+        task* head = m_tasks_head.exchange(running, std::memory_order_acquire);
+        if (running == head) {
+            // nothing was posted, release the tasks unless a task is being pushed right now
+            if (m_tasks_head.compare_exchange_strong(head, nullptr)) return;
+            continue;
+        }
+        // stack is in reverse order
+        while (nullptr != head) {
+            task* next = head->next;
+            head->next = m_tasks_list;
+            m_tasks_list = head;
+            head = next;
+        }
+    }
+}
+
+void tcp_connection::set_common_headers(const http_common_headers* common_headers) {
+    m_common_headers = common_headers;
+}
+
+const http_common_headers* tcp_connection::get_common_headers() const {
+    return m_common_headers;
+}
+
+void tcp_connection::set_connection_limiter(std::shared_ptr<connection_limiter> limiter, std::string key) {
+    m_connection_limiter = std::move(limiter);
+    m_connection_limiter_key = std::move(key);
+}
+
+void tcp_connection::set_slow_client_limits(std::chrono::steady_clock::duration header_timeout,
+        std::chrono::steady_clock::duration write_timeout, uint32_t min_write_rate) {
+    m_header_timeout = header_timeout;
+    m_write_timeout = write_timeout;
+    m_min_write_rate = min_write_rate;
+}
+
+void tcp_connection::start_header_deadline() {
+    if (m_header_timeout.count() > 0) {
+        auto deadline = std::chrono::steady_clock::now() + m_header_timeout;
+        std::chrono::steady_clock::rep idle = 0;
+        m_header_deadline.compare_exchange_strong(idle, deadline.time_since_epoch().count());
+    }
+}
+
+void tcp_connection::stop_header_deadline() {
+    m_header_deadline.store(0, std::memory_order_relaxed);
+}
+
+tcp_connection::deadline_type tcp_connection::expire_deadline(std::chrono::steady_clock::time_point now) {
+    auto ticks = now.time_since_epoch().count();
+    // exchange makes sure the violation is reported once
+    auto header = m_header_deadline.load(std::memory_order_relaxed);
+    if (0 != header && header <= ticks && m_header_deadline.compare_exchange_strong(header, 0)) {
+        return DEADLINE_HEADERS;
+    }
+    auto write = m_write_deadline.load(std::memory_order_relaxed);
+    if (0 != write && write <= ticks && m_write_deadline.compare_exchange_strong(write, 0)) {
+        return DEADLINE_WRITE;
+    }
+    return DEADLINE_NONE;
+}
+
+void tcp_connection::abort() {
+    asio::error_code ec;
+    m_ssl_socket.next_layer().shutdown(asio::ip::tcp::socket::shutdown_both, ec);
+}
+
+bool tcp_connection::start_write_deadline(std::size_t length) {
+    auto timeout = m_write_timeout;
+    if (m_min_write_rate > 0) {
+        timeout += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(static_cast<double>(length) / m_min_write_rate));
+    }
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    std::chrono::steady_clock::rep idle = 0;
+    return m_write_deadline.compare_exchange_strong(idle, deadline.time_since_epoch().count());
+}
+
+void tcp_connection::stop_write_deadline() {
+    m_write_deadline.store(0, std::memory_order_relaxed);
+}
+
+#ifdef STATICLIB_HTTPSERVER_HAVE_ZLIB
+http_inflater& tcp_connection::get_inflater() {
+    return m_inflater;
+}
+#endif // STATICLIB_HTTPSERVER_HAVE_ZLIB
+
+void tcp_connection::set_response_pipeline(std::shared_ptr<response_pipeline> pipeline) {
+    // responses must not wait for the delayed acknowledgement of the previous ones
+    if (pipeline && !m_no_delay) {
+        apply_no_delay(true);
+    }
+    std::atomic_store(std::addressof(m_response_pipeline), std::move(pipeline));
+}
+
 void tcp_connection::finish() {
     tcp_connection_ptr conn = shared_from_this();
+    // responses of the batch may be finished from different threads
+    auto pipeline = std::atomic_load(std::addressof(m_response_pipeline));
+    if (pipeline) {
+        if (!pipeline->finish_response(conn)) return;
+        // batch is over, all other responses are finished already
+        std::atomic_store(std::addressof(m_response_pipeline), std::shared_ptr<response_pipeline>());
+        if (!m_no_delay) {
+            apply_no_delay(false);
+        }
+    }
     if (m_finished_handler) m_finished_handler(conn);
 }
 
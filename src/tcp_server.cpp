@@ -25,8 +25,10 @@
 
 #include "staticlib/httpserver/tcp_server.hpp"
 
+#include <atomic>
 #include <functional>
 #include <memory>
+#include <vector>
 
 #include "asio.hpp"
 
@@ -39,6 +41,138 @@
 namespace staticlib {
 namespace httpserver {
     
+const std::chrono::milliseconds tcp_server::SLOW_CLIENT_CHECK_INTERVAL = std::chrono::milliseconds(1000);
+
+namespace { // anonymous
+
+// each connection has at most a read and a write in flight
+const uint32_t URING_QUEUE_ENTRIES = 4096;
+
+} // namespace
+
+class tcp_server::connection_sweeper : public std::enable_shared_from_this<connection_sweeper> {
+    logger m_logger;
+    asio::io_service::strand m_strand;
+    asio::steady_timer m_timer;
+    bool m_running;
+    std::chrono::steady_clock::duration m_header_timeout;
+    std::chrono::steady_clock::duration m_write_timeout;
+    uint32_t m_min_write_rate;
+    std::mutex m_mutex;
+    std::vector<std::weak_ptr<tcp_connection>> m_connections;
+    std::atomic<uint64_t> m_header_timeouts;
+    std::atomic<uint64_t> m_write_timeouts;
+
+public:
+    connection_sweeper(asio::io_service& io_service, logger log) :
+    m_logger(log),
+    m_strand(io_service),
+    m_timer(io_service),
+    m_running(false),
+    m_header_timeout(0),
+    m_write_timeout(0),
+    m_min_write_rate(0),
+    m_header_timeouts(0),
+    m_write_timeouts(0) { }
+
+    void set_policy(std::chrono::steady_clock::duration header_timeout,
+            std::chrono::steady_clock::duration write_timeout, uint32_t min_write_rate) {
+        m_header_timeout = header_timeout;
+        m_write_timeout = write_timeout;
+        m_min_write_rate = min_write_rate;
+    }
+
+    bool is_enabled() const {
+        return m_header_timeout.count() > 0 || m_write_timeout.count() > 0;
+    }
+
+    void add(const tcp_connection_ptr& conn) {
+        conn->set_slow_client_limits(m_header_timeout, m_write_timeout, m_min_write_rate);
+        // new connection must send the first request (and complete SSL handshake) in time
+        conn->start_header_deadline();
+        std::lock_guard<std::mutex> guard{m_mutex};
+        m_connections.emplace_back(conn);
+    }
+
+    slow_client_stats get_stats() const {
+        slow_client_stats res;
+        res.header_timeouts = m_header_timeouts.load();
+        res.write_timeouts = m_write_timeouts.load();
+        return res;
+    }
+
+    void start() {
+        std::weak_ptr<connection_sweeper> weak = shared_from_this();
+        m_strand.post([weak] {
+            auto self = weak.lock();
+            if (!self || self->m_running) return;
+            self->m_running = true;
+            self->schedule();
+        });
+    }
+
+    void stop() {
+        std::weak_ptr<connection_sweeper> weak = shared_from_this();
+        m_strand.post([weak] {
+            auto self = weak.lock();
+            if (!self) return;
+            self->m_running = false;
+            self->m_timer.cancel();
+            std::lock_guard<std::mutex> guard{self->m_mutex};
+            self->m_connections.clear();
+        });
+    }
+
+private:
+    void schedule() {
+        m_timer.expires_from_now(SLOW_CLIENT_CHECK_INTERVAL);
+        std::weak_ptr<connection_sweeper> weak = shared_from_this();
+        m_timer.async_wait(m_strand.wrap([weak](const asio::error_code& ec) {
+            auto self = weak.lock();
+            if (ec || !self || !self->m_running) return;
+            self->sweep();
+            self->schedule();
+        }));
+    }
+
+    void sweep() {
+        auto now = std::chrono::steady_clock::now();
+        std::vector<tcp_connection_ptr> violators;
+        {
+            std::lock_guard<std::mutex> guard{m_mutex};
+            // finished connections are dropped, order is not preserved
+            std::size_t i = 0;
+            while (i < m_connections.size()) {
+                tcp_connection_ptr conn = m_connections[i].lock();
+                if (!conn) {
+                    m_connections[i].swap(m_connections.back());
+                    m_connections.pop_back();
+                    continue;
+                }
+                switch (conn->expire_deadline(now)) {
+                case tcp_connection::DEADLINE_HEADERS:
+                    m_header_timeouts += 1;
+                    violators.emplace_back(std::move(conn));
+                    break;
+                case tcp_connection::DEADLINE_WRITE:
+                    m_write_timeouts += 1;
+                    violators.emplace_back(std::move(conn));
+                    break;
+                default:
+                    break;
+                }
+                i += 1;
+            }
+        }
+        // connections may be released here, outside of the lock
+        for (auto& conn : violators) {
+            STATICLIB_HTTPSERVER_LOG_DEBUG(m_logger, "Closing slow client connection: ["
+                    << conn->get_remote_ip().to_string() << "]");
+            conn->abort();
+        }
+    }
+};
+
 // tcp::server member functions
 
 tcp_server::~tcp_server() STATICLIB_HTTPSERVER_NOEXCEPT {
@@ -63,7 +197,11 @@ m_ssl_context(0),
 #endif
 m_endpoint(asio::ip::tcp::v4(), static_cast<unsigned short>(tcp_port)), 
 m_ssl_flag(false), 
-m_is_listening(false) { }
+m_is_listening(false),
+m_sweeper(std::make_shared<connection_sweeper>(m_active_scheduler.get_io_service(), m_logger)),
+m_speculative_io(std::make_shared<speculative_io_counters>()),
+m_transport(TRANSPORT_REACTOR),
+m_socket_busy_poll(0) { }
     
 tcp_server::tcp_server(scheduler& sched, const asio::ip::tcp::endpoint& endpoint) : 
 m_logger(STATICLIB_HTTPSERVER_GET_LOGGER("staticlib.httpserver.tcp_server")),
@@ -75,7 +213,12 @@ m_ssl_context(asio::ssl::context::sslv23),
 m_ssl_context(0),
 #endif
 m_endpoint(endpoint), 
-m_ssl_flag(false), m_is_listening(false) { }
+m_ssl_flag(false),
+m_is_listening(false),
+m_sweeper(std::make_shared<connection_sweeper>(m_active_scheduler.get_io_service(), m_logger)),
+m_speculative_io(std::make_shared<speculative_io_counters>()),
+m_transport(TRANSPORT_REACTOR),
+m_socket_busy_poll(0) { }
 
 tcp_server::tcp_server(const unsigned int tcp_port) : 
 m_logger(STATICLIB_HTTPSERVER_GET_LOGGER("staticlib.httpserver.tcp_server")),
@@ -88,7 +231,12 @@ m_ssl_context(asio::ssl::context::sslv23),
 m_ssl_context(0),
 #endif
 m_endpoint(asio::ip::tcp::v4(), static_cast<unsigned short>(tcp_port)), 
-m_ssl_flag(false), m_is_listening(false) { }
+m_ssl_flag(false),
+m_is_listening(false),
+m_sweeper(std::make_shared<connection_sweeper>(m_active_scheduler.get_io_service(), m_logger)),
+m_speculative_io(std::make_shared<speculative_io_counters>()),
+m_transport(TRANSPORT_REACTOR),
+m_socket_busy_poll(0) { }
 
 tcp_server::tcp_server(const asio::ip::tcp::endpoint& endpoint) : 
 m_logger(STATICLIB_HTTPSERVER_GET_LOGGER("staticlib.httpserver.tcp_server")),
@@ -102,7 +250,11 @@ m_ssl_context(0),
 #endif
 m_endpoint(endpoint), 
 m_ssl_flag(false),
-m_is_listening(false) { }
+m_is_listening(false),
+m_sweeper(std::make_shared<connection_sweeper>(m_active_scheduler.get_io_service(), m_logger)),
+m_speculative_io(std::make_shared<speculative_io_counters>()),
+m_transport(TRANSPORT_REACTOR),
+m_socket_busy_poll(0) { }
     
 void tcp_server::start() {
     // lock mutex for thread safety
@@ -137,6 +289,19 @@ void tcp_server::start() {
 
         m_is_listening = true;
 
+        if (TRANSPORT_IO_URING == m_transport) {
+            // accept handlers read it unlocked
+            std::atomic_store(std::addressof(m_uring), uring_transport::create(URING_QUEUE_ENTRIES));
+            if (!m_uring) {
+                STATICLIB_HTTPSERVER_LOG_WARN(m_logger, "io_uring is not available, using the reactor");
+                m_transport = TRANSPORT_REACTOR;
+            }
+        }
+
+        if (m_sweeper->is_enabled()) {
+            m_sweeper->start();
+        }
+
         // unlock the mutex since listen() requires its own lock
         server_lock.unlock();
         listen();
@@ -175,6 +340,14 @@ void tcp_server::stop(bool wait_until_finished) {
             scheduler::sleep(m_no_more_connections, server_lock, 0, 250000000);
         }
         
+        m_sweeper->stop();
+
+        // connections left in the pool get "operation_aborted" for their reads
+        if (m_uring) {
+            m_uring->stop();
+            std::atomic_store(std::addressof(m_uring), std::shared_ptr<uring_transport>());
+        }
+
         // notify the thread scheduler that we no longer need it
         m_active_scheduler.remove_active_user();
         
@@ -249,6 +422,35 @@ void tcp_server::handle_accept(tcp_connection_ptr& tcp_conn, const asio::error_c
         // schedule the acceptance of another new connection
         // (this returns immediately since it schedules it as an event)
         if (m_is_listening) listen();
+
+        if (m_connection_limiter) {
+            std::string ip = tcp_conn->get_remote_ip().to_string();
+            if (!m_connection_limiter->try_acquire(ip)) {
+                STATICLIB_HTTPSERVER_LOG_DEBUG(m_logger, "Connections limit reached for client: [" << ip << "]");
+                tcp_conn->set_lifecycle(tcp_connection::LIFECYCLE_CLOSE);
+                tcp_conn->close();
+                finish_connection(tcp_conn);
+                return;
+            }
+            tcp_conn->set_connection_limiter(m_connection_limiter, std::move(ip));
+        }
+
+        if (m_sweeper->is_enabled()) {
+            m_sweeper->add(tcp_conn);
+        }
+
+        if (m_speculative_io) {
+            tcp_conn->set_speculative_io(m_speculative_io);
+        }
+
+        auto uring = std::atomic_load(std::addressof(m_uring));
+        if (uring && !tcp_conn->get_ssl_flag()) {
+            tcp_conn->set_uring_transport(std::move(uring));
+        }
+
+        if (m_socket_busy_poll.count() > 0 && !tcp_conn->set_busy_poll(m_socket_busy_poll)) {
+            STATICLIB_HTTPSERVER_LOG_DEBUG(m_logger, "Cannot set 'SO_BUSY_POLL' on accepted socket");
+        }
         
         // handle the new connection
 #ifdef STATICLIB_HTTPSERVER_HAVE_SSL
@@ -279,24 +481,25 @@ void tcp_server::handle_ssl_handshake(tcp_connection_ptr& tcp_conn,
 }
 
 void tcp_server::finish_connection(tcp_connection_ptr& tcp_conn) {
-    std::lock_guard<std::mutex> server_lock(m_mutex);
-    if (m_is_listening && tcp_conn->get_keep_alive()) {
-        
-        // keep the connection alive
-        handle_connection(tcp_conn);
-
-    } else {
-        STATICLIB_HTTPSERVER_LOG_DEBUG(m_logger, "Closing connection on port " << get_port());
-        
-        // remove the connection from the server's management pool
-        std::set<tcp_connection_ptr>::iterator conn_itr = m_conn_pool.find(tcp_conn);
-        if (conn_itr != m_conn_pool.end())
-            m_conn_pool.erase(conn_itr);
-
-        // trigger the no more connections condition if we're waiting to stop
-        if (!m_is_listening && m_conn_pool.empty())
-            m_no_more_connections.notify_all();
+    {
+        std::lock_guard<std::mutex> server_lock(m_mutex);
+        if (!m_is_listening || !tcp_conn->get_keep_alive()) {
+            STATICLIB_HTTPSERVER_LOG_DEBUG(m_logger, "Closing connection on port " << get_port());
+
+            // remove the connection from the server's management pool
+            std::set<tcp_connection_ptr>::iterator conn_itr = m_conn_pool.find(tcp_conn);
+            if (conn_itr != m_conn_pool.end())
+                m_conn_pool.erase(conn_itr);
+
+            // trigger the no more connections condition if we're waiting to stop
+            if (!m_is_listening && m_conn_pool.empty())
+                m_no_more_connections.notify_all();
+            return;
+        }
     }
+    // keep the connection alive, next request may be read and handled
+    // right away (and finish the connection again), so the lock is released
+    handle_connection(tcp_conn);
 }
 
 std::size_t tcp_server::prune_connections() {
@@ -323,6 +526,54 @@ std::size_t tcp_server::get_connections() const {
     return (m_is_listening ? (m_conn_pool.size() - 1) : m_conn_pool.size());
 }
 
+void tcp_server::set_max_connections_per_ip(uint32_t max_connections) {
+    if (max_connections > 0) {
+        m_connection_limiter = std::make_shared<connection_limiter>(max_connections);
+    } else {
+        m_connection_limiter.reset();
+    }
+}
+
+void tcp_server::set_slow_client_policy(std::chrono::steady_clock::duration header_timeout,
+        std::chrono::steady_clock::duration write_timeout, uint32_t min_write_bytes_per_second) {
+    m_sweeper->set_policy(header_timeout, write_timeout, min_write_bytes_per_second);
+}
+
+tcp_server::slow_client_stats tcp_server::get_slow_client_stats() const {
+    return m_sweeper->get_stats();
+}
+
+void tcp_server::set_speculative_io(bool enabled) {
+    if (enabled) {
+        if (!m_speculative_io) m_speculative_io = std::make_shared<speculative_io_counters>();
+    } else {
+        m_speculative_io.reset();
+    }
+}
+
+tcp_server::speculative_io_stats tcp_server::get_speculative_io_stats() const {
+    speculative_io_stats stats = speculative_io_stats();
+    if (m_speculative_io) {
+        stats.reads_completed = m_speculative_io->reads_completed.load(std::memory_order_relaxed);
+        stats.reads_would_block = m_speculative_io->reads_would_block.load(std::memory_order_relaxed);
+        stats.writes_completed = m_speculative_io->writes_completed.load(std::memory_order_relaxed);
+        stats.writes_would_block = m_speculative_io->writes_would_block.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+void tcp_server::set_transport(transport_type transport) {
+    m_transport = transport;
+}
+
+tcp_server::transport_type tcp_server::get_transport() const {
+    return m_transport;
+}
+
+void tcp_server::set_socket_busy_poll(std::chrono::microseconds interval) {
+    m_socket_busy_poll = interval;
+}
+
 unsigned int tcp_server::get_port() const {
     return m_endpoint.port();
 }
@@ -396,5 +647,14 @@ scheduler& tcp_server::get_active_scheduler() {
     return m_active_scheduler;
 }        
 
+void tcp_server::finish_default_scheduler() {
+    if (m_is_listening) {
+        stop(false);
+    }
+    if (std::addressof(m_active_scheduler) == std::addressof(m_default_scheduler)) {
+        m_default_scheduler.shutdown();
+    }
+}
+
 } // namespace
 }
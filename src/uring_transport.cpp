@@ -0,0 +1,577 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   uring_transport.cpp
+ * Author: agent
+ *
+ * Created on October 19, 2026, 12:40 AM
+ */
+
+#include "staticlib/httpserver/uring_transport.hpp"
+
+#if defined(__linux__) && defined(STATICLIB_HTTPSERVER_HAVE_IO_URING)
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include <cerrno>
+#include <cstring>
+
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif // __linux__ && STATICLIB_HTTPSERVER_HAVE_IO_URING
+
+namespace staticlib {
+namespace httpserver {
+
+#if defined(__linux__) && defined(STATICLIB_HTTPSERVER_HAVE_IO_URING)
+
+namespace { // anonymous
+
+// user data of the completions that are not operations
+const uint64_t WAKE_USER_DATA = 0;
+const uint64_t CANCEL_USER_DATA = 1;
+const uint64_t TIMEOUT_USER_DATA = 2;
+
+// time given to the cancelled operations to complete on stop
+const long STOP_TIMEOUT_SECONDS = 1;
+
+// there is no liburing in the supported toolchains, raw syscalls are used
+
+int uring_setup(uint32_t entries, struct io_uring_params* params) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int uring_enter(int fd, uint32_t to_submit, uint32_t min_complete, uint32_t flags) {
+    int res = -1;
+    do {
+        res = static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+    } while (res < 0 && EINTR == errno);
+    return res;
+}
+
+int uring_register(int fd, uint32_t opcode, void* arg, uint32_t nr_args) {
+    return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, nr_args));
+}
+
+uint64_t to_user_data(const void* ptr) {
+    return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(ptr));
+}
+
+} // namespace
+
+class uring_transport::ring : private staticlib::httpserver::noncopyable {
+public:
+    int fd = -1;
+    // ring is created disabled to be enabled by the thread that submits
+    bool disabled = false;
+    void* sq_ptr = MAP_FAILED;
+    std::size_t sq_size = 0;
+    void* sqes_ptr = MAP_FAILED;
+    std::size_t sqes_size = 0;
+
+    uint32_t sq_entries = 0;
+    uint32_t* sq_head = nullptr;
+    uint32_t* sq_tail = nullptr;
+    uint32_t* sq_mask = nullptr;
+    uint32_t* sq_array = nullptr;
+    struct io_uring_sqe* sqes = nullptr;
+
+    uint32_t* cq_head = nullptr;
+    uint32_t* cq_tail = nullptr;
+    uint32_t* cq_mask = nullptr;
+    struct io_uring_cqe* cqes = nullptr;
+
+    // completion thread is woken up with the read of this descriptor
+    int wake_fd = -1;
+    uint64_t wake_value = 0;
+    struct __kernel_timespec stop_timeout;
+
+    ~ring() STATICLIB_HTTPSERVER_NOEXCEPT {
+        if (MAP_FAILED != sqes_ptr) ::munmap(sqes_ptr, sqes_size);
+        if (MAP_FAILED != sq_ptr) ::munmap(sq_ptr, sq_size);
+        if (-1 != fd) ::close(fd);
+        if (-1 != wake_fd) ::close(wake_fd);
+    }
+
+    bool open(uint32_t entries) {
+        struct io_uring_params params;
+        std::memset(std::addressof(params), 0, sizeof(params));
+#ifdef IORING_SETUP_DEFER_TASKRUN
+        // completion work is run only when the submitting thread waits for completions
+        params.flags = IORING_SETUP_CLAMP | IORING_SETUP_SINGLE_ISSUER |
+                IORING_SETUP_DEFER_TASKRUN | IORING_SETUP_R_DISABLED;
+        fd = uring_setup(entries, std::addressof(params));
+        disabled = fd >= 0;
+#endif // IORING_SETUP_DEFER_TASKRUN
+        if (fd < 0) {
+            // older kernels
+            std::memset(std::addressof(params), 0, sizeof(params));
+            params.flags = IORING_SETUP_CLAMP;
+            fd = uring_setup(entries, std::addressof(params));
+        }
+        if (fd < 0) return false;
+        // without "fast poll" every read waiting for data would occupy a kernel worker,
+        // without "nodrop" completions may be lost when the completion queue overflows
+        uint32_t required = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_FAST_POLL;
+        if (required != (params.features & required)) return false;
+        std::size_t sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+        std::size_t cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+        sq_size = (std::max)(sq_ring_size, cq_ring_size);
+        sq_ptr = ::mmap(nullptr, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                fd, IORING_OFF_SQ_RING);
+        if (MAP_FAILED == sq_ptr) return false;
+        sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+        sqes_ptr = ::mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                fd, IORING_OFF_SQES);
+        if (MAP_FAILED == sqes_ptr) return false;
+
+        char* ptr = static_cast<char*>(sq_ptr);
+        sq_entries = params.sq_entries;
+        sq_head = reinterpret_cast<uint32_t*>(ptr + params.sq_off.head);
+        sq_tail = reinterpret_cast<uint32_t*>(ptr + params.sq_off.tail);
+        sq_mask = reinterpret_cast<uint32_t*>(ptr + params.sq_off.ring_mask);
+        sq_array = reinterpret_cast<uint32_t*>(ptr + params.sq_off.array);
+        sqes = static_cast<struct io_uring_sqe*>(sqes_ptr);
+        cq_head = reinterpret_cast<uint32_t*>(ptr + params.cq_off.head);
+        cq_tail = reinterpret_cast<uint32_t*>(ptr + params.cq_off.tail);
+        cq_mask = reinterpret_cast<uint32_t*>(ptr + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<struct io_uring_cqe*>(ptr + params.cq_off.cqes);
+
+        wake_fd = ::eventfd(0, EFD_CLOEXEC);
+        if (-1 == wake_fd) return false;
+        std::memset(std::addressof(stop_timeout), 0, sizeof(stop_timeout));
+        stop_timeout.tv_sec = STOP_TIMEOUT_SECONDS;
+        return supports_operations();
+    }
+
+    bool supports_operations() {
+        const std::size_t ops_count = 256;
+        // uint64_t elements keep the probe aligned
+        std::vector<uint64_t> buf((sizeof(struct io_uring_probe) +
+                ops_count * sizeof(struct io_uring_probe_op)) / sizeof(uint64_t) + 1, 0);
+        auto probe = reinterpret_cast<struct io_uring_probe*>(buf.data());
+        if (uring_register(fd, IORING_REGISTER_PROBE, probe, ops_count) < 0) return false;
+        for (uint8_t op : {IORING_OP_READ, IORING_OP_TIMEOUT, IORING_OP_POLL_ADD, IORING_OP_ASYNC_CANCEL,
+                IORING_OP_RECV, IORING_OP_RECVMSG, IORING_OP_SENDMSG}) {
+            if (op > probe->last_op || 0 == (probe->ops[op].flags & IO_URING_OP_SUPPORTED)) return false;
+        }
+        return true;
+    }
+
+    void enable() {
+#ifdef IORING_SETUP_DEFER_TASKRUN
+        if (disabled) {
+            uring_register(fd, IORING_REGISTER_ENABLE_RINGS, nullptr, 0);
+        }
+#endif // IORING_SETUP_DEFER_TASKRUN
+    }
+
+    uint32_t queued() {
+        return *sq_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+    }
+
+    struct io_uring_sqe* next_sqe() {
+        if (queued() >= sq_entries) {
+            uring_enter(fd, queued(), 0, 0);
+            if (queued() >= sq_entries) return nullptr;
+        }
+        uint32_t tail = *sq_tail;
+        uint32_t idx = tail & *sq_mask;
+        struct io_uring_sqe* sqe = std::addressof(sqes[idx]);
+        std::memset(sqe, 0, sizeof(struct io_uring_sqe));
+        sq_array[idx] = idx;
+        __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+        return sqe;
+    }
+};
+
+class uring_transport::operation {
+public:
+    asio::io_service& io_service;
+    const void* owner;
+    int fd;
+    bool write;
+    // socket was in non-blocking mode and operation waits for its readiness
+    bool polling = false;
+    // cancellation was submitted, operation must not be resubmitted
+    bool cancelled = false;
+    std::vector<struct iovec> iov;
+    // index of the first buffer that is not written completely
+    std::size_t first = 0;
+    struct msghdr msg;
+    std::size_t transferred = 0;
+    io_handler_type handler;
+
+    operation(asio::io_service& io_service, const void* owner, int fd, bool write, io_handler_type&& handler) :
+    io_service(io_service),
+    owner(owner),
+    fd(fd),
+    write(write),
+    handler(std::move(handler)) {
+        std::memset(std::addressof(msg), 0, sizeof(msg));
+    }
+
+    void prepare(struct io_uring_sqe* sqe) {
+        sqe->fd = fd;
+        sqe->user_data = to_user_data(this);
+        if (polling) {
+            sqe->opcode = IORING_OP_POLL_ADD;
+            sqe->poll_events = write ? POLLOUT : POLLIN;
+        } else if (!write && 1 == iov.size()) {
+            sqe->opcode = IORING_OP_RECV;
+            sqe->addr = to_user_data(iov[0].iov_base);
+            sqe->len = static_cast<uint32_t>(iov[0].iov_len);
+        } else {
+            msg.msg_iov = iov.data() + first;
+            msg.msg_iovlen = iov.size() - first;
+            sqe->opcode = write ? IORING_OP_SENDMSG : IORING_OP_RECVMSG;
+            sqe->addr = to_user_data(std::addressof(msg));
+            sqe->len = 1;
+            sqe->msg_flags = write ? MSG_NOSIGNAL : 0;
+        }
+    }
+
+    // returns true if all the data is written
+    bool advance(std::size_t written) {
+        transferred += written;
+        while (first < iov.size() && written >= iov[first].iov_len) {
+            written -= iov[first].iov_len;
+            first += 1;
+        }
+        if (first < iov.size()) {
+            iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + written;
+            iov[first].iov_len -= written;
+            // zero-length buffers may follow the written ones
+            while (first < iov.size() && 0 == iov[first].iov_len) {
+                first += 1;
+            }
+        }
+        return first == iov.size();
+    }
+};
+
+std::shared_ptr<uring_transport> uring_transport::create(uint32_t entries) {
+    std::unique_ptr<ring> queues{new ring()};
+    if (!queues->open(entries)) return std::shared_ptr<uring_transport>();
+    return std::shared_ptr<uring_transport>(new uring_transport(std::move(queues)));
+}
+
+uring_transport::uring_transport(std::unique_ptr<ring> ring) :
+m_ring(std::move(ring)),
+m_wake_pending(false),
+m_stopped(false) {
+    m_completion_thread = std::thread([this] {
+        this->run();
+    });
+}
+
+uring_transport::~uring_transport() STATICLIB_HTTPSERVER_NOEXCEPT {
+    stop();
+}
+
+void uring_transport::async_read_some(asio::io_service& io_service, const void* owner, int fd,
+        const asio::mutable_buffer* buffers, std::size_t count, io_handler_type handler) {
+    operation* op = new operation(io_service, owner, fd, false, std::move(handler));
+    op->iov.resize(count);
+    for (std::size_t i = 0; i < count; i++) {
+        op->iov[i].iov_base = asio::buffer_cast<void*>(buffers[i]);
+        op->iov[i].iov_len = asio::buffer_size(buffers[i]);
+    }
+    enqueue(op);
+}
+
+void uring_transport::async_write(asio::io_service& io_service, const void* owner, int fd,
+        const asio::const_buffer* buffers, std::size_t count, io_handler_type handler) {
+    operation* op = new operation(io_service, owner, fd, true, std::move(handler));
+    op->iov.resize(count);
+    for (std::size_t i = 0; i < count; i++) {
+        op->iov[i].iov_base = const_cast<void*>(asio::buffer_cast<const void*>(buffers[i]));
+        op->iov[i].iov_len = asio::buffer_size(buffers[i]);
+    }
+    if (op->advance(0)) {
+        complete(op, asio::error_code());
+        return;
+    }
+    enqueue(op);
+}
+
+void uring_transport::cancel(const void* owner) {
+    bool need_wake = false;
+    {
+        std::lock_guard<std::mutex> guard{m_mutex};
+        if (m_stopped) return;
+        m_cancel_queue.push_back(owner);
+        need_wake = !m_wake_pending;
+        m_wake_pending = true;
+    }
+    if (need_wake) {
+        wake();
+    }
+}
+
+void uring_transport::stop() {
+    {
+        std::lock_guard<std::mutex> guard{m_mutex};
+        if (m_stopped) return;
+        m_stopped = true;
+        m_wake_pending = true;
+    }
+    wake();
+    m_completion_thread.join();
+    // kernel may still use the buffers of the operations that were not completed
+    // in time after the cancellation, so the queues are closed before they are released
+    m_ring.reset();
+    for (operation* op : m_pending) {
+        delete op;
+    }
+    m_pending.clear();
+}
+
+void uring_transport::enqueue(operation* op) {
+    bool stopped = false;
+    bool need_wake = false;
+    {
+        std::lock_guard<std::mutex> guard{m_mutex};
+        stopped = m_stopped;
+        if (!stopped) {
+            m_queue.push_back(op);
+            // thread takes all the queued operations when woken up
+            need_wake = !m_wake_pending;
+            m_wake_pending = true;
+        }
+    }
+    if (stopped) {
+        complete(op, asio::error::operation_aborted);
+    } else if (need_wake) {
+        wake();
+    }
+}
+
+void uring_transport::wake() {
+    uint64_t one = 1;
+    ssize_t res = -1;
+    do {
+        res = ::write(m_ring->wake_fd, std::addressof(one), sizeof(one));
+    } while (res < 0 && EINTR == errno);
+}
+
+bool uring_transport::submit(operation* op) {
+    struct io_uring_sqe* sqe = m_ring->next_sqe();
+    if (nullptr == sqe) return false;
+    m_pending.insert(op);
+    op->prepare(sqe);
+    return true;
+}
+
+void uring_transport::submit_cancel(operation* op) {
+    op->cancelled = true;
+    struct io_uring_sqe* sqe = m_ring->next_sqe();
+    if (nullptr == sqe) return;
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = to_user_data(op);
+    sqe->user_data = CANCEL_USER_DATA;
+}
+
+void uring_transport::handle_completion(operation* op, int res, bool stopping) {
+    asio::error_code ec;
+    bool done = true;
+    if (op->polling) {
+        op->polling = false;
+        if (res < 0) {
+            ec = asio::error_code(-res, asio::error::get_system_category());
+        } else {
+            done = false;
+        }
+    } else if (-EAGAIN == res || -EINTR == res) {
+        op->polling = -EAGAIN == res;
+        done = false;
+    } else if (res < 0) {
+        ec = asio::error_code(-res, asio::error::get_system_category());
+    } else if (0 == res) {
+        ec = asio::error::eof;
+    } else if (!op->write) {
+        op->transferred = static_cast<std::size_t>(res);
+    } else {
+        done = op->advance(static_cast<std::size_t>(res));
+    }
+    if (!done) {
+        if (stopping || op->cancelled) {
+            ec = asio::error::operation_aborted;
+        } else if (submit(op)) {
+            return;
+        } else {
+            ec = asio::error::no_buffer_space;
+        }
+    }
+    m_pending.erase(op);
+    complete(op, ec);
+}
+
+void uring_transport::complete(operation* op, const asio::error_code& ec) {
+    std::unique_ptr<operation> holder{op};
+    io_handler_type handler = std::move(op->handler);
+    std::size_t transferred = op->transferred;
+    op->io_service.post([handler, ec, transferred]() {
+        handler(ec, transferred);
+    });
+}
+
+void uring_transport::run() {
+    m_ring->enable();
+    std::vector<operation*> queue;
+    std::vector<const void*> cancels;
+    std::vector<std::pair<operation*, int>> completed;
+    bool wake_armed = false;
+    bool stopping = false;
+    for (;;) {
+        bool stop_requested = false;
+        {
+            std::lock_guard<std::mutex> guard{m_mutex};
+            queue.swap(m_queue);
+            cancels.swap(m_cancel_queue);
+            m_wake_pending = false;
+            stop_requested = m_stopped;
+        }
+        // cancellations are taken before the new operations, so they cannot hit operations
+        // queued after them, queued operations of the cancelled owners are not submitted
+        for (operation* op : m_pending) {
+            if (!op->cancelled && cancels.end() != std::find(cancels.begin(), cancels.end(), op->owner)) {
+                submit_cancel(op);
+            }
+        }
+        for (operation* op : queue) {
+            if (cancels.end() != std::find(cancels.begin(), cancels.end(), op->owner)) {
+                complete(op, asio::error::operation_aborted);
+            } else if (!submit(op)) {
+                complete(op, asio::error::no_buffer_space);
+            }
+        }
+        queue.clear();
+        cancels.clear();
+        if (stop_requested && !stopping) {
+            stopping = true;
+            // kernel may still write into the buffers of the pending operations,
+            // so they are cancelled and completed before the thread exits
+            for (operation* op : m_pending) {
+                submit_cancel(op);
+            }
+            struct io_uring_sqe* sqe = m_ring->next_sqe();
+            if (nullptr != sqe) {
+                sqe->opcode = IORING_OP_TIMEOUT;
+                sqe->fd = -1;
+                sqe->addr = to_user_data(std::addressof(m_ring->stop_timeout));
+                sqe->len = 1;
+                sqe->user_data = TIMEOUT_USER_DATA;
+            }
+        }
+        if (stopping && m_pending.empty()) return;
+        if (!wake_armed && !stopping) {
+            struct io_uring_sqe* sqe = m_ring->next_sqe();
+            if (nullptr != sqe) {
+                sqe->opcode = IORING_OP_READ;
+                sqe->fd = m_ring->wake_fd;
+                sqe->addr = to_user_data(std::addressof(m_ring->wake_value));
+                sqe->len = sizeof(m_ring->wake_value);
+                sqe->user_data = WAKE_USER_DATA;
+                wake_armed = true;
+            }
+        }
+        // submits queued entries and waits for completions with a single call
+        uring_enter(m_ring->fd, m_ring->queued(), 1, IORING_ENTER_GETEVENTS);
+        uint32_t head = *m_ring->cq_head;
+        uint32_t tail = __atomic_load_n(m_ring->cq_tail, __ATOMIC_ACQUIRE);
+        bool timed_out = false;
+        for (; head != tail; ++head) {
+            struct io_uring_cqe* cqe = std::addressof(m_ring->cqes[head & *m_ring->cq_mask]);
+            if (WAKE_USER_DATA == cqe->user_data) {
+                wake_armed = false;
+            } else if (TIMEOUT_USER_DATA == cqe->user_data) {
+                timed_out = true;
+            } else if (CANCEL_USER_DATA != cqe->user_data) {
+                completed.emplace_back(reinterpret_cast<operation*>(
+                        static_cast<uintptr_t>(cqe->user_data)), cqe->res);
+            }
+        }
+        __atomic_store_n(m_ring->cq_head, tail, __ATOMIC_RELEASE);
+        for (auto& en : completed) {
+            handle_completion(en.first, en.second, stopping);
+        }
+        completed.clear();
+        if (timed_out) return;
+    }
+}
+
+#else // __linux__ && STATICLIB_HTTPSERVER_HAVE_IO_URING
+
+class uring_transport::ring { };
+
+std::shared_ptr<uring_transport> uring_transport::create(uint32_t) {
+    return std::shared_ptr<uring_transport>();
+}
+
+uring_transport::uring_transport(std::unique_ptr<ring> ring) :
+m_ring(std::move(ring)),
+m_wake_pending(false),
+m_stopped(true) { }
+
+uring_transport::~uring_transport() STATICLIB_HTTPSERVER_NOEXCEPT { }
+
+void uring_transport::async_read_some(asio::io_service& io_service, const void*, int,
+        const asio::mutable_buffer*, std::size_t, io_handler_type handler) {
+    io_service.post([handler] {
+        handler(asio::error::operation_not_supported, 0);
+    });
+}
+
+void uring_transport::async_write(asio::io_service& io_service, const void*, int,
+        const asio::const_buffer*, std::size_t, io_handler_type handler) {
+    io_service.post([handler] {
+        handler(asio::error::operation_not_supported, 0);
+    });
+}
+
+void uring_transport::cancel(const void*) { }
+
+void uring_transport::stop() { }
+
+void uring_transport::enqueue(operation*) { }
+
+void uring_transport::wake() { }
+
+bool uring_transport::submit(operation*) {
+    return false;
+}
+
+void uring_transport::submit_cancel(operation*) { }
+
+void uring_transport::handle_completion(operation*, int, bool) { }
+
+void uring_transport::complete(operation*, const asio::error_code&) { }
+
+void uring_transport::run() { }
+
+#endif // __linux__ && STATICLIB_HTTPSERVER_HAVE_IO_URING
+
+} // namespace
+}
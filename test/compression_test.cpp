@@ -0,0 +1,247 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   compression_test.cpp
+ * Author: agent
+ *
+ * Created on October 19, 2026, 1:30 AM
+ */
+
+#include <iostream>
+
+#ifdef STATICLIB_HTTPSERVER_HAVE_ZLIB
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <cstdint>
+#include <cstring>
+
+#include "zlib.h"
+
+#include "asio.hpp"
+
+#include "staticlib/httpserver/http_response_writer.hpp"
+#include "staticlib/httpserver/http_server.hpp"
+
+#include "test_client.hpp"
+
+namespace sh = staticlib::httpserver;
+namespace tc = test_client;
+
+const uint16_t TCP_PORT = 8083;
+const int WINDOW_BITS_GZIP = 15 + 16;
+const int WINDOW_BITS_ZLIB = 15;
+
+std::string make_text(std::size_t lines) {
+    std::ostringstream res;
+    for (std::size_t i = 0; i < lines; i++) {
+        res << "line " << i << ": " << (i * 7919 % 104729) << "\n";
+    }
+    return res.str();
+}
+
+std::string compress(const std::string& data, int window_bits) {
+    z_stream zs;
+    std::memset(std::addressof(zs), '\0', sizeof(zs));
+    tc::check(Z_OK == deflateInit2(std::addressof(zs), Z_DEFAULT_COMPRESSION, Z_DEFLATED, window_bits,
+            8, Z_DEFAULT_STRATEGY), "deflateInit2 error");
+    std::string res(deflateBound(std::addressof(zs), static_cast<uLong>(data.size())), '\0');
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    zs.avail_in = static_cast<uInt>(data.size());
+    zs.next_out = reinterpret_cast<Bytef*>(std::addressof(res.front()));
+    zs.avail_out = static_cast<uInt>(res.size());
+    tc::check(Z_STREAM_END == deflate(std::addressof(zs), Z_FINISH), "deflate error");
+    res.resize(res.size() - zs.avail_out);
+    deflateEnd(std::addressof(zs));
+    return res;
+}
+
+std::string decompress(const std::string& data) {
+    z_stream zs;
+    std::memset(std::addressof(zs), '\0', sizeof(zs));
+    // zlib or gzip header is detected automatically
+    tc::check(Z_OK == inflateInit2(std::addressof(zs), 15 + 32), "inflateInit2 error");
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    zs.avail_in = static_cast<uInt>(data.size());
+    std::string res;
+    char buf[16384];
+    int err = Z_OK;
+    while (Z_OK == err) {
+        zs.next_out = reinterpret_cast<Bytef*>(buf);
+        zs.avail_out = sizeof(buf);
+        err = inflate(std::addressof(zs), Z_NO_FLUSH);
+        res.append(buf, sizeof(buf) - zs.avail_out);
+    }
+    inflateEnd(std::addressof(zs));
+    tc::check(Z_STREAM_END == err, "Response body is not a complete compressed stream");
+    return res;
+}
+
+std::string chunked(const std::string& data, std::size_t chunk_size) {
+    std::ostringstream res;
+    for (std::size_t i = 0; i < data.size(); i += chunk_size) {
+        std::size_t len = std::min(chunk_size, data.size() - i);
+        res << std::hex << len << "\r\n" << data.substr(i, len) << "\r\n";
+    }
+    res << "0\r\n\r\n";
+    return res.str();
+}
+
+class collector {
+public:
+    std::shared_ptr<std::string> data = std::make_shared<std::string>();
+
+    void operator()(const char* buf, std::size_t len) {
+        data->append(buf, len);
+    }
+};
+
+void echo_collected(sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+    // payload handler is retrieved by its own type, decoding is transparent to it
+    auto coll = req->get_payload_handler<collector>();
+    auto writer = sh::http_response_writer::create(conn, req);
+    writer->write(nullptr != coll ? *coll->data : std::string("no collector"));
+    writer->send();
+}
+
+std::string post(const std::string& encoding, const std::string& body, bool chunked_body) {
+    std::string head = "POST /echo HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n"
+            "Content-Encoding: " + encoding + "\r\n";
+    if (chunked_body) {
+        return head + "Transfer-Encoding: chunked\r\n\r\n" + chunked(body, 1000);
+    }
+    return head + "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+}
+
+void test_request_decoding() {
+    sh::http_server server(2, TCP_PORT);
+    server.add_handler("POST", "/echo", echo_collected);
+    server.add_payload_handler("POST", "/echo", [](sh::http_request_ptr&) {
+        return collector();
+    });
+    server.start();
+    std::string text = make_text(20000);
+    std::string gzipped = compress(text, WINDOW_BITS_GZIP);
+    for (bool chunked_body : {false, true}) {
+        std::string mode = chunked_body ? " (chunked)" : " (content length)";
+        auto gz = tc::request(TCP_PORT, post("gzip", gzipped, chunked_body));
+        tc::check(200 == gz.status && text == gz.body, "Invalid gzip request decoding" + mode);
+        auto zl = tc::request(TCP_PORT, post("deflate", compress(text, WINDOW_BITS_ZLIB), chunked_body));
+        tc::check(200 == zl.status && text == zl.body, "Invalid deflate request decoding" + mode);
+        // compressed stream is cut in the middle
+        auto tr = tc::request(TCP_PORT, post("gzip", gzipped.substr(0, gzipped.size() / 2), chunked_body));
+        tc::check(400 == tr.status, "Truncated body accepted" + mode + ", status: " + std::to_string(tr.status));
+    }
+    // identity body is passed as is
+    auto plain = tc::request(TCP_PORT, "POST /echo HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n"
+            "Content-Length: 5\r\n\r\nhello");
+    tc::check(200 == plain.status && "hello" == plain.body, "Invalid identity request");
+    server.stop(true);
+}
+
+void compressed_text(sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+    auto writer = sh::http_response_writer::create(conn, req);
+    writer->get_response().set_content_type("text/plain");
+    writer->enable_compression();
+    writer->write(req->get_query("size").empty() ? make_text(5000) : make_text(1));
+    writer->send();
+}
+
+void compressed_chunks(sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+    auto writer = sh::http_response_writer::create(conn, req);
+    writer->get_response().set_content_type("text/plain");
+    writer->enable_compression();
+    writer->write(make_text(100));
+    writer->send_chunk([writer](const asio::error_code& ec, std::size_t) {
+        if (ec) return;
+        writer->clear();
+        writer->write(make_text(3000));
+        writer->send_final_chunk();
+    });
+}
+
+void queued_compressed_chunks(sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+    auto writer = sh::http_response_writer::create(conn, req);
+    writer->get_response().set_content_type("text/plain");
+    writer->enable_compression();
+    // chunks are compressed while the previous ones are being written
+    for (std::size_t i = 1; i <= 10; i++) {
+        writer->clear();
+        writer->write(make_text(i * 500));
+        writer->send_chunk([](const asio::error_code&, std::size_t) {});
+    }
+    writer->clear();
+    writer->send_final_chunk();
+}
+
+std::string get(const std::string& path, const std::string& accept_encoding) {
+    return "GET " + path + " HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n" +
+            (accept_encoding.empty() ? std::string() : "Accept-Encoding: " + accept_encoding + "\r\n") + "\r\n";
+}
+
+void test_response_compression() {
+    sh::http_server server(2, TCP_PORT);
+    server.add_handler("GET", "/text", compressed_text);
+    server.add_handler("GET", "/chunks", compressed_chunks);
+    server.add_handler("GET", "/queued", queued_compressed_chunks);
+    server.start();
+    std::string text = make_text(5000);
+    auto gz = tc::request(TCP_PORT, get("/text", "br;q=0.9, gzip;q=0.8, deflate;q=0.5"));
+    tc::check("gzip" == gz.headers["content-encoding"], "Response is not gzipped");
+    tc::check(gz.body.size() < text.size() && text == decompress(gz.body), "Invalid gzipped response");
+    tc::check(std::string::npos != gz.headers["vary"].find("Accept-Encoding"), "No Vary header");
+    auto df = tc::request(TCP_PORT, get("/text", "gzip;q=0, deflate"));
+    tc::check("deflate" == df.headers["content-encoding"] && text == decompress(df.body),
+            "Invalid deflated response");
+    auto plain = tc::request(TCP_PORT, get("/text", ""));
+    tc::check(0 == plain.headers.count("content-encoding") && text == plain.body, "Invalid plain response");
+    auto small = tc::request(TCP_PORT, get("/text?size=small", "gzip"));
+    tc::check(0 == small.headers.count("content-encoding") && make_text(1) == small.body,
+            "Short response compressed");
+    auto chunks = tc::request(TCP_PORT, get("/chunks", "gzip"));
+    tc::check(chunks.chunked && "gzip" == chunks.headers["content-encoding"] &&
+            make_text(100) + make_text(3000) == decompress(chunks.body), "Invalid gzipped chunks");
+    std::string queued_text;
+    for (std::size_t i = 1; i <= 10; i++) {
+        queued_text.append(make_text(i * 500));
+    }
+    auto queued = tc::request(TCP_PORT, get("/queued", "gzip"));
+    tc::check(queued.chunked && "gzip" == queued.headers["content-encoding"] &&
+            queued_text == decompress(queued.body), "Invalid gzipped queued chunks");
+    server.stop(true);
+}
+
+int main() {
+    try {
+        test_request_decoding();
+        test_response_compression();
+    } catch (const std::exception& e) {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+#else // !STATICLIB_HTTPSERVER_HAVE_ZLIB
+
+int main() {
+    std::cout << "Compression tests skipped, library is built without zlib" << std::endl;
+    return 0;
+}
+
+#endif // STATICLIB_HTTPSERVER_HAVE_ZLIB
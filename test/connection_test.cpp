@@ -0,0 +1,376 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   connection_test.cpp
+ * Author: agent
+ *
+ * Created on October 19, 2026, 2:34 AM
+ */
+
+#include <iostream>
+#include <array>
+#include <chrono>
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <cstdint>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "asio.hpp"
+
+#include "staticlib/httpserver/http_file_sink.hpp"
+#include "staticlib/httpserver/http_response_writer.hpp"
+#include "staticlib/httpserver/http_server.hpp"
+
+#include "test_client.hpp"
+
+namespace sh = staticlib::httpserver;
+namespace tc = test_client;
+
+const uint16_t TCP_PORT = 8085;
+const std::size_t LARGE_SIZE = 16 * 1024 * 1024;
+const std::size_t PIPELINED_COUNT = 5;
+const std::string DATA_FILE = "connection_test_data.dat";
+const std::size_t FILE_SIZE = 32 * 1024 * 1024 + 7;
+const std::string SINK_FILE = "connection_test_sink.dat";
+// default read timeout of the request reader
+const long READ_TIMEOUT_SECONDS = 10;
+
+void hello(sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+    auto writer = sh::http_response_writer::create(conn, req);
+    writer->write("hello");
+    writer->send();
+}
+
+const std::string& large_body() {
+    static std::string res(LARGE_SIZE, 'x');
+    return res;
+}
+
+void large(sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+    auto writer = sh::http_response_writer::create(conn, req);
+    writer->write_no_copy(large_body());
+    writer->send();
+}
+
+void test_slow_client() {
+    sh::http_server server(2, TCP_PORT);
+    server.add_handler("GET", "/hello", hello);
+    server.add_handler("GET", "/large", large);
+    server.set_slow_client_policy(std::chrono::milliseconds(500), std::chrono::milliseconds(500), 100 * 1024 * 1024);
+    server.start();
+    // request sent in time is not affected
+    auto resp = tc::request(TCP_PORT, "GET /hello HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n");
+    tc::check(200 == resp.status && "hello" == resp.body, "Invalid response to fast client");
+    // headers are never completed
+    {
+        asio::io_service io;
+        asio::ip::tcp::socket socket{io};
+        socket.connect(tc::endpoint(TCP_PORT));
+        asio::write(socket, asio::buffer(std::string("GET /hello HTTP/1.1\r\nHost: loc")));
+        auto start = std::chrono::steady_clock::now();
+        std::string data = tc::read_all(socket);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        tc::check(data.empty(), "Response sent to incomplete request");
+        tc::check(elapsed < std::chrono::seconds(5), "Slow headers connection is not closed");
+    }
+    tc::check(1 == server.get_slow_client_stats().header_timeouts, "Header timeout is not counted");
+    // response is not read
+    {
+        asio::io_service io;
+        asio::ip::tcp::socket socket{io};
+        socket.connect(tc::endpoint(TCP_PORT));
+        asio::write(socket, asio::buffer(std::string("GET /large HTTP/1.1\r\nHost: localhost\r\n\r\n")));
+        std::this_thread::sleep_for(std::chrono::milliseconds(3000));
+        std::string data = tc::read_all(socket);
+        tc::check(data.size() < LARGE_SIZE, "Slow reader connection is not closed");
+    }
+    tc::check(1 == server.get_slow_client_stats().write_timeouts, "Write timeout is not counted");
+    server.stop(true);
+}
+
+bool get_no_delay(sh::tcp_connection_ptr& conn) {
+    asio::ip::tcp::no_delay opt;
+    conn->get_socket().get_option(opt);
+    return opt.value();
+}
+
+void delayed(sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+    // later requests of the batch finish first
+    std::this_thread::sleep_for(std::chrono::milliseconds(std::stoi(req->get_query("ms"))));
+    auto writer = sh::http_response_writer::create(conn, req);
+    writer->write(req->get_query("id") + (get_no_delay(conn) ? ":nodelay" : ":delay"));
+    writer->send();
+}
+
+void no_delay_state(sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+    auto writer = sh::http_response_writer::create(conn, req);
+    writer->write(get_no_delay(conn) ? "nodelay" : "delay");
+    writer->send();
+}
+
+void test_pipelined_order() {
+    sh::http_server server(2, TCP_PORT);
+    server.set_worker_threads(4);
+    server.set_pipeline_depth(8);
+    server.add_offloaded_handler("GET", "/delayed", delayed);
+    server.add_handler("GET", "/nodelay", no_delay_state);
+    server.start();
+    asio::io_service io;
+    asio::ip::tcp::socket socket{io};
+    socket.connect(tc::endpoint(TCP_PORT));
+    std::string batch;
+    for (std::size_t i = 0; i < PIPELINED_COUNT; i++) {
+        batch.append("GET /delayed?id=" + std::to_string(i) + "&ms=" + std::to_string((PIPELINED_COUNT - i) * 50) +
+                " HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    }
+    // all requests arrive together and are handled concurrently
+    asio::write(socket, asio::buffer(batch));
+    std::string data;
+    std::size_t consumed = 0;
+    std::array<char, 4096> buf;
+    for (std::size_t i = 0; i < PIPELINED_COUNT; i++) {
+        tc::response resp;
+        std::size_t len = 0;
+        while (0 == (len = tc::parse_response(data.substr(consumed), resp))) {
+            std::size_t read = socket.read_some(asio::buffer(buf));
+            data.append(buf.data(), read);
+        }
+        consumed += len;
+        tc::check(200 == resp.status && std::to_string(i) + ":nodelay" == resp.body,
+                "Invalid pipelined response: [" + resp.body + "], index: " + std::to_string(i));
+    }
+    // option is restored after the batch
+    asio::write(socket, asio::buffer(std::string("GET /nodelay HTTP/1.1\r\nHost: localhost\r\n"
+            "Connection: close\r\n\r\n")));
+    data = data.substr(consumed) + tc::read_all(socket);
+    tc::response last;
+    tc::check(0 != tc::parse_response(data, last) && "delay" == last.body,
+            "TCP_NODELAY is left after the batch: [" + last.body + "]");
+    server.stop(true);
+}
+
+void test_pipelined_concurrent() {
+    sh::http_server server(1, TCP_PORT);
+    server.set_worker_threads(4);
+    server.set_pipeline_depth(8);
+    // handler is not offloaded, but the batch is still handled concurrently
+    server.add_handler("GET", "/delayed", delayed);
+    server.start();
+    std::string batch;
+    for (std::size_t i = 0; i < 4; i++) {
+        batch.append("GET /delayed?id=" + std::to_string(i) + "&ms=300 HTTP/1.1\r\nHost: localhost\r\n" +
+                (3 == i ? "Connection: close\r\n" : "") + "\r\n");
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::string data = tc::exchange(TCP_PORT, batch);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    for (std::size_t i = 0; i < 4; i++) {
+        tc::response resp;
+        std::size_t len = tc::parse_response(data, resp);
+        tc::check(0 != len && std::to_string(i) + ":nodelay" == resp.body,
+                "Invalid pipelined response: [" + resp.body + "], index: " + std::to_string(i));
+        data = data.substr(len);
+    }
+    tc::check(elapsed < std::chrono::milliseconds(900), "Pipelined handlers are run one after another");
+    server.stop(true);
+}
+
+std::string make_data(std::size_t size) {
+    std::string res;
+    res.reserve(size);
+    for (std::size_t i = 0; i < size; i++) {
+        res.push_back(static_cast<char>(i * 11 % 241));
+    }
+    return res;
+}
+
+void test_slow_file_reader() {
+    std::string data = make_data(FILE_SIZE);
+    {
+        std::ofstream out{DATA_FILE, std::ios::out | std::ios::binary};
+        out.write(data.data(), data.size());
+    }
+    int fd = ::open(DATA_FILE.c_str(), O_RDONLY);
+    tc::check(-1 != fd, "Cannot open data file");
+    // single IO thread, blocked write would stall all connections
+    sh::http_server server(1, TCP_PORT);
+    server.add_handler("GET", "/file", [fd](sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+        auto writer = sh::http_response_writer::create(conn, req);
+        writer->write_file(fd, 0, FILE_SIZE);
+        writer->send();
+    });
+    server.add_handler("GET", "/hello", hello);
+    server.start();
+    asio::io_service io;
+    asio::ip::tcp::socket socket{io};
+    socket.connect(tc::endpoint(TCP_PORT));
+    asio::write(socket, asio::buffer(std::string("GET /file HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n")));
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    // file is not read while the other client is served
+    auto other = std::async(std::launch::async, [] {
+        return tc::request(TCP_PORT, "GET /hello HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n");
+    });
+    bool served = std::future_status::ready == other.wait_for(std::chrono::seconds(3));
+    // file is read slowly, so it is sent with many partial writes
+    std::string received;
+    std::array<char, 65536> buf;
+    asio::error_code ec;
+    while (!ec) {
+        std::size_t len = socket.read_some(asio::buffer(buf), ec);
+        received.append(buf.data(), len);
+        if (0 == received.size() % 16) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    tc::check(served, "Connection is blocked by a slow file reader");
+    tc::check("hello" == other.get().body, "Invalid response to other client");
+    tc::response resp;
+    tc::check(0 != tc::parse_response(received, resp) && 200 == resp.status && data == resp.body,
+            "Invalid file response to slow reader");
+    server.stop(true);
+    ::close(fd);
+    std::remove(DATA_FILE.c_str());
+}
+
+void test_slow_uploader() {
+    // single IO thread, blocked splice would stall all connections
+    sh::http_server server(1, TCP_PORT);
+    server.add_handler("POST", "/sink", [](sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+        auto sink = req->get_payload_handler<sh::http_file_sink>();
+        if (sink) sink->close();
+        auto writer = sh::http_response_writer::create(conn, req);
+        writer->write(sink ? "closed" : "no sink");
+        writer->send();
+    });
+    server.add_payload_handler("POST", "/sink", [](sh::http_request_ptr&) {
+        return sh::http_file_sink{SINK_FILE};
+    });
+    server.add_handler("GET", "/hello", hello);
+    server.add_handler("GET", "/busy", [](sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        hello(req, conn);
+    });
+    server.start();
+    auto busy = std::async(std::launch::async, [] {
+        return tc::request(TCP_PORT, "GET /busy HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n");
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    std::string body = make_data(1024 * 1024);
+    std::size_t half = body.size() / 2;
+    asio::io_service io;
+    asio::ip::tcp::socket socket{io};
+    socket.connect(tc::endpoint(TCP_PORT));
+    // headers and the first half of the body are already received when the connection
+    // is accepted, so they are read speculatively, the rest of the body is late
+    asio::write(socket, asio::buffer("POST /sink HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n"
+            "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body.substr(0, half)));
+    tc::check("hello" == busy.get().body, "Invalid response to busy request");
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    auto other = std::async(std::launch::async, [] {
+        return tc::request(TCP_PORT, "GET /hello HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n");
+    });
+    bool served = std::future_status::ready == other.wait_for(std::chrono::seconds(3));
+    asio::write(socket, asio::buffer(body.substr(half)));
+    tc::response resp;
+    tc::check(0 != tc::parse_response(tc::read_all(socket), resp) && "closed" == resp.body,
+            "Invalid response to slow uploader");
+    tc::check(served, "Connection is blocked by a slow uploader");
+    tc::check("hello" == other.get().body, "Invalid response to other client");
+    std::ifstream stream{SINK_FILE, std::ios::in | std::ios::binary};
+    tc::check(body == std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()),
+            "Sink file mismatch");
+    server.stop(true);
+    std::remove(SINK_FILE.c_str());
+}
+
+std::string read_response(asio::ip::tcp::socket& socket, std::string& data) {
+    std::array<char, 4096> buf;
+    tc::response resp;
+    std::size_t len = 0;
+    while (0 == (len = tc::parse_response(data, resp))) {
+        std::size_t read = socket.read_some(asio::buffer(buf));
+        data.append(buf.data(), read);
+    }
+    data = data.substr(len);
+    return resp.body;
+}
+
+void test_uring_transport() {
+    sh::http_server server(2, TCP_PORT);
+    server.set_transport(sh::tcp_server::TRANSPORT_IO_URING);
+    server.add_handler("GET", "/hello", hello);
+    server.add_handler("GET", "/large", large);
+    server.start();
+    if (sh::tcp_server::TRANSPORT_IO_URING != server.get_transport()) {
+        std::cout << "io_uring tests skipped, transport is not available" << std::endl;
+        server.stop(true);
+        return;
+    }
+    // response is larger than the socket buffer and is read slowly
+    {
+        asio::io_service io;
+        asio::ip::tcp::socket socket{io};
+        socket.connect(tc::endpoint(TCP_PORT));
+        asio::write(socket, asio::buffer(std::string("GET /large HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n")));
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        tc::response resp;
+        tc::check(0 != tc::parse_response(tc::read_all(socket), resp) && large_body() == resp.body,
+                "Invalid large response over io_uring");
+    }
+    // idle connection is cancelled by the read timeout, busy one is not affected
+    asio::io_service io;
+    asio::ip::tcp::socket idle{io};
+    idle.connect(tc::endpoint(TCP_PORT));
+    asio::ip::tcp::socket busy{io};
+    busy.connect(tc::endpoint(TCP_PORT));
+    std::string busy_data;
+    auto timeout = std::chrono::seconds(READ_TIMEOUT_SECONDS) + std::chrono::milliseconds(1500);
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (std::chrono::steady_clock::now() < deadline) {
+        asio::write(busy, asio::buffer(std::string("GET /hello HTTP/1.1\r\nHost: localhost\r\n\r\n")));
+        tc::check("hello" == read_response(busy, busy_data), "Busy connection is affected by cancellation");
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    idle.non_blocking(true);
+    std::array<char, 16> buf;
+    asio::error_code ec;
+    idle.read_some(asio::buffer(buf), ec);
+    tc::check(asio::error::eof == ec, "Idle connection is not closed after read timeout: " + ec.message());
+    server.stop(true);
+}
+
+int main() {
+    try {
+        test_slow_client();
+        test_pipelined_order();
+        test_pipelined_concurrent();
+        test_slow_file_reader();
+        test_slow_uploader();
+        test_uring_transport();
+    } catch (const std::exception& e) {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   multipart_test.cpp
+ * Author: agent
+ *
+ * Created on October 18, 2026, 6:41 PM
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "staticlib/httpserver/http_multipart_parser.hpp"
+
+namespace sh = staticlib::httpserver;
+
+const std::string CONTENT_TYPE = "multipart/form-data; boundary=----BoUnDaRy42";
+
+const std::string FILE_DATA = std::string("line1\r\n--not-a-boundary\r\n------BoUnDaRy4\r\n") +
+        std::string(1000, 'x') + "\r\n------BoUnDaRy";
+
+const std::string CONTENT = std::string("preamble to ignore\r\n") +
+        "------BoUnDaRy42\r\n"
+        "Content-Disposition: form-data; name=\"field1\"\r\n"
+        "\r\n"
+        "value1\r\n"
+        "------BoUnDaRy42\r\n"
+        "Content-Disposition: form-data; name=\"file1\"; filename=\"a;b.txt\"\r\n"
+        "Content-Type: application/octet-stream\r\n"
+        "\r\n" +
+        FILE_DATA + "\r\n"
+        "------BoUnDaRy42\r\n"
+        "\r\n"
+        "\r\n"
+        "------BoUnDaRy42--\r\n"
+        "epilogue to ignore";
+
+struct part {
+    sh::http_multipart_parser::headers_type headers;
+    std::string data;
+    bool finished = false;
+};
+
+void check(bool condition, const std::string& msg) {
+    if (!condition) throw std::runtime_error(msg);
+}
+
+void test_chunked(std::size_t chunk_size, const std::string& content_type = CONTENT_TYPE) {
+    std::vector<part> parts;
+    sh::http_multipart_parser parser{content_type,
+        [&parts](const sh::http_multipart_parser::headers_type& headers) {
+            parts.emplace_back();
+            parts.back().headers = headers;
+        },
+        [&parts](const char* data, std::size_t len) {
+            parts.back().data.append(data, len);
+        },
+        [&parts]() {
+            parts.back().finished = true;
+        }};
+    // payload handlers are passed by value
+    sh::http_multipart_parser copy = parser;
+    for (std::size_t i = 0; i < CONTENT.size(); i += chunk_size) {
+        copy(CONTENT.data() + i, std::min(chunk_size, CONTENT.size() - i));
+    }
+    std::string sz = " (chunk size: " + std::to_string(chunk_size) + ")";
+    check(parser.is_finished(), "Not finished" + sz);
+    check(3 == parts.size(), "Invalid parts count: " + std::to_string(parts.size()) + sz);
+    check("field1" == sh::http_multipart_parser::get_disposition_param(parts[0].headers, "name"), "Invalid name" + sz);
+    check("value1" == parts[0].data, "Invalid field value" + sz);
+    check("file1" == sh::http_multipart_parser::get_disposition_param(parts[1].headers, "name"), "Invalid file name" + sz);
+    check("a;b.txt" == sh::http_multipart_parser::get_disposition_param(parts[1].headers, "filename"), "Invalid filename" + sz);
+    check("application/octet-stream" == parts[1].headers.find("content-type")->second, "Invalid content type" + sz);
+    check(FILE_DATA == parts[1].data, "Invalid file data" + sz);
+    check(parts[2].headers.empty() && parts[2].data.empty(), "Invalid empty part" + sz);
+    for (auto& pa : parts) {
+        check(pa.finished, "Part not finished" + sz);
+    }
+}
+
+void test_invalid() {
+    bool thrown = false;
+    try {
+        sh::http_multipart_parser parser{"multipart/form-data", nullptr, nullptr, nullptr};
+    } catch (const std::exception&) {
+        thrown = true;
+    }
+    check(thrown, "No boundary accepted");
+    thrown = false;
+    try {
+        sh::http_multipart_parser parser{"multipart/form-data; xboundary=----BoUnDaRy42", nullptr, nullptr, nullptr};
+    } catch (const std::exception&) {
+        thrown = true;
+    }
+    check(thrown, "Boundary taken from another parameter");
+}
+
+void test_boundary_param() {
+    // parameter names are case-insensitive, similar names and quoted semicolons are skipped
+    test_chunked(CONTENT.size(), "multipart/form-data; xboundary=wrong; charset=\"a;boundary=b\"; "
+            "Boundary=\"----BoUnDaRy42\"");
+    test_chunked(CONTENT.size(), "Multipart/Form-Data;BOUNDARY=----BoUnDaRy42;charset=utf-8");
+}
+
+int main() {
+    try {
+        for (std::size_t chunk_size = 1; chunk_size <= 80; chunk_size++) {
+            test_chunked(chunk_size);
+        }
+        test_chunked(CONTENT.size());
+        test_invalid();
+        test_boundary_param();
+    } catch (const std::exception& e) {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
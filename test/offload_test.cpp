@@ -0,0 +1,234 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   offload_test.cpp
+ * Author: agent
+ *
+ * Created on October 19, 2026, 2:17 AM
+ */
+
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+
+#include "asio.hpp"
+
+#include "staticlib/httpserver/http_filter_chain.hpp"
+#include "staticlib/httpserver/http_response_writer.hpp"
+#include "staticlib/httpserver/http_server.hpp"
+#include "staticlib/httpserver/httpserver_exception.hpp"
+#include "staticlib/httpserver/scheduler.hpp"
+
+#include "test_client.hpp"
+
+namespace sh = staticlib::httpserver;
+namespace tc = test_client;
+
+const uint16_t TCP_PORT = 8084;
+const std::size_t TASKS_COUNT = 100;
+const std::size_t POST_THREADS = 8;
+const std::size_t BUSY_POLL_REQUESTS = 20;
+
+class latch {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool open = false;
+
+public:
+    void wait() {
+        std::unique_lock<std::mutex> guard{mutex};
+        cv.wait(guard, [this] { return open; });
+    }
+
+    void release() {
+        std::lock_guard<std::mutex> guard{mutex};
+        open = true;
+        cv.notify_all();
+    }
+};
+
+void test_external_fifo() {
+    sh::work_stealing_pool pool(1);
+    latch blocker;
+    std::vector<std::size_t> order;
+    // worker is busy while the tasks are queued
+    pool.post([&blocker] { blocker.wait(); });
+    for (std::size_t i = 0; i < TASKS_COUNT; i++) {
+        pool.post([&order, i] { order.push_back(i); });
+    }
+    blocker.release();
+    pool.shutdown();
+    tc::check(TASKS_COUNT == order.size(), "Posted tasks were not run");
+    for (std::size_t i = 0; i < TASKS_COUNT; i++) {
+        tc::check(i == order[i], "Tasks posted from outside are not run in FIFO order");
+    }
+}
+
+void test_local_lifo() {
+    sh::work_stealing_pool pool(1);
+    std::vector<std::size_t> order;
+    pool.post([&pool, &order] {
+        for (std::size_t i = 0; i < 3; i++) {
+            pool.post([&order, i] { order.push_back(i); });
+        }
+    });
+    pool.shutdown();
+    std::vector<std::size_t> expected = {2, 1, 0};
+    tc::check(expected == order, "Tasks posted by the worker are not run in LIFO order");
+}
+
+void test_post_after_shutdown() {
+    sh::work_stealing_pool pool(2);
+    std::atomic<std::size_t> count{0};
+    pool.post([&count] { count.fetch_add(1); });
+    pool.shutdown();
+    tc::check(1 == count.load() && pool.is_shut_down(), "Pool was not drained on shutdown");
+    bool rejected = false;
+    try {
+        pool.post([&count] { count.fetch_add(1); });
+    } catch (const sh::httpserver_exception&) {
+        rejected = true;
+    }
+    tc::check(rejected && !pool.is_running(), "Post after shutdown restarted the pool");
+    pool.startup();
+    pool.post([&count] { count.fetch_add(1); });
+    pool.shutdown();
+    tc::check(2 == count.load(), "Post after explicit restart was not run");
+}
+
+void test_concurrent_start() {
+    sh::work_stealing_pool pool(4);
+    std::atomic<std::size_t> count{0};
+    std::vector<std::thread> threads;
+    // pool is started by the first of the concurrent posts
+    for (std::size_t t = 0; t < POST_THREADS; t++) {
+        threads.emplace_back([&pool, &count] {
+            for (std::size_t i = 0; i < TASKS_COUNT; i++) {
+                pool.post([&count] { count.fetch_add(1); });
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+    pool.shutdown();
+    tc::check(POST_THREADS * TASKS_COUNT == count.load(), "Tasks lost on concurrent start");
+}
+
+void offloaded_hello(sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+    auto writer = sh::http_response_writer::create(conn, req);
+    writer->write("offloaded");
+    writer->send();
+}
+
+void test_server_restart() {
+    sh::http_server server(2, TCP_PORT);
+    server.add_offloaded_handler("GET", "/offloaded", offloaded_hello);
+    std::string req = "GET /offloaded HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n";
+    // worker pool is stopped with the server and started again with it
+    for (int i = 0; i < 2; i++) {
+        server.start();
+        auto resp = tc::request(TCP_PORT, req);
+        tc::check(200 == resp.status && "offloaded" == resp.body,
+                "Invalid offloaded response, run: " + std::to_string(i));
+        server.stop(true);
+    }
+}
+
+void test_lane_override() {
+    sh::http_server server(2, TCP_PORT);
+    uint32_t slow = server.add_priority_lane("slow", 1, 1);
+    server.add_offloaded_handler("GET", "/lanes", offloaded_hello, slow);
+    // filter may move the request back to the default lane
+    server.add_filter("GET", "/lanes", [](sh::http_request_ptr& req, sh::tcp_connection_ptr& conn,
+            sh::http_filter_chain& chain) {
+        if (!req->get_query("default").empty()) {
+            req->set_priority_lane(sh::priority_lanes::DEFAULT_LANE);
+        }
+        chain.do_filter(req, conn);
+    });
+    server.start();
+    auto& lanes = server.get_priority_lanes();
+    tc::request(TCP_PORT, "GET /lanes HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n");
+    tc::check(1 == lanes.get_stats(slow).dispatched && 0 == lanes.get_stats(sh::priority_lanes::DEFAULT_LANE).dispatched,
+            "Request is not run in the handler lane");
+    tc::request(TCP_PORT, "GET /lanes?default=1 HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n");
+    tc::check(1 == lanes.get_stats(slow).dispatched && 1 == lanes.get_stats(sh::priority_lanes::DEFAULT_LANE).dispatched,
+            "Default lane set by filter is ignored");
+    server.stop(true);
+}
+
+void hello(sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+    auto writer = sh::http_response_writer::create(conn, req);
+    writer->write("hello");
+    writer->send();
+}
+
+void test_busy_poll() {
+    sh::http_server server(2, TCP_PORT);
+    server.get_active_scheduler().set_busy_poll(std::chrono::microseconds(200));
+    server.get_active_scheduler().set_cpu_affinity({0});
+    // usually fails without 'CAP_NET_ADMIN', failure is ignored
+    server.set_socket_busy_poll(std::chrono::microseconds(50));
+    server.add_handler("GET", "/hello", hello);
+    server.start();
+    // threads find no handlers and block, requests wake them up
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    std::string req = "GET /hello HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    std::string batch;
+    for (std::size_t i = 0; i < BUSY_POLL_REQUESTS; i++) {
+        batch.append(req);
+    }
+    std::string data = tc::exchange(TCP_PORT, batch + "GET /hello HTTP/1.1\r\nHost: localhost\r\n"
+            "Connection: close\r\n\r\n");
+    std::size_t consumed = 0;
+    for (std::size_t i = 0; i <= BUSY_POLL_REQUESTS; i++) {
+        tc::response resp;
+        std::size_t len = tc::parse_response(data.substr(consumed), resp);
+        tc::check(len > 0 && "hello" == resp.body, "Invalid response in busy-poll mode, index: " + std::to_string(i));
+        consumed += len;
+    }
+    // idle threads stop spinning and block again
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    auto stats = server.get_active_scheduler().get_busy_poll_stats();
+    tc::check(stats.blocks_count > 0 && stats.spin_micros > 0, "Busy-poll counters are not updated");
+    tc::check(stats.spin_micros < 2 * 1000 * 1000, "IO threads spin while idle");
+    server.stop(true);
+}
+
+int main() {
+    try {
+        test_external_fifo();
+        test_local_lifo();
+        test_post_after_shutdown();
+        test_concurrent_start();
+        test_server_restart();
+        test_lane_override();
+        test_busy_poll();
+    } catch (const std::exception& e) {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,225 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   overload_test.cpp
+ * Author: agent
+ *
+ * Created on October 19, 2026, 2:21 AM
+ */
+
+#include <iostream>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <cstdint>
+
+#include "asio.hpp"
+
+#include "staticlib/httpserver/http_filter_chain.hpp"
+#include "staticlib/httpserver/http_response_writer.hpp"
+#include "staticlib/httpserver/http_server.hpp"
+
+#include "test_client.hpp"
+
+namespace sh = staticlib::httpserver;
+namespace tc = test_client;
+
+const uint16_t TCP_PORT = 8087;
+
+class latch {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool open = false;
+
+public:
+    void wait() {
+        std::unique_lock<std::mutex> guard{mutex};
+        cv.wait(guard, [this] { return open; });
+    }
+
+    void release() {
+        std::lock_guard<std::mutex> guard{mutex};
+        open = true;
+        cv.notify_all();
+    }
+};
+
+std::string strip_date(const std::string& data) {
+    auto begin = data.find("\r\nDate: ");
+    if (std::string::npos == begin) return data;
+    auto end = data.find("\r\n", begin + 2);
+    return data.substr(0, begin) + data.substr(end);
+}
+
+std::string canned(const std::string& status_line, const std::string& headers, const std::string& body) {
+    return status_line + "\r\nContent-Type: application/json\r\n" + headers + "Connection: close\r\n"
+            "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+}
+
+void test_overload_rejection() {
+    latch entered;
+    latch blocker;
+    sh::http_server server(2, TCP_PORT);
+    server.enable_overload_control(1, std::chrono::milliseconds(1000));
+    server.add_offloaded_handler("GET", "/slow", [&entered, &blocker](sh::http_request_ptr& req,
+            sh::tcp_connection_ptr& conn) {
+        entered.release();
+        blocker.wait();
+        auto writer = sh::http_response_writer::create(conn, req);
+        writer->write("done");
+        writer->send();
+    });
+    server.start();
+    std::string req = "GET /slow HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n";
+    tc::response first;
+    std::thread client([&first, &req] {
+        first = tc::request(TCP_PORT, req);
+    });
+    entered.wait();
+    // the only slot of the route is taken by the blocked request
+    std::string data = tc::exchange(TCP_PORT, "GET /slow HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    blocker.release();
+    client.join();
+    std::string expected = canned("HTTP/1.1 503 Service Unavailable", "Retry-After: 1\r\n", "{\n    \"code\": 503,\n"
+            "    \"message\": \"Service Unavailable\",\n"
+            "    \"description\": \"Server is overloaded, please retry the request later.\"\n}");
+    tc::check(expected == strip_date(data), "Invalid overload response: [" + data + "]");
+    tc::check(200 == first.status && "done" == first.body, "Admitted request failed");
+    tc::check(1 == server.get_overload_controller().get_rejected_count(), "Rejection is not counted");
+    tc::check(1 == server.get_route_limit("GET", "/slow").get_limit(), "Invalid route limit");
+    server.stop(true);
+}
+
+void hello(sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+    auto writer = sh::http_response_writer::create(conn, req);
+    writer->write("hello");
+    writer->send();
+}
+
+std::string limited(const std::string& client) {
+    return "GET /limited HTTP/1.1\r\nHost: localhost\r\nX-Client: " + client + "\r\nConnection: close\r\n\r\n";
+}
+
+void test_rate_limit() {
+    sh::http_server server(2, TCP_PORT);
+    server.add_handler("GET", "/limited", hello);
+    auto limiter = server.add_rate_limit("GET", "/limited", 4, 2, [](sh::http_request& req) {
+        return req.get_header("X-Client");
+    });
+    server.start();
+    // burst is spent, next request is over the limit
+    tc::check(200 == tc::request(TCP_PORT, limited("a")).status, "First request limited");
+    tc::check(200 == tc::request(TCP_PORT, limited("a")).status, "Request within burst limited");
+    std::string data = tc::exchange(TCP_PORT, limited("a"));
+    std::string expected = canned("HTTP/1.1 429 Too Many Requests", "Retry-After: 1\r\n", "{\n    \"code\": 429,\n"
+            "    \"message\": \"Too Many Requests\",\n"
+            "    \"description\": \"Request rate limit exceeded, please retry the request later.\"\n}");
+    tc::check(expected == strip_date(data), "Invalid rate limit response: [" + data + "]");
+    // clients have separate buckets
+    tc::check(200 == tc::request(TCP_PORT, limited("b")).status, "Other client limited");
+    // one token is added in 250 milliseconds
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    tc::check(200 == tc::request(TCP_PORT, limited("a")).status, "Bucket is not refilled");
+    tc::check(429 == tc::request(TCP_PORT, limited("a")).status, "Bucket is refilled above the rate");
+    tc::check(2 == limiter->get_keys_count(), "Invalid number of buckets");
+    server.stop(true);
+}
+
+void test_connections_per_ip() {
+    sh::http_server server(2, TCP_PORT);
+    server.add_handler("GET", "/hello", hello);
+    server.set_max_connections_per_ip(1);
+    server.start();
+    std::string req = "GET /hello HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    asio::io_service io;
+    asio::ip::tcp::socket first{io};
+    first.connect(tc::endpoint(TCP_PORT));
+    // slot is held while the keep-alive connection is open
+    asio::write(first, asio::buffer(req));
+    tc::response resp;
+    std::string data;
+    std::array<char, 4096> buf;
+    while (0 == tc::parse_response(data, resp)) {
+        std::size_t len = first.read_some(asio::buffer(buf));
+        data.append(buf.data(), len);
+    }
+    tc::check("hello" == resp.body, "Invalid response on the first connection");
+    tc::check(tc::exchange(TCP_PORT, req).empty(), "Connection over the limit is not closed");
+    first.close();
+    // slot is released asynchronously after the close
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    auto next = tc::request(TCP_PORT, "GET /hello HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n");
+    tc::check(200 == next.status, "Connection slot is not released");
+    server.stop(true);
+}
+
+void test_handler_deadline() {
+    latch finished;
+    std::atomic<bool> cancelled{false};
+    sh::http_server server(2, TCP_PORT);
+    server.add_offloaded_handler("GET", "/stuck", [&finished, &cancelled](sh::http_request_ptr& req,
+            sh::tcp_connection_ptr& conn) {
+        while (!req->is_cancelled()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        cancelled.store(true);
+        // late response is discarded
+        auto writer = sh::http_response_writer::create(conn, req);
+        writer->write("late");
+        writer->send();
+        finished.release();
+    });
+    server.set_handler_deadline("GET", "/stuck", std::chrono::milliseconds(200));
+    server.add_handler("GET", "/filtered", hello);
+    server.add_filter("GET", "/filtered", [](sh::http_request_ptr& req, sh::tcp_connection_ptr& conn,
+            sh::http_filter_chain& chain) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(400));
+        chain.do_filter(req, conn);
+    });
+    server.set_handler_deadline("GET", "/filtered", std::chrono::milliseconds(200));
+    server.start();
+    std::string expected = canned("HTTP/1.1 504 Gateway Timeout", "", "{\n    \"code\": 504,\n"
+            "    \"message\": \"Gateway Timeout\",\n"
+            "    \"description\": \"Request handler did not respond in time.\"\n}");
+    // connection is shut down while the handler still holds it
+    std::string data = tc::exchange(TCP_PORT, "GET /stuck HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    tc::check(expected == strip_date(data), "Invalid deadline response: [" + data + "]");
+    finished.wait();
+    tc::check(cancelled.load(), "Handler is not cancelled");
+    // time spent in filters is counted
+    std::string filtered = tc::exchange(TCP_PORT, "GET /filtered HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    tc::check(expected == strip_date(filtered), "Filters are not counted: [" + filtered + "]");
+    server.stop(true);
+}
+
+int main() {
+    try {
+        test_overload_rejection();
+        test_rate_limit();
+        test_connections_per_ip();
+        test_handler_deadline();
+    } catch (const std::exception& e) {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -27,6 +27,7 @@
 #include <functional>
 #include <thread>
 #include <fstream>
+#include <vector>
 #include <chrono>
 #include <cstdint>
 
@@ -110,7 +111,6 @@ class FileSender : public std::enable_shared_from_this<FileSender> {
     sh::http_response_writer_ptr writer;
     std::ifstream stream;
     std::array<char, 8192> buf;
-    std::mutex mutex;
     
 public:
     FileSender(const std::string& filename, sh::http_response_writer_ptr writer) : 
@@ -120,12 +120,15 @@ public:
     }
     
     void send() {
-        asio::error_code ec{};
-        handle_write(ec, 0);
+        // send handlers are run serially with the posted ones, no locking is needed
+        auto self = shared_from_this();
+        writer->post([self](sh::http_response_writer&) {
+            asio::error_code ec{};
+            self->handle_write(ec, 0);
+        });
     }
     
     void handle_write(const asio::error_code& ec, std::size_t /* bytes_written */) {
-        std::lock_guard<std::mutex> lock{mutex};
         if (!ec) {
             stream.read(buf.data(), buf.size());
             writer->clear();
@@ -162,6 +165,15 @@ FileWriter file_upload_payload_handler_creator(sh::http_request_ptr& req) {
     return FileWriter{"uploaded.dat"};
 }
 
+FileWriter direct_upload_payload_handler_creator(sh::http_request_ptr& req) {
+    // content is read from socket directly into this buffer
+    auto buf = std::make_shared<std::vector<char>>(1 << 20);
+    req->set_payload_buffers_provider([buf](std::size_t, std::vector<asio::mutable_buffer>& buffers) {
+        buffers.push_back(asio::buffer(*buf));
+    });
+    return FileWriter{"uploaded.dat"};
+}
+
 void logging_filter1(sh::http_request_ptr& request, sh::tcp_connection_ptr& conn, 
         sh::http_filter_chain& chain) {
     std::cout << "Hi from filter 1 for [" << request->get_resource() << "]" << std::endl;
@@ -196,6 +208,8 @@ void test_pion() {
     server.add_handler("POST", "/fu", file_upload_resource);
     server.add_payload_handler("POST", "/fu", file_upload_payload_handler_creator);
     server.add_handler("POST", "/fu1", file_upload_resource);
+    server.add_handler("POST", "/fu2", file_upload_resource);
+    server.add_payload_handler("POST", "/fu2", direct_upload_payload_handler_creator);
     server.start();
     std::this_thread::sleep_for(std::chrono::seconds{SECONDS_TO_RUN});
     server.stop(true);
@@ -0,0 +1,258 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   response_test.cpp
+ * Author: agent
+ *
+ * Created on October 19, 2026, 1:08 AM
+ */
+
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "asio.hpp"
+
+#include "staticlib/httpserver/algorithm.hpp"
+#include "staticlib/httpserver/http_common_headers.hpp"
+#include "staticlib/httpserver/http_response_writer.hpp"
+#include "staticlib/httpserver/http_server.hpp"
+
+#include "test_client.hpp"
+
+namespace sh = staticlib::httpserver;
+namespace tc = test_client;
+
+const uint16_t TCP_PORT = 8082;
+const std::string DATA_FILE = "response_test_data.dat";
+const std::size_t FILE_SIZE = 3 * 1024 * 1024 + 5;
+const std::size_t FILE_OFFSET = 17;
+const std::size_t SERIALIZED_HEADERS = 60;
+const std::size_t SERIALIZED_PIECES = 300;
+
+std::string make_data(std::size_t size) {
+    std::string res;
+    res.reserve(size);
+    for (std::size_t i = 0; i < size; i++) {
+        res.push_back(static_cast<char>(i * 13 % 253));
+    }
+    return res;
+}
+
+void test_file_region() {
+    std::string data = make_data(FILE_SIZE);
+    {
+        std::ofstream out{DATA_FILE, std::ios::out | std::ios::binary};
+        out.write(data.data(), data.size());
+    }
+    int fd = ::open(DATA_FILE.c_str(), O_RDONLY);
+    tc::check(-1 != fd, "Cannot open data file");
+    sh::http_server server(2, TCP_PORT);
+    server.add_handler("GET", "/file", [fd](sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+        auto writer = sh::http_response_writer::create(conn, req);
+        writer->write("head|");
+        writer->write_file(fd, FILE_OFFSET, FILE_SIZE - FILE_OFFSET);
+        writer->write("|tail");
+        writer->send();
+    });
+    server.start();
+    for (int i = 0; i < 3; i++) {
+        auto resp = tc::request(TCP_PORT, "GET /file HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n");
+        tc::check(200 == resp.status, "Invalid file response status");
+        tc::check("head|" + data.substr(FILE_OFFSET) + "|tail" == resp.body, "File response mismatch");
+    }
+    server.stop(true);
+    ::close(fd);
+    std::remove(DATA_FILE.c_str());
+}
+
+void hello(sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+    auto writer = sh::http_response_writer::create(conn, req);
+    writer->write("hello");
+    writer->send();
+}
+
+const std::vector<std::string>& pieces() {
+    static std::vector<std::string> res = [] {
+        std::vector<std::string> vec;
+        for (std::size_t i = 0; i < SERIALIZED_PIECES; i++) {
+            vec.push_back("piece" + std::to_string(i) + ";");
+        }
+        return vec;
+    }();
+    return res;
+}
+
+void many_headers(sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+    auto writer = sh::http_response_writer::create(conn, req);
+    writer->get_response().set_status_code(201);
+    writer->get_response().set_status_message("Created");
+    for (std::size_t i = 0; i < SERIALIZED_HEADERS; i++) {
+        writer->get_response().add_header("X-Header-" + std::to_string(i), std::string(i * 10, 'v'));
+    }
+    // more buffers than a single gathered write accepts
+    for (auto& piece : pieces()) {
+        writer->write_no_copy(piece);
+    }
+    writer->send();
+}
+
+void test_serialization() {
+    sh::http_server server(2, TCP_PORT);
+    server.add_handler("GET", "/headers", many_headers);
+    server.start();
+    std::string expected_body;
+    for (auto& piece : pieces()) {
+        expected_body.append(piece);
+    }
+    // two responses on one keep-alive connection must be framed exactly
+    std::string req = "GET /headers HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    std::string data = tc::exchange(TCP_PORT, req + req.substr(0, req.length() - 2) + "Connection: close\r\n\r\n");
+    std::size_t consumed = 0;
+    for (int i = 0; i < 2; i++) {
+        tc::response resp;
+        std::size_t len = tc::parse_response(data.substr(consumed), resp);
+        tc::check(len > 0, "Incomplete serialized response");
+        consumed += len;
+        tc::check("HTTP/1.1 201 Created" == resp.status_line, "Invalid status line: [" + resp.status_line + "]");
+        for (std::size_t j = 0; j < SERIALIZED_HEADERS; j++) {
+            tc::check(std::string(j * 10, 'v') == resp.headers["x-header-" + std::to_string(j)],
+                    "Invalid serialized header: " + std::to_string(j));
+        }
+        tc::check(std::to_string(expected_body.size()) == resp.headers["content-length"], "Invalid Content-Length");
+        tc::check(expected_body == resp.body, "Invalid serialized body");
+    }
+    tc::check(consumed == data.size(), "Unexpected data after responses");
+    server.stop(true);
+}
+
+std::time_t parse_http_date(const std::string& date) {
+    std::tm tm = std::tm();
+    char month[4] = {};
+    char wday[4] = {};
+    tc::check(7 == std::sscanf(date.c_str(), "%3s, %2d %3s %4d %2d:%2d:%2d GMT", wday, &tm.tm_mday, month,
+            &tm.tm_year, &tm.tm_hour, &tm.tm_min, &tm.tm_sec), "Invalid Date header: [" + date + "]");
+    std::string months = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    auto pos = months.find(month);
+    tc::check(std::string::npos != pos && 0 == pos % 3, "Invalid month in Date header: [" + date + "]");
+    tm.tm_mon = static_cast<int>(pos / 3);
+    tm.tm_year -= 1900;
+    return timegm(&tm);
+}
+
+void test_common_headers() {
+    sh::http_server server(2, TCP_PORT);
+    server.add_common_header("X-Common", "common value");
+    server.add_handler("GET", "/hello", hello);
+    server.start();
+    std::string req = "GET /hello HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n";
+    auto first = tc::request(TCP_PORT, req);
+    tc::check("common value" == first.headers["x-common"], "Common header not sent");
+    std::time_t first_date = parse_http_date(first.headers["date"]);
+    std::time_t now = std::time(nullptr);
+    tc::check(first_date <= now && first_date >= now - 2, "Stale Date header: [" + first.headers["date"] + "]");
+    // block is re-rendered every second
+    std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+    auto second = tc::request(TCP_PORT, req);
+    tc::check(parse_http_date(second.headers["date"]) > first_date, "Date header is not updated");
+    tc::check("common value" == second.headers["x-common"], "Common header lost on update");
+    server.stop(true);
+}
+
+void test_common_headers_update() {
+    sh::http_common_headers headers;
+    headers.add_header("X-Common", "common value");
+    std::atomic<bool> stop{false};
+    std::atomic<std::size_t> torn{0};
+    std::vector<std::thread> readers;
+    for (std::size_t i = 0; i < 4; i++) {
+        readers.emplace_back([&headers, &stop, &torn] {
+            std::string block;
+            while (!stop.load()) {
+                block.clear();
+                headers.append_to(block);
+                // every field of the date changes on update, mixed copy is never rendered back
+                std::string expected = "Date: ";
+                try {
+                    sh::algorithm::append_http_date(expected, parse_http_date(block.substr(6, 29)));
+                } catch (const std::exception&) {
+                    // not parsed, fails the comparison below
+                }
+                expected.append("\r\nX-Common: common value\r\n");
+                if (expected != block) torn.fetch_add(1);
+            }
+        });
+    }
+    std::time_t start = std::time(nullptr);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(500);
+    for (std::time_t i = 1; std::chrono::steady_clock::now() < deadline; i++) {
+        headers.update(start + (i % 100000) * 90061);
+    }
+    stop.store(true);
+    for (auto& th : readers) {
+        th.join();
+    }
+    tc::check(0 == torn.load(), "Torn common headers block read: " + std::to_string(torn.load()));
+}
+
+void test_canned_version() {
+    sh::http_server server(2, TCP_PORT);
+    server.start();
+    std::string expected_body = "{\n    \"code\": 404,\n    \"message\": \"Not Found\",\n"
+            "    \"description\": \"The requested URL: [/missing] was not found on this server.\"\n}";
+    // canned responses answer with the version of the request
+    for (const std::string version : {"1.0", "1.1"}) {
+        auto resp = tc::request(TCP_PORT, "GET /missing HTTP/" + version + "\r\nHost: localhost\r\n"
+                "Connection: close\r\n\r\n");
+        tc::check("HTTP/" + version + " 404 Not Found" == resp.status_line,
+                "Invalid canned status line: [" + resp.status_line + "]");
+        tc::check("close" == resp.headers["connection"], "Invalid canned Connection header");
+        tc::check("application/json" == resp.headers["content-type"], "Invalid canned Content-Type");
+        tc::check(std::to_string(expected_body.size()) == resp.headers["content-length"] &&
+                expected_body == resp.body, "Invalid canned body: [" + resp.body + "]");
+    }
+    // HTTP/1.0 connection is closed even if the client does not ask for it
+    auto plain = tc::request(TCP_PORT, "GET /missing HTTP/1.0\r\n\r\n");
+    tc::check("HTTP/1.0 404 Not Found" == plain.status_line && "close" == plain.headers["connection"],
+            "Invalid HTTP/1.0 canned response");
+    server.stop(true);
+}
+
+int main() {
+    try {
+        test_file_region();
+        test_serialization();
+        test_common_headers();
+        test_common_headers_update();
+        test_canned_version();
+    } catch (const std::exception& e) {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
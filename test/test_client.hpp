@@ -0,0 +1,151 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   test_client.hpp
+ * Author: agent
+ *
+ * Created on October 19, 2026, 1:07 AM
+ */
+
+#ifndef STATICLIB_HTTPSERVER_TEST_CLIENT_HPP
+#define	STATICLIB_HTTPSERVER_TEST_CLIENT_HPP
+
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+#include "asio.hpp"
+
+namespace test_client {
+
+/**
+ * Parsed HTTP response
+ */
+struct response {
+    int status = 0;
+    std::string status_line;
+    // keys are lower-cased
+    std::map<std::string, std::string> headers;
+    // de-chunked body
+    std::string body;
+    bool chunked = false;
+};
+
+inline void check(bool condition, const std::string& msg) {
+    if (!condition) throw std::runtime_error(msg);
+}
+
+inline std::string to_lower(std::string str) {
+    for (char& ch : str) {
+        ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+    }
+    return str;
+}
+
+inline asio::ip::tcp::endpoint endpoint(uint16_t port) {
+    return asio::ip::tcp::endpoint(asio::ip::address_v4::loopback(), port);
+}
+
+/**
+ * Reads from the socket until the server closes the connection
+ */
+inline std::string read_all(asio::ip::tcp::socket& socket) {
+    std::string res;
+    std::array<char, 8192> buf;
+    asio::error_code ec;
+    for (;;) {
+        std::size_t len = socket.read_some(asio::buffer(buf), ec);
+        res.append(buf.data(), len);
+        if (ec) break;
+    }
+    return res;
+}
+
+/**
+ * Sends the raw request and returns all the bytes received before
+ * the server closed the connection
+ */
+inline std::string exchange(uint16_t port, const std::string& request) {
+    asio::io_service io_service;
+    asio::ip::tcp::socket socket(io_service);
+    socket.connect(endpoint(port));
+    asio::write(socket, asio::buffer(request));
+    return read_all(socket);
+}
+
+/**
+ * Parses a single response from the start of the data, returns
+ * the number of bytes consumed or 0 if the response is incomplete
+ */
+inline std::size_t parse_response(const std::string& data, response& resp) {
+    auto head_end = data.find("\r\n\r\n");
+    if (std::string::npos == head_end) return 0;
+    resp = response();
+    auto line_end = data.find("\r\n");
+    resp.status_line = data.substr(0, line_end);
+    check(0 == resp.status_line.compare(0, 5, "HTTP/") && resp.status_line.length() >= 12,
+            "Invalid status line: [" + resp.status_line + "]");
+    resp.status = std::atoi(resp.status_line.c_str() + 9);
+    std::size_t pos = line_end + 2;
+    while (pos < head_end) {
+        auto eol = data.find("\r\n", pos);
+        auto colon = data.find(':', pos);
+        check(colon < eol, "Invalid header line");
+        auto value_start = data.find_first_not_of(' ', colon + 1);
+        resp.headers[to_lower(data.substr(pos, colon - pos))] = data.substr(value_start, eol - value_start);
+        pos = eol + 2;
+    }
+    pos = head_end + 4;
+    auto te = resp.headers.find("transfer-encoding");
+    if (resp.headers.end() != te && "chunked" == to_lower(te->second)) {
+        resp.chunked = true;
+        for (;;) {
+            auto size_end = data.find("\r\n", pos);
+            if (std::string::npos == size_end) return 0;
+            std::size_t size = std::strtoul(data.substr(pos, size_end - pos).c_str(), nullptr, 16);
+            if (data.length() < size_end + 2 + size + 2) return 0;
+            check(0 == data.compare(size_end + 2 + size, 2, "\r\n"), "Invalid chunk framing");
+            resp.body.append(data, size_end + 2, size);
+            pos = size_end + 2 + size + 2;
+            if (0 == size) return pos;
+        }
+    }
+    auto cl = resp.headers.find("content-length");
+    std::size_t len = resp.headers.end() != cl ? std::strtoul(cl->second.c_str(), nullptr, 10) :
+            data.length() - pos;
+    if (data.length() < pos + len) return 0;
+    resp.body = data.substr(pos, len);
+    return pos + len;
+}
+
+/**
+ * Sends the raw request and parses the single response received
+ */
+inline response request(uint16_t port, const std::string& request) {
+    std::string data = exchange(port, request);
+    response resp;
+    check(0 != parse_response(data, resp), "Incomplete response: [" + data + "]");
+    return resp;
+}
+
+} // namespace
+
+#endif	/* STATICLIB_HTTPSERVER_TEST_CLIENT_HPP */
@@ -0,0 +1,145 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   upload_test.cpp
+ * Author: agent
+ *
+ * Created on October 19, 2026, 1:07 AM
+ */
+
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstdio>
+
+#include "asio.hpp"
+
+#include "staticlib/httpserver/http_file_sink.hpp"
+#include "staticlib/httpserver/http_response_writer.hpp"
+#include "staticlib/httpserver/http_server.hpp"
+
+#include "test_client.hpp"
+
+namespace sh = staticlib::httpserver;
+namespace tc = test_client;
+
+const uint16_t TCP_PORT = 8081;
+const std::size_t DIRECT_BUFFER_SIZE = 64 * 1024;
+const std::size_t BODY_SIZE = 2 * 1024 * 1024 + 13;
+const std::string SINK_FILE = "upload_test_sink.dat";
+
+std::string make_body(std::size_t size) {
+    std::string res;
+    res.reserve(size);
+    for (std::size_t i = 0; i < size; i++) {
+        res.push_back(static_cast<char>(i * 7 % 251));
+    }
+    return res;
+}
+
+void reply_ok(sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+    auto writer = sh::http_response_writer::create(conn, req);
+    writer->write("ok");
+    writer->send();
+}
+
+struct received_payload {
+    std::vector<char> buffer = std::vector<char>(DIRECT_BUFFER_SIZE);
+    std::string data;
+    std::size_t direct_bytes = 0;
+};
+
+void test_direct_buffers() {
+    auto received = std::make_shared<received_payload>();
+    sh::http_server server(2, TCP_PORT);
+    server.add_handler("POST", "/direct", reply_ok);
+    server.add_payload_handler("POST", "/direct", [received](sh::http_request_ptr& req) {
+        req->set_payload_buffers_provider([received](std::size_t, std::vector<asio::mutable_buffer>& buffers) {
+            buffers.push_back(asio::buffer(received->buffer));
+        });
+        return [received](const char* data, std::size_t len) {
+            const char* begin = received->buffer.data();
+            if (data >= begin && data + len <= begin + received->buffer.size()) {
+                received->direct_bytes += len;
+            }
+            received->data.append(data, len);
+        };
+    });
+    server.add_handler("GET", "/next", reply_ok);
+    server.start();
+    // the next request follows the body immediately and must not land in the user buffer
+    std::string body = make_body(BODY_SIZE);
+    std::string data = tc::exchange(TCP_PORT, "POST /direct HTTP/1.1\r\nHost: localhost\r\n"
+            "Content-Length: " + std::to_string(body.length()) + "\r\n\r\n" + body +
+            "GET /next HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n");
+    server.stop(true);
+    tc::response first;
+    std::size_t consumed = tc::parse_response(data, first);
+    tc::check(0 != consumed && 200 == first.status && "ok" == first.body, "Invalid upload response");
+    tc::response second;
+    tc::check(0 != tc::parse_response(data.substr(consumed), second) && 200 == second.status,
+            "Invalid pipelined response after upload");
+    tc::check(body == received->data, "Uploaded payload mismatch");
+    tc::check(received->direct_bytes > 0, "Payload was not read into user buffers");
+}
+
+std::string read_file(const std::string& path) {
+    std::ifstream stream{path, std::ios::in | std::ios::binary};
+    return std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+}
+
+void test_file_sink() {
+    sh::http_server server(2, TCP_PORT);
+    server.add_handler("POST", "/sink", [](sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+        // file must be complete before the response is sent
+        auto sink = req->get_payload_handler<sh::http_file_sink>();
+        if (sink) sink->close();
+        auto writer = sh::http_response_writer::create(conn, req);
+        writer->write(sink ? "closed" : "no sink");
+        writer->send();
+    });
+    server.add_payload_handler("POST", "/sink", [](sh::http_request_ptr&) {
+        return sh::http_file_sink{SINK_FILE};
+    });
+    server.start();
+    for (std::size_t size : {std::size_t(0), std::size_t(1), std::size_t(100), BODY_SIZE}) {
+        std::string body = make_body(size);
+        // part of the body arrives with the headers and goes through the connection buffer
+        auto resp = tc::request(TCP_PORT, "POST /sink HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n"
+                "Content-Length: " + std::to_string(body.length()) + "\r\n\r\n" + body);
+        std::string sz = " (size: " + std::to_string(size) + ")";
+        tc::check(200 == resp.status && "closed" == resp.body, "Invalid sink response" + sz);
+        tc::check(body == read_file(SINK_FILE), "Sink file mismatch" + sz);
+    }
+    server.stop(true);
+    std::remove(SINK_FILE.c_str());
+}
+
+int main() {
+    try {
+        test_direct_buffers();
+        test_file_sink();
+    } catch (const std::exception& e) {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
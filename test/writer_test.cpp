@@ -0,0 +1,384 @@
+/*
+ * Copyright 2015, alex at staticlibs.net
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * File:   writer_test.cpp
+ * Author: agent
+ *
+ * Created on October 19, 2026, 1:47 AM
+ */
+
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "asio.hpp"
+
+#include "staticlib/httpserver/http_response_writer.hpp"
+#include "staticlib/httpserver/http_server.hpp"
+
+#include "test_client.hpp"
+
+namespace sh = staticlib::httpserver;
+namespace tc = test_client;
+
+const uint16_t TCP_PORT = 8086;
+const std::size_t BODY_SIZE = 1024 * 1024 + 3;
+const std::size_t HIGH_WATERMARK = 10000;
+const std::size_t LOW_WATERMARK = 3000;
+const std::string DATA_FILE = "writer_test_data.dat";
+const std::size_t FILE_SIZE = 300 * 1024 + 7;
+const std::size_t QUEUED_CHUNKS = 40;
+const std::size_t POST_THREADS = 4;
+const std::size_t POSTS_PER_THREAD = 50;
+
+std::string make_data(std::size_t size, std::size_t seed) {
+    std::string res;
+    res.reserve(size);
+    for (std::size_t i = 0; i < size; i++) {
+        res.push_back(static_cast<char>((i + seed) * 31 % 256));
+    }
+    return res;
+}
+
+const std::string& no_copy_data() {
+    static std::string res = make_data(10000, 1);
+    return res;
+}
+
+std::shared_ptr<const std::string> shared_data() {
+    static auto res = std::make_shared<const std::string>(make_data(7000, 2));
+    return res;
+}
+
+std::string expected_mixed() {
+    return "small|" + make_data(5000, 3) + no_copy_data() + "|" + *shared_data() +
+            make_data(300, 4) + std::string("bin\0ary", 7) + "|" + *shared_data() + "end";
+}
+
+void mixed_writes(sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+    auto writer = sh::http_response_writer::create(conn, req);
+    // inline copies, slabs larger than a single slab, borrowed and shared pieces
+    writer->write("small|");
+    writer->write(make_data(5000, 3));
+    writer->write_no_copy(no_copy_data());
+    writer->write("|");
+    writer->write_shared(shared_data());
+    writer->write_move(make_data(300, 4));
+    writer->write("bin\0ary", 7);
+    writer->write("|");
+    writer->write_shared(shared_data());
+    writer->write("end");
+    writer->send();
+}
+
+void test_buffer_chain() {
+    sh::http_server server(2, TCP_PORT);
+    server.add_handler("GET", "/mixed", mixed_writes);
+    server.start();
+    std::string expected = expected_mixed();
+    // shared data is sent to several clients, pooled slabs are reused
+    for (int i = 0; i < 3; i++) {
+        auto resp = tc::request(TCP_PORT, "GET /mixed HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n");
+        tc::check(200 == resp.status, "Invalid mixed response status");
+        tc::check(std::to_string(expected.size()) == resp.headers["content-length"], "Invalid mixed Content-Length");
+        tc::check(expected == resp.body, "Mixed writes body mismatch");
+    }
+    server.stop(true);
+}
+
+template<typename Out>
+void write_formatted(Out& out) {
+    // same sequence is written to the writer and to the reference stream
+    out << "ints:" << 0 << ' ' << 7 << ' ' << -42 << ' ' << (std::numeric_limits<int>::min)() << ' ' <<
+            (std::numeric_limits<long long>::min)() << ' ' << (std::numeric_limits<unsigned long long>::max)() <<
+            ' ' << static_cast<short>(-1234) << ' ' << static_cast<unsigned short>(65535) << ' ' << 100000L <<
+            ' ' << 4000000000UL;
+    out << "|floats:" << 0.0 << ' ' << -3.5 << ' ' << 0.1 << ' ' << (1.0 / 3) << ' ' << 1e20 << ' ' <<
+            1.5e-7 << ' ' << 123456.0 << ' ' << 1234567.0 << ' ' << 2.5f << ' ' <<
+            (std::numeric_limits<double>::max)();
+    out << "|chars:" << 'x' << static_cast<signed char>('y') << static_cast<unsigned char>('z') << true << false;
+    out << "|hex:" << std::hex << 255 << ' ' << -1 << ' ' << 3054UL << std::dec << ' ' << 255;
+    out << "|bool:" << std::boolalpha << true << ' ' << false << std::noboolalpha << ' ' << true;
+    out << "|after:" << -17 << ' ' << 2.25 << std::endl;
+}
+
+void formatted(sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+    auto writer = sh::http_response_writer::create(conn, req);
+    write_formatted(writer);
+    writer->send();
+}
+
+void test_formatting() {
+    sh::http_server server(2, TCP_PORT);
+    server.add_handler("GET", "/formatted", formatted);
+    server.start();
+    std::ostringstream expected;
+    write_formatted(expected);
+    auto resp = tc::request(TCP_PORT, "GET /formatted HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n");
+    tc::check(expected.str() == resp.body, "Formatted output mismatch, expected: [" + expected.str() +
+            "], actual: [" + resp.body + "]");
+    server.stop(true);
+}
+
+void chunks(sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+    auto writer = sh::http_response_writer::create(conn, req);
+    writer->write("abc");
+    writer->send_chunk([writer](const asio::error_code& ec, std::size_t) {
+        if (ec) return;
+        writer->clear();
+        writer->write(make_data(4101, 5));
+        writer->send_chunk([writer](const asio::error_code& ec, std::size_t) {
+            if (ec) return;
+            writer->clear();
+            // empty chunk must not terminate the body
+            writer->send_chunk([writer](const asio::error_code& ec, std::size_t) {
+                if (ec) return;
+                writer->clear();
+                writer->write("tail");
+                writer->send_final_chunk();
+            });
+        });
+    });
+}
+
+void test_chunk_framing() {
+    sh::http_server server(2, TCP_PORT);
+    server.add_handler("GET", "/chunks", chunks);
+    server.start();
+    std::string data = tc::exchange(TCP_PORT, "GET /chunks HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n");
+    auto head_end = data.find("\r\n\r\n");
+    tc::check(std::string::npos != head_end, "Incomplete chunked response");
+    std::string head = data.substr(0, head_end + 4);
+    tc::check(std::string::npos != head.find("Transfer-Encoding: chunked\r\n") &&
+            std::string::npos == head.find("Content-Length"), "Invalid chunked response head: [" + head + "]");
+    std::string expected = "3\r\nabc\r\n1005\r\n" + make_data(4101, 5) + "\r\n4\r\ntail\r\n0\r\n\r\n";
+    tc::check(expected == data.substr(head_end + 4), "Invalid chunk framing");
+    // HTTP/1.0 client gets the same content without chunking
+    auto plain = tc::request(TCP_PORT, "GET /chunks HTTP/1.0\r\n\r\n");
+    tc::check(!plain.chunked && "abc" + make_data(4101, 5) + "tail" == plain.body, "Invalid HTTP/1.0 chunks body");
+    server.stop(true);
+}
+
+class body_source {
+    std::shared_ptr<std::string> data;
+    std::shared_ptr<std::size_t> pos;
+    std::shared_ptr<std::atomic<std::size_t>> max_request;
+    std::size_t fail_at;
+
+public:
+    body_source(std::shared_ptr<std::atomic<std::size_t>> max_request, std::size_t fail_at) :
+    data(std::make_shared<std::string>(make_data(BODY_SIZE, 6))),
+    pos(std::make_shared<std::size_t>(0)),
+    max_request(std::move(max_request)),
+    fail_at(fail_at) { }
+
+    std::size_t operator()(char* buf, std::size_t len) {
+        if (*pos >= fail_at) throw std::runtime_error("source failure");
+        if (len > max_request->load()) max_request->store(len);
+        // source returns less than requested, as a file or a pipe would
+        std::size_t count = (std::min)((std::min)(len, static_cast<std::size_t>(777)), data->size() - *pos);
+        std::memcpy(buf, data->data() + *pos, count);
+        *pos += count;
+        return count;
+    }
+};
+
+void test_send_body() {
+    auto max_request = std::make_shared<std::atomic<std::size_t>>(0);
+    sh::http_server server(2, TCP_PORT);
+    server.add_handler("GET", "/body", [max_request](sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+        std::size_t fail_at = req->get_query("fail").empty() ? std::string::npos :
+                static_cast<std::size_t>(std::stoul(req->get_query("fail")));
+        auto writer = sh::http_response_writer::create(conn, req);
+        writer->send_body(body_source(max_request, fail_at), HIGH_WATERMARK, LOW_WATERMARK);
+    });
+    server.start();
+    std::string expected = make_data(BODY_SIZE, 6);
+    auto chunked = tc::request(TCP_PORT, "GET /body HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n");
+    tc::check(chunked.chunked && expected == chunked.body, "Streamed chunked body mismatch");
+    tc::check(max_request->load() > 0 && max_request->load() <= HIGH_WATERMARK,
+            "Source pulled over the high watermark: " + std::to_string(max_request->load()));
+    auto plain = tc::request(TCP_PORT, "GET /body HTTP/1.0\r\n\r\n");
+    tc::check(!plain.chunked && expected == plain.body, "Streamed HTTP/1.0 body mismatch");
+    // error on the first pull is reported to the handler
+    auto first = tc::request(TCP_PORT, "GET /body?fail=0 HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n");
+    tc::check(500 == first.status, "Invalid first pull error status: " + std::to_string(first.status));
+    // error in the middle of the body breaks the connection
+    std::string broken = tc::exchange(TCP_PORT, "GET /body?fail=100000 HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    tc::response resp;
+    tc::check(0 == tc::parse_response(broken, resp) && broken.size() < expected.size(),
+            "Broken body was terminated normally");
+    server.stop(true);
+}
+
+struct queued_results {
+    std::vector<std::size_t> sent;
+    bool failed = false;
+};
+
+void queued_chunks(int fd, std::shared_ptr<queued_results> results, sh::http_request_ptr& req,
+        sh::tcp_connection_ptr& conn) {
+    auto writer = sh::http_response_writer::create(conn, req);
+    // all chunks are sent without waiting for the previous writes
+    auto handler = [results](const asio::error_code& ec, std::size_t len) {
+        if (ec) results->failed = true;
+        results->sent.push_back(len);
+    };
+    for (std::size_t i = 0; i < QUEUED_CHUNKS; i++) {
+        writer->clear();
+        if (i == QUEUED_CHUNKS / 2) {
+            writer->write("file|");
+            writer->write_file(fd, 0, FILE_SIZE);
+            writer->write("|file");
+        } else if (0 == i % 3) {
+            writer->write_no_copy(no_copy_data());
+        } else if (1 == i % 3) {
+            writer->write_shared(shared_data());
+        } else {
+            writer->write("chunk" + std::to_string(i));
+        }
+        writer->send_chunk(handler);
+    }
+    writer->clear();
+    writer->write("last");
+    writer->send_final_chunk();
+}
+
+void test_queued_sends() {
+    std::string file_data = make_data(FILE_SIZE, 7);
+    {
+        std::ofstream out{DATA_FILE, std::ios::out | std::ios::binary};
+        out.write(file_data.data(), file_data.size());
+    }
+    int fd = ::open(DATA_FILE.c_str(), O_RDONLY);
+    tc::check(-1 != fd, "Cannot open data file");
+    auto results = std::make_shared<queued_results>();
+    sh::http_server server(2, TCP_PORT);
+    server.add_handler("GET", "/queued", [fd, results](sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+        queued_chunks(fd, results, req, conn);
+    });
+    server.start();
+    std::string expected;
+    std::vector<std::string> chunks;
+    for (std::size_t i = 0; i < QUEUED_CHUNKS; i++) {
+        if (i == QUEUED_CHUNKS / 2) {
+            chunks.push_back("file|" + file_data + "|file");
+        } else if (0 == i % 3) {
+            chunks.push_back(no_copy_data());
+        } else if (1 == i % 3) {
+            chunks.push_back(*shared_data());
+        } else {
+            chunks.push_back("chunk" + std::to_string(i));
+        }
+        expected.append(chunks.back());
+    }
+    expected.append("last");
+    auto resp = tc::request(TCP_PORT, "GET /queued HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n");
+    server.stop(true);
+    ::close(fd);
+    std::remove(DATA_FILE.c_str());
+    tc::check(resp.chunked && expected == resp.body, "Queued chunks body mismatch");
+    tc::check(!results->failed && QUEUED_CHUNKS == results->sent.size(), "Queued send handlers were not called");
+    // handlers are called in order, each with its own chunk length including framing
+    for (std::size_t i = 1; i < QUEUED_CHUNKS; i++) {
+        tc::check(results->sent[i] > chunks[i].size() && results->sent[i] <= chunks[i].size() + 16,
+                "Invalid queued send length, chunk: " + std::to_string(i));
+    }
+}
+
+void posted_chunks(std::shared_ptr<std::atomic<int>> overlaps, sh::http_request_ptr& req,
+        sh::tcp_connection_ptr& conn) {
+    auto writer = sh::http_response_writer::create(conn, req);
+    auto running = std::make_shared<std::atomic<int>>(0);
+    // handler returns right away, chunks are written from other threads
+    std::thread([writer, running, overlaps] {
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0; t < POST_THREADS; t++) {
+            threads.emplace_back([writer, running, overlaps, t] {
+                for (std::size_t i = 0; i < POSTS_PER_THREAD; i++) {
+                    writer->post([running, overlaps, t, i](sh::http_response_writer& wr) {
+                        if (running->fetch_add(1) > 0) overlaps->fetch_add(1);
+                        wr.clear();
+                        wr.write("[" + std::to_string(t) + ":" + std::to_string(i) + "]");
+                        wr.send_chunk([](const asio::error_code&, std::size_t) {});
+                        running->fetch_sub(1);
+                    });
+                }
+            });
+        }
+        for (auto& th : threads) {
+            th.join();
+        }
+        writer->post([](sh::http_response_writer& wr) {
+            wr.clear();
+            wr.send_final_chunk();
+        });
+    }).detach();
+}
+
+void test_cross_thread_post() {
+    auto overlaps = std::make_shared<std::atomic<int>>(0);
+    sh::http_server server(2, TCP_PORT);
+    server.add_handler("GET", "/posted", [overlaps](sh::http_request_ptr& req, sh::tcp_connection_ptr& conn) {
+        posted_chunks(overlaps, req, conn);
+    });
+    server.start();
+    auto resp = tc::request(TCP_PORT, "GET /posted HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n");
+    server.stop(true);
+    tc::check(resp.chunked, "Posted response is not chunked");
+    tc::check(0 == overlaps->load(), "Posted tasks were run concurrently");
+    // every chunk is sent once, tasks from the same thread keep their order
+    for (std::size_t t = 0; t < POST_THREADS; t++) {
+        std::size_t prev = 0;
+        for (std::size_t i = 0; i < POSTS_PER_THREAD; i++) {
+            std::string token = "[" + std::to_string(t) + ":" + std::to_string(i) + "]";
+            auto pos = resp.body.find(token);
+            tc::check(std::string::npos != pos && std::string::npos == resp.body.find(token, pos + 1),
+                    "Posted chunk is missing or duplicated: " + token);
+            tc::check(0 == i || pos > prev, "Posted chunks reordered: " + token);
+            prev = pos;
+        }
+    }
+}
+
+int main() {
+    try {
+        test_buffer_chain();
+        test_formatting();
+        test_chunk_framing();
+        test_send_body();
+        test_queued_sends();
+        test_cross_thread_post();
+    } catch (const std::exception& e) {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}